@@ -5,8 +5,9 @@
 #include "VulkanUtils.h"
 #include "Camera.h"
 
-my_vulkan::Arona::Arona(const std::string& name, my_vulkan::VulkanContext* context,const std::vector<std::string>& modelPaths, const std::vector<std::string>& texturePaths)
- : Object(name, context, modelPaths, texturePaths)
+my_vulkan::Arona::Arona(const std::string& name, my_vulkan::VulkanContext* context,const std::vector<std::string>& modelPaths, const std::vector<std::string>& texturePaths,
+	VertexFormat vertexFormat)
+ : Object(name, context, modelPaths, texturePaths, vertexFormat)
 {
 
 }
@@ -9,7 +9,7 @@ namespace my_vulkan
 	{
 	public:
 		Arona(const std::string& name, my_vulkan::VulkanContext* context, const std::vector<std::string>& modelPaths,
-			const std::vector<std::string>& texturePaths);
+			const std::vector<std::string>& texturePaths, VertexFormat vertexFormat = VertexFormat::FULL);
 		void tick(uint32_t currentImage, Camera* camera, PointLight* light) override;
 	};
 }
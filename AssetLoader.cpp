@@ -0,0 +1,59 @@
+#include "AssetLoader.h"
+
+#include "Model.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+my_vulkan::AssetLoader::AssetLoader(ThreadPool* threadPool) : threadPool(threadPool)
+{
+}
+
+void my_vulkan::AssetLoader::prefetch(const std::vector<std::string>& modelPaths, const std::vector<std::string>& texturePaths)
+{
+	for (const auto& path : texturePaths)
+		requestImage(path);
+	for (const auto& path : modelPaths)
+		requestMesh(path);
+}
+
+std::shared_future<std::shared_ptr<my_vulkan::ImageData>> my_vulkan::AssetLoader::requestImage(const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = images.find(filePath);
+	if (it != images.end())
+		return it->second;
+
+	auto future = threadPool->submit([filePath]() { return ImageData::load(filePath); }).share();
+	images.emplace(filePath, future);
+	return future;
+}
+
+std::shared_future<std::shared_ptr<my_vulkan::MeshData>> my_vulkan::AssetLoader::requestMesh(const std::string& modelPath)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = meshes.find(modelPath);
+	if (it != meshes.end())
+		return it->second;
+
+	auto future = threadPool->submit([modelPath, threadPool = threadPool]() { return MeshData::load(modelPath, threadPool); }).share();
+	meshes.emplace(modelPath, future);
+	return future;
+}
+
+std::shared_ptr<my_vulkan::ImageData> my_vulkan::AssetLoader::getImage(const std::string& filePath)
+{
+	auto future = requestImage(filePath);
+	auto image = future.get();
+	std::lock_guard<std::mutex> lock(mutex);
+	images.erase(filePath);
+	return image;
+}
+
+std::shared_ptr<my_vulkan::MeshData> my_vulkan::AssetLoader::getMesh(const std::string& modelPath)
+{
+	auto future = requestMesh(modelPath);
+	auto mesh = future.get();
+	std::lock_guard<std::mutex> lock(mutex);
+	meshes.erase(modelPath);
+	return mesh;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace my_vulkan
+{
+	class ThreadPool;
+	struct ImageData;
+	struct MeshData;
+
+	//Decodes images and parses meshes on the thread pool. Requests are keyed by path so a prefetched asset is
+	//only loaded once, the GPU upload stays on the caller's thread
+	class AssetLoader
+	{
+	public:
+		AssetLoader(ThreadPool* threadPool);
+
+		void prefetch(const std::vector<std::string>& modelPaths, const std::vector<std::string>& texturePaths);
+
+		std::shared_future<std::shared_ptr<ImageData>> requestImage(const std::string& filePath);
+		std::shared_future<std::shared_ptr<MeshData>> requestMesh(const std::string& modelPath);
+
+		//Waits for the asset and drops it from the loader, the caller keeps the only reference
+		std::shared_ptr<ImageData> getImage(const std::string& filePath);
+		std::shared_ptr<MeshData> getMesh(const std::string& modelPath);
+
+	private:
+		ThreadPool* threadPool;
+		std::mutex mutex;
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<ImageData>>> images;
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<MeshData>>> meshes;
+	};
+}
@@ -0,0 +1,597 @@
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include <glm/gtc/matrix_transform.hpp>
+//only the benchmarks still compare against tinyobj, models load through ObjParser
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+#include <stb_image.h>
+#include "Model.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "VertexWelder.h"
+#include "ThreadPool.h"
+#include "FrustumCuller.h"
+#include "VulkanUtils.h"
+#include "Vertex.h"
+
+namespace
+{
+	bool fail(const std::string& reason)
+	{
+		std::cout << "check failed : " << reason << std::endl;
+		return false;
+	}
+
+	//Peak resident memory of the process so far in bytes, it never goes down
+	size_t getPeakMemoryUsage()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		//kilobytes on linux
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+
+	//Writes a grid of side * side quads split into shapeCount shapes, every corner with its own position, texCoord and normal
+	void writeGridObj(const std::string& path, uint32_t side, uint32_t shapeCount)
+	{
+		std::ofstream out(path);
+		if (!out)
+			throw std::runtime_error("failed to write " + path);
+		for (uint32_t y = 0; y <= side; ++y)
+			for (uint32_t x = 0; x <= side; ++x)
+				out << "v " << x << ' ' << std::sin(x * 0.05f) * std::cos(y * 0.05f) << ' ' << y << '\n';
+		for (uint32_t y = 0; y <= side; ++y)
+			for (uint32_t x = 0; x <= side; ++x)
+				out << "vt " << x / float(side) << ' ' << y / float(side) << '\n';
+		for (uint32_t y = 0; y <= side; ++y)
+			for (uint32_t x = 0; x <= side; ++x)
+				out << "vn " << -std::cos(x * 0.05f) * 0.05f << " 1 " << std::sin(y * 0.05f) * 0.05f << '\n';
+		uint32_t rowsPerShape = (side + shapeCount - 1) / shapeCount;
+		for (uint32_t y = 0; y != side; ++y)
+		{
+			if (y % rowsPerShape == 0)
+				out << "o band" << y / rowsPerShape << '\n';
+			for (uint32_t x = 0; x != side; ++x)
+			{
+				//obj indices start at 1
+				uint32_t a = y * (side + 1) + x + 1, b = a + 1, c = a + side + 1, d = c + 1;
+				out << "f " << a << '/' << a << '/' << a << ' ' << b << '/' << b << '/' << b << ' ' << c << '/' << c << '/' << c << '\n';
+				out << "f " << b << '/' << b << '/' << b << ' ' << d << '/' << d << '/' << d << ' ' << c << '/' << c << '/' << c << '\n';
+			}
+		}
+	}
+
+	std::string getGridObj()
+	{
+		std::string path = "bench_grid.obj";
+		if (!std::ifstream(path))
+		{
+			std::cout << "writing " << path << std::endl;
+			writeGridObj(path, 1024, 16);
+		}
+		return path;
+	}
+
+	double computePsnr(const std::vector<uint8_t>& source, const std::vector<uint8_t>& decoded, int channels)
+	{
+		double error = 0.0;
+		for (size_t i = 0; i < source.size(); i += 4)
+			for (int c = 0; c != channels; ++c)
+				error += double(source[i + c] - decoded[i + c]) * double(source[i + c] - decoded[i + c]);
+		error /= double(source.size() / 4 * channels);
+		return error == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / error);
+	}
+
+	struct CullingCase
+	{
+		const char* name;
+		glm::vec3 center;
+		float radius;
+		bool visible;
+	};
+
+	//Spheres against the box |x|, |y|, |z| <= 10. Every distance is exact in float, so touching a plane at distance ==
+	//-radius lands on the boundary instead of either side of it
+	const CullingCase cullingCases[] = {
+		{ "inside", glm::vec3(1.0f, 2.0f, 3.0f), 1.0f, true },
+		{ "outside +x", glm::vec3(13.0f, 0.0f, 0.0f), 2.0f, false },
+		{ "outside -x", glm::vec3(-13.0f, 0.0f, 0.0f), 2.0f, false },
+		{ "outside +y", glm::vec3(0.0f, 13.0f, 0.0f), 2.0f, false },
+		{ "outside -y", glm::vec3(0.0f, -13.0f, 0.0f), 2.0f, false },
+		{ "outside +z", glm::vec3(0.0f, 0.0f, 13.0f), 2.0f, false },
+		{ "outside -z", glm::vec3(0.0f, 0.0f, -13.0f), 2.0f, false },
+		{ "straddling +x", glm::vec3(10.5f, 0.0f, 0.0f), 1.0f, true },
+		{ "straddling -y", glm::vec3(0.0f, -9.5f, 0.0f), 1.0f, true },
+		{ "touching -x", glm::vec3(-12.0f, 0.0f, 0.0f), 2.0f, true },
+		{ "touching +z", glm::vec3(0.0f, 0.0f, 12.0f), 2.0f, true },
+		{ "just past +z", glm::vec3(0.0f, 0.0f, 12.5f), 2.0f, false },
+	};
+
+	//Culls padding inside spheres followed by cases[first, end) with both paths and compares against the known answers
+	bool checkCullingCases(uint32_t padding, size_t first, size_t end)
+	{
+		//planes as VulkanUtils::extractFrustumPlanes returns them, dot(normal, p) + w >= 0 inside
+		const std::array<glm::vec4, 6> planes = { glm::vec4(1.0f, 0.0f, 0.0f, 10.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 10.0f),
+			glm::vec4(0.0f, 1.0f, 0.0f, 10.0f), glm::vec4(0.0f, -1.0f, 0.0f, 10.0f),
+			glm::vec4(0.0f, 0.0f, 1.0f, 10.0f), glm::vec4(0.0f, 0.0f, -1.0f, 10.0f) };
+
+		my_vulkan::FrustumCuller culler;
+		uint32_t expectedVisible = padding;
+		for (uint32_t i = 0; i != padding; ++i)
+			culler.addWorldSphere(glm::vec3(0.0f), 1.0f);
+		for (size_t i = first; i != end; ++i)
+		{
+			culler.addWorldSphere(cullingCases[i].center, cullingCases[i].radius);
+			expectedVisible += cullingCases[i].visible ? 1 : 0;
+		}
+
+		for (int simd = 0; simd != 2; ++simd)
+		{
+			if (simd)
+				culler.cull(planes);
+			else
+				culler.cullScalar(planes);
+			std::string path = simd ? "simd" : "scalar";
+			for (size_t i = first; i != end; ++i)
+				if (culler.isVisible(padding + static_cast<uint32_t>(i - first)) != cullingCases[i].visible)
+					return fail(path + " culling gets " + cullingCases[i].name + " wrong among " + std::to_string(culler.getCount()) + " spheres");
+			if (culler.getVisibleCount() != expectedVisible)
+				return fail(path + " culling counts " + std::to_string(culler.getVisibleCount()) + " visible spheres instead of " +
+					std::to_string(expectedVisible));
+		}
+		return true;
+	}
+}
+
+bool my_vulkan::Benchmarks::meshCache(const std::vector<std::string>& paths)
+{
+	using clock = std::chrono::high_resolution_clock;
+	float totalObj = 0.0f, totalCache = 0.0f;
+	for (const auto& path : paths)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Submesh> submeshes;
+		std::vector<std::string> materialLibraries;
+
+		auto start = clock::now();
+		Mesh::parseObj(path, vertices, indices, nullptr, &submeshes, &materialLibraries);
+		auto bounds = MeshCache::computeBounds(vertices);
+		float objTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		MeshCache::write(path, vertices, indices, bounds, submeshes, materialLibraries);
+
+		start = clock::now();
+		MeshCache cache;
+		if (!cache.open(path))
+			return fail("cannot open the mesh cache just written for " + path);
+		//touch every page like the upload memcpy would
+		uint32_t checksum = 0;
+		for (uint64_t i = 0; i != cache.getIndexCount(); ++i)
+			checksum += cache.getIndices()[i];
+		float sum = 0.0f;
+		for (uint64_t i = 0; i != cache.getVertexCount(); ++i)
+			sum += cache.getVertices()[i].pos.x;
+		float cacheTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		if (cache.getIndexCount() != indices.size() || !std::equal(indices.begin(), indices.end(), cache.getIndices()) ||
+			cache.getVertexCount() != vertices.size() || !std::equal(vertices.begin(), vertices.end(), cache.getVertices()))
+			return fail("mesh cache does not round trip " + path);
+
+		totalObj += objTime;
+		totalCache += cacheTime;
+		std::cout << path << " : obj " << objTime << " ms, cache " << cacheTime << " ms (" << vertices.size() << " vertices, "
+			<< indices.size() << " indices, checksum " << checksum + static_cast<uint32_t>(sum) << ")" << std::endl;
+	}
+	std::cout << "total : obj " << totalObj << " ms, cache " << totalCache << " ms" << std::endl;
+	return true;
+}
+
+bool my_vulkan::Benchmarks::meshOptimizer(const std::vector<std::string>& paths)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto report = [](const char* step, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, float time)
+	{
+		MeshOptimizerStats stats = MeshOptimizer::analyze(indices.data(), indices.size(), vertices.size(), sizeof(Vertex));
+		std::cout << "  " << step << " : acmr " << stats.acmr << ", atvr " << stats.atvr << ", overfetch " << stats.overfetch << " (" << time
+			<< " ms)" << std::endl;
+		return stats;
+	};
+	//each triangle rotated to start at its smallest index, so only the order of triangles may differ
+	auto sortedTriangles = [](const std::vector<uint32_t>& indices)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+		for (size_t t = 0; t != triangles.size(); ++t)
+		{
+			const uint32_t* triangle = &indices[t * 3];
+			size_t first = std::min_element(triangle, triangle + 3) - triangle;
+			triangles[t] = { triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3] };
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+
+	for (const auto& path : paths)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		Mesh::parseObj(path, vertices, indices);
+		std::cout << path << " : " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl;
+		MeshOptimizerStats original = report("obj order", vertices, indices, 0.0f);
+
+		std::vector<uint32_t> optimized = indices;
+		auto start = clock::now();
+		MeshOptimizer::optimizeVertexCache(optimized, vertices.size());
+		MeshOptimizerStats cached = report("vertex cache", vertices, optimized, std::chrono::duration<float, std::milli>(clock::now() - start).count());
+		if (cached.acmr > original.acmr)
+			return fail("vertex cache optimization raised the acmr of " + path);
+
+		start = clock::now();
+		MeshOptimizer::optimizeOverdraw(optimized, vertices);
+		report("overdraw", vertices, optimized, std::chrono::duration<float, std::milli>(clock::now() - start).count());
+		if (sortedTriangles(optimized) != sortedTriangles(indices))
+			return fail("mesh optimizer changed the triangles of " + path);
+
+		std::vector<Vertex> remapped = vertices;
+		std::vector<uint32_t> remappedIndices = optimized;
+		start = clock::now();
+		MeshOptimizer::optimizeVertexFetch(remapped, remappedIndices);
+		report("vertex fetch", remapped, remappedIndices, std::chrono::duration<float, std::milli>(clock::now() - start).count());
+		for (size_t i = 0; i != optimized.size(); ++i)
+			if (!(remapped[remappedIndices[i]] == vertices[optimized[i]]))
+				return fail("mesh optimizer changed the vertices of " + path);
+	}
+	return true;
+}
+
+bool my_vulkan::Benchmarks::vertexCompression(const std::vector<std::string>& paths)
+{
+	size_t fullBytes = 0, compressedBytes = 0;
+	for (const auto& path : paths)
+	{
+		auto meshData = MeshData::load(path);
+		meshData->compress();
+		const Vertex* vertices = meshData->getVertices();
+
+		float positionError = 0.0f, normalError = 0.0f, texCoordError = 0.0f;
+		for (size_t i = 0; i != meshData->getVertexCount(); ++i)
+		{
+			Vertex decoded = meshData->compressedVertices[i].decode(meshData->quantization);
+			glm::vec3 position = glm::abs(decoded.pos - vertices[i].pos);
+			positionError = std::max({ positionError, position.x, position.y, position.z });
+
+			float length = glm::length(vertices[i].normal);
+			if (length > 0.0f)
+			{
+				//atan2 stays accurate for tiny angles where acos of the dot product does not
+				glm::vec3 normal = vertices[i].normal / length;
+				float angle = std::atan2(glm::length(glm::cross(decoded.normal, normal)), glm::dot(decoded.normal, normal));
+				normalError = std::max(normalError, glm::degrees(angle));
+			}
+
+			//a half float keeps 11 significant bits, so rounding is off by at most one part in 2048
+			for (int k = 0; k != 2; ++k)
+			{
+				float error = std::abs(decoded.texCoord[k] - vertices[i].texCoord[k]) / std::max(std::abs(vertices[i].texCoord[k]), 1.0f);
+				texCoordError = std::max(texCoordError, error);
+			}
+		}
+
+		float positionStep = meshData->quantization.extent / 65535.0f;
+		std::cout << path << " : " << meshData->getVertexCount() << " vertices, " << meshData->getVertexCount() * sizeof(Vertex)
+			<< " -> " << meshData->getVertexCount() * sizeof(CompressedVertex) << " bytes, position error " << positionError
+			<< " (" << positionError / positionStep << " steps), normal error " << normalError << " deg, texCoord error " << texCoordError
+			<< std::endl;
+		if (positionError > positionStep || normalError > 0.05f || texCoordError > 1.0f / 2048.0f)
+			return fail("vertex compression error out of bounds for " + path);
+
+		fullBytes += meshData->getVertexCount() * sizeof(Vertex);
+		compressedBytes += meshData->getVertexCount() * sizeof(CompressedVertex);
+	}
+	std::cout << "total : " << fullBytes << " -> " << compressedBytes << " bytes" << std::endl;
+	return true;
+}
+
+bool my_vulkan::Benchmarks::objLoad(std::string path)
+{
+	using clock = std::chrono::high_resolution_clock;
+	if (path.empty())
+		path = getGridObj();
+
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+	auto start = clock::now();
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.data()))
+		throw std::runtime_error(warn + err);
+	float loadTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+	auto makeVertex = [&attrib](const tinyobj::index_t& index)
+	{
+		Vertex vertex{};
+		vertex.pos = { attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2] };
+		//-1 when the corner has no normal or texCoord, they stay zero like in parseObj
+		if (index.normal_index >= 0)
+			vertex.normal = { attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2] };
+		if (index.texcoord_index >= 0)
+			vertex.texCoord = { attrib.texcoords[2 * index.texcoord_index + 0], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+		return vertex;
+	};
+	struct XorVertexHash
+	{
+		size_t operator()(const Vertex& vertex) const
+		{
+			return std::hash<glm::vec3>()(vertex.pos) ^ std::hash<glm::vec3>()(vertex.normal) ^ std::hash<glm::vec2>()(vertex.texCoord);
+		}
+	};
+
+	size_t cornerCount = 0;
+	for (const auto& shape : shapes)
+		cornerCount += shape.mesh.indices.size();
+
+	std::vector<Vertex> mapVertices;
+	std::vector<uint32_t> mapIndices;
+	start = clock::now();
+	std::unordered_map<Vertex, uint32_t, XorVertexHash> uniqueVertices;
+	for (const auto& shape : shapes)
+	{
+		for (const auto& index : shape.mesh.indices)
+		{
+			Vertex vertex = makeVertex(index);
+			if (uniqueVertices.count(vertex) == 0)
+			{
+				uniqueVertices[vertex] = static_cast<uint32_t>(mapVertices.size());
+				mapVertices.push_back(vertex);
+			}
+			mapIndices.push_back(uniqueVertices[vertex]);
+		}
+	}
+	float mapTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+	std::vector<Vertex> weldedVertices;
+	std::vector<uint32_t> weldedIndices;
+	start = clock::now();
+	VertexWelder welder(weldedVertices, attrib.vertices.size() / 3);
+	weldedIndices.reserve(cornerCount);
+	for (const auto& shape : shapes)
+		for (const auto& index : shape.mesh.indices)
+			weldedIndices.push_back(welder.weld(makeVertex(index)));
+	float welderTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+	//both keep the first occurrence order, so the results are identical
+	if (weldedIndices != mapIndices || weldedVertices.size() != mapVertices.size() ||
+		!std::equal(weldedVertices.begin(), weldedVertices.end(), mapVertices.begin()))
+		return fail("vertex welder disagrees with the unordered_map for " + path);
+
+	std::cout << path << " : " << cornerCount / 3 << " triangles in " << shapes.size() << " shapes, " << weldedVertices.size()
+		<< " unique vertices, tinyobj " << loadTime << " ms" << std::endl;
+	std::cout << "weld : unordered_map " << mapTime << " ms, VertexWelder " << welderTime << " ms (" << mapTime / welderTime << "x)" << std::endl;
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	start = clock::now();
+	Mesh::parseObj(path, vertices, indices);
+	float serialTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+	ThreadPool threadPool;
+	vertices.clear();
+	indices.clear();
+	start = clock::now();
+	Mesh::parseObj(path, vertices, indices, &threadPool);
+	float parallelTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+	std::cout << "parseObj : serial " << serialTime << " ms, chunks on " << threadPool.getThreadCount() << " threads " << parallelTime
+		<< " ms (" << vertices.size() << " vertices)" << std::endl;
+	return true;
+}
+
+bool my_vulkan::Benchmarks::objParse(std::string path)
+{
+	using clock = std::chrono::high_resolution_clock;
+	if (path.empty())
+		path = getGridObj();
+	auto toMegabytes = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+	size_t basePeak = getPeakMemoryUsage();
+
+	//ObjParser runs first since the peak only grows, the mapped pages of the file count towards it
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	auto start = clock::now();
+	ObjParser::parse(path, vertices, indices);
+	float serialTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+	size_t parserPeak = getPeakMemoryUsage();
+
+	ThreadPool threadPool;
+	std::vector<Vertex> parallelVertices;
+	std::vector<uint32_t> parallelIndices;
+	start = clock::now();
+	ObjParser::parse(path, parallelVertices, parallelIndices, &threadPool);
+	float parallelTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+	//welding runs in file order whatever the chunks, so both are identical
+	if (parallelIndices != indices || parallelVertices.size() != vertices.size() ||
+		!std::equal(parallelVertices.begin(), parallelVertices.end(), vertices.begin()))
+		return fail("chunked ObjParser disagrees with the serial one for " + path);
+	std::vector<Vertex>().swap(parallelVertices);
+	std::vector<uint32_t>().swap(parallelIndices);
+
+	std::vector<Vertex> tinyobjVertices;
+	std::vector<uint32_t> tinyobjIndices;
+	start = clock::now();
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.data()))
+			throw std::runtime_error(warn + err);
+		VertexWelder welder(tinyobjVertices, attrib.vertices.size() / 3);
+		for (const auto& shape : shapes)
+		{
+			for (const auto& index : shape.mesh.indices)
+			{
+				Vertex vertex{};
+				vertex.pos = { attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2] };
+				if (index.normal_index >= 0)
+					vertex.normal = { attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2] };
+				if (index.texcoord_index >= 0)
+					vertex.texCoord = { attrib.texcoords[2 * index.texcoord_index + 0], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+				tinyobjIndices.push_back(welder.weld(vertex));
+			}
+		}
+	}
+	float tinyobjTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+	size_t tinyobjPeak = getPeakMemoryUsage();
+	//tinyobj may split polygons along other diagonals, triangle files give the same result
+	bool matches = tinyobjIndices == indices && tinyobjVertices.size() == vertices.size() &&
+		std::equal(tinyobjVertices.begin(), tinyobjVertices.end(), vertices.begin());
+
+	std::cout << path << " : " << indices.size() / 3 << " triangles, " << vertices.size() << " unique vertices, tinyobj "
+		<< (matches ? "agrees" : "differs") << std::endl;
+	std::cout << "ObjParser : serial " << serialTime << " ms, chunks on " << threadPool.getThreadCount() << " threads " << parallelTime
+		<< " ms, peak " << toMegabytes(parserPeak) << " MB" << std::endl;
+	std::cout << "tinyobj + VertexWelder : " << tinyobjTime << " ms, peak " << toMegabytes(tinyobjPeak) << " MB";
+	if (tinyobjPeak == parserPeak)
+		std::cout << " (no higher than ObjParser)";
+	std::cout << std::endl << "peak before parsing " << toMegabytes(basePeak) << " MB" << std::endl;
+	return true;
+}
+
+bool my_vulkan::Benchmarks::textureCompression(const std::vector<std::string>& paths)
+{
+	using clock = std::chrono::high_resolution_clock;
+	ThreadPool threadPool;
+	size_t totalRgba = 0, totalBlocks = 0;
+	for (const auto& path : paths)
+	{
+		auto start = clock::now();
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+			throw std::runtime_error("failed to load texture image : " + path);
+		std::vector<uint8_t> source(pixels, pixels + size_t(width) * height * 4);
+		stbi_image_free(pixels);
+		float decodeTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		start = clock::now();
+		auto bc7 = TextureCompressor::compress(source.data(), width, height, VK_FORMAT_BC7_SRGB_BLOCK, &threadPool);
+		float bc7Time = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		start = clock::now();
+		//as if the texture was a normal map, only r and g are compared
+		auto bc5 = TextureCompressor::compress(source.data(), width, height, VK_FORMAT_BC5_UNORM_BLOCK, &threadPool);
+		float bc5Time = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		double bc7Psnr = computePsnr(source, TextureCompressor::decompress(bc7.data(), width, height, VK_FORMAT_BC7_SRGB_BLOCK), 4);
+		double bc5Psnr = computePsnr(source, TextureCompressor::decompress(bc5.data(), width, height, VK_FORMAT_BC5_UNORM_BLOCK), 2);
+
+		//both chains go down to 1x1
+		size_t rgbaBytes = 0, blockBytes = 0;
+		for (uint32_t w = width, h = height;; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u))
+		{
+			rgbaBytes += size_t(w) * h * 4;
+			blockBytes += TextureCompressor::getCompressedSize(w, h);
+			if (w == 1 && h == 1)
+				break;
+		}
+		totalRgba += rgbaBytes;
+		totalBlocks += blockBytes;
+
+		std::cout << path << " (" << width << "x" << height << ") : BC7 " << bc7Time << " ms, " << bc7Psnr << " dB, BC5 "
+			<< bc5Time << " ms, " << bc5Psnr << " dB, " << rgbaBytes / 1024 << " KB -> " << blockBytes / 1024 << " KB";
+		TextureCache cache;
+		start = clock::now();
+		if (cache.open(path))
+			std::cout << ", png decode " << decodeTime << " ms against cache map "
+				<< std::chrono::duration<float, std::milli>(clock::now() - start).count() << " ms";
+		std::cout << std::endl;
+		if (bc7Psnr < MIN_BC7_PSNR || bc5Psnr < MIN_BC5_PSNR)
+			return fail("block compression quality below bounds for " + path);
+	}
+	std::cout << "total " << totalRgba / 1024 << " KB of rgba8 mips -> " << totalBlocks / 1024 << " KB of blocks, "
+		<< double(totalRgba) / double(totalBlocks) << "x smaller" << std::endl;
+	return true;
+}
+
+bool my_vulkan::Benchmarks::culling(uint32_t count)
+{
+	//the padding moves every case through the four sse lanes, and each case alone is a count of 1 that only the scalar
+	//tail of cull() handles
+	const size_t caseCount = std::size(cullingCases);
+	for (uint32_t padding = 0; padding != 4; ++padding)
+		if (!checkCullingCases(padding, 0, caseCount))
+			return false;
+	for (size_t i = 0; i != caseCount; ++i)
+		if (!checkCullingCases(0, i, i + 1))
+			return false;
+	std::cout << caseCount << " known answer spheres culled correctly in every sse lane and in the scalar tail" << std::endl;
+
+	using clock = std::chrono::high_resolution_clock;
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> radius(0.1f, 5.0f);
+
+	FrustumCuller culler;
+	culler.reserve(count);
+	for (uint32_t i = 0; i != count; ++i)
+		culler.addWorldSphere(glm::vec3(position(random), position(random), position(random)), radius(random));
+
+	glm::mat4 projection = glm::perspective(glm::radians(70.0f), 1920.0f / 1080.0f, 0.1f, 1000.0f);
+	projection[1][1] *= -1;
+	const int cameraCount = 16;
+	const int iterations = 20;
+	float scalarTime = 0.0f, simdTime = 0.0f;
+	uint64_t visibleTotal = 0;
+	for (int c = 0; c != cameraCount; ++c)
+	{
+		float angle = glm::radians(360.0f / cameraCount * c);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::cos(angle), 0.2f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+		auto planes = VulkanUtils::extractFrustumPlanes(projection * view);
+
+		auto start = clock::now();
+		for (int i = 0; i != iterations; ++i)
+			culler.cullScalar(planes);
+		scalarTime += std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		std::vector<uint8_t> reference(culler.getVisibility(0), culler.getVisibility(0) + count);
+		uint32_t referenceVisible = culler.getVisibleCount();
+
+		start = clock::now();
+		for (int i = 0; i != iterations; ++i)
+			culler.cull(planes);
+		simdTime += std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		if (culler.getVisibleCount() != referenceVisible || !std::equal(reference.begin(), reference.end(), culler.getVisibility(0)))
+			return fail("simd culling disagrees with the scalar reference");
+		visibleTotal += referenceVisible;
+	}
+
+	int runs = cameraCount * iterations;
+	std::cout << count << " spheres : scalar " << scalarTime / runs << " ms, simd " << simdTime / runs << " ms per cull ("
+		<< scalarTime / simdTime << "x), " << visibleTotal / cameraCount << " visible on average, results identical" << std::endl;
+	return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace my_vulkan
+{
+	//CPU-only benchmarks that double as checks of what they time, none of them needs a device. Each prints its numbers and
+	//returns false after printing why when a result disagrees with its reference or misses its bound
+	class Benchmarks
+	{
+	public:
+		//Parsing the .obj files against reading their binary caches
+		static bool meshCache(const std::vector<std::string>& paths);
+		//ACMR, ATVR and vertex overfetch before and after each MeshOptimizer step. The triangles and vertices have to survive
+		//unchanged and the vertex cache step may not raise the ACMR
+		static bool meshOptimizer(const std::vector<std::string>& paths);
+		//Every vertex through CompressedVertex and back the way the vertex shader decodes it, the errors have to stay within
+		//what the 16 bit encodings allow
+		static bool vertexCompression(const std::vector<std::string>& paths);
+		//Welding the corners of a large .obj with the node based unordered_map parseObj used before against VertexWelder, then
+		//parseObj on one thread and with its chunks on a thread pool. Without a path a 2M triangle grid is written first
+		static bool objLoad(std::string path);
+		//ObjParser serial and chunked against tinyobj followed by VertexWelder, with the peak resident memory after each.
+		//Without a path the grid of objLoad is used
+		static bool objParse(std::string path);
+		//BC7 and BC5 encode time, PSNR against the source and mip chain memory against rgba8, the PSNR has to reach
+		//MIN_BC7_PSNR and MIN_BC5_PSNR
+		static bool textureCompression(const std::vector<std::string>& paths);
+		//Culls hand placed spheres against an axis aligned box whose answers are known, then random spheres with the scalar and
+		//the SSE path, which have to agree sphere by sphere
+		static bool culling(uint32_t count);
+
+		static constexpr double MIN_BC7_PSNR = 30.0;
+		static constexpr double MIN_BC5_PSNR = 35.0;
+	};
+}
@@ -3,28 +3,22 @@
 #include <iostream>
 
 #include "Camera.h"
-#include "VulkanDescriptors.h"
-#include "VulkanUniformBuffers.h"
+#include "VulkanUniformArena.h"
 #include "VulkanImage.h"
 #include "glm/gtx/io.hpp"
 
-my_vulkan::BlinnPhongTexture::BlinnPhongTexture(const std::string& filePath,
-                                                const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
-	: Texture(filePath, device, commandPool)
+my_vulkan::BlinnPhongTexture::BlinnPhongTexture(const std::string& filePath, const ImageData& imageData,
+                                                const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+	: Texture(filePath, imageData, device, uploader)
 {
 	ubo = new FragmentUniformBufferObject;
 	ubo->ks = { 0.8f, 0.8f, 0.8f };
 	ubo->cameraPos = { 0, 0, 0 };
 	ubo->lightPos = { 1000,1000, 1000 };
 	ubo->lightIntensity = 300.0f;
-
-	uniformBuffer = std::make_shared<VulkanUniformBuffers>(device, VulkanUBOFor::FRAGMENT_SHADER);
-	
-	uboDescriptor = std::make_shared<VulkanDescriptors>(device, uniformBuffer.get(), 
-		VK_NULL_HANDLE, VK_NULL_HANDLE, VulkanDescriptorFor::FRAGMENT_SHADER_UNIFORM_BUFFER);
 }
 
-void my_vulkan::BlinnPhongTexture::update(uint32_t currentFrame,Camera* camera, PointLight* light)
+void my_vulkan::BlinnPhongTexture::update(VulkanUniformArena* uniformArena, Camera* camera, PointLight* light)
 {
 	//ubo->cameraPos.x= camera->position.z;
 	//ubo->cameraPos.z= -camera->position.x;
@@ -38,5 +32,5 @@ void my_vulkan::BlinnPhongTexture::update(uint32_t currentFrame,Camera* camera,
 
 	//std::cout << ubo->cameraPos << " " << ubo->lightPos << " " << ubo->lightIntensity << " " << std::endl;
 
-	uniformBuffer->updateUniformBuffer(currentFrame, ubo);
+	uboOffset = uniformArena->push(*ubo);
 }
@@ -10,17 +10,17 @@ namespace my_vulkan
 
 namespace my_vulkan
 {
-	class VulkanUniformBuffers;
+	class VulkanUniformArena;
 
 	class BlinnPhongTexture : public Texture
 	{
 	public:
-		BlinnPhongTexture(const std::string& filePath, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
+		BlinnPhongTexture(const std::string& filePath, const ImageData& imageData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
 
-		void update(uint32_t currentFrame, Camera* camera, PointLight* light);
+		//Pushes this frame's lighting parameters into the arena, bind them with uboOffset
+		void update(VulkanUniformArena* uniformArena, Camera* camera, PointLight* light);
 
-		std::shared_ptr<VulkanUniformBuffers> uniformBuffer;
-		std::shared_ptr<VulkanDescriptors> uboDescriptor;
+		uint32_t uboOffset = 0;
 
 	private:
 		FragmentUniformBufferObject* ubo;
@@ -0,0 +1,115 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MY_VULKAN_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+void my_vulkan::FrustumCuller::clear()
+{
+	centersX.clear();
+	centersY.clear();
+	centersZ.clear();
+	radii.clear();
+	visible.clear();
+	visibleCount = 0;
+}
+
+void my_vulkan::FrustumCuller::reserve(size_t count)
+{
+	centersX.reserve(count);
+	centersY.reserve(count);
+	centersZ.reserve(count);
+	radii.reserve(count);
+	visible.reserve(count);
+}
+
+uint32_t my_vulkan::FrustumCuller::add(const glm::mat4& model, const glm::vec3& center, float radius)
+{
+	glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+	//non-uniform scale stretches the sphere by its largest axis
+	float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+	return addWorldSphere(worldCenter, radius * scale);
+}
+
+uint32_t my_vulkan::FrustumCuller::addWorldSphere(const glm::vec3& center, float radius)
+{
+	centersX.push_back(center.x);
+	centersY.push_back(center.y);
+	centersZ.push_back(center.z);
+	radii.push_back(radius);
+	visible.push_back(1);
+	return static_cast<uint32_t>(radii.size() - 1);
+}
+
+void my_vulkan::FrustumCuller::cull(const std::array<glm::vec4, 6>& planes)
+{
+#ifdef MY_VULKAN_CULL_SSE
+	size_t count = radii.size();
+	size_t simdEnd = count & ~size_t(3);
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int i = 0; i != 6; ++i)
+	{
+		planeX[i] = _mm_set1_ps(planes[i].x);
+		planeY[i] = _mm_set1_ps(planes[i].y);
+		planeZ[i] = _mm_set1_ps(planes[i].z);
+		planeW[i] = _mm_set1_ps(planes[i].w);
+	}
+
+	uint32_t visibleSum = 0;
+	for (size_t i = 0; i != simdEnd; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&centersX[i]);
+		__m128 y = _mm_loadu_ps(&centersY[i]);
+		__m128 z = _mm_loadu_ps(&centersZ[i]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radii[i]));
+
+		//a lane stays set while the sphere is not completely behind any plane
+		__m128 inside = _mm_cmpeq_ps(negativeRadius, negativeRadius);
+		for (int p = 0; p != 6; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane != 4; ++lane)
+		{
+			uint8_t laneVisible = (mask >> lane) & 1;
+			visible[i + lane] = laneVisible;
+			visibleSum += laneVisible;
+		}
+	}
+	visibleCount = visibleSum;
+	cullRange(planes, simdEnd, count);
+#else
+	visibleCount = 0;
+	cullRange(planes, 0, radii.size());
+#endif
+}
+
+void my_vulkan::FrustumCuller::cullScalar(const std::array<glm::vec4, 6>& planes)
+{
+	visibleCount = 0;
+	cullRange(planes, 0, radii.size());
+}
+
+void my_vulkan::FrustumCuller::cullRange(const std::array<glm::vec4, 6>& planes, size_t begin, size_t end)
+{
+	//same operation order as the sse path so both round identically
+	for (size_t i = begin; i != end; ++i)
+	{
+		bool inside = true;
+		for (const auto& plane : planes)
+		{
+			float distance = (centersX[i] * plane.x + centersY[i] * plane.y) + (centersZ[i] * plane.z + plane.w);
+			inside = inside && distance >= -radii[i];
+		}
+		visible[i] = inside ? 1 : 0;
+		visibleCount += inside ? 1 : 0;
+	}
+}
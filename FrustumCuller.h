@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace my_vulkan
+{
+	//World space bounding spheres kept as structure of arrays so the plane tests run four spheres per SSE instruction.
+	//Fill it with add every frame, cull against the planes of VulkanUtils::extractFrustumPlanes and query isVisible
+	class FrustumCuller
+	{
+	public:
+		void clear();
+		void reserve(size_t count);
+
+		//Transforms a mesh space sphere by model and returns its index
+		uint32_t add(const glm::mat4& model, const glm::vec3& center, float radius);
+		uint32_t addWorldSphere(const glm::vec3& center, float radius);
+
+		//SSE when the target has it, otherwise the scalar path
+		void cull(const std::array<glm::vec4, 6>& planes);
+		//Reference implementation, the two always agree
+		void cullScalar(const std::array<glm::vec4, 6>& planes);
+
+		bool isVisible(uint32_t index) const { return visible[index] != 0; }
+		//One byte per sphere starting at first, non-zero when it is inside or intersects the frustum
+		const uint8_t* getVisibility(uint32_t first) const { return visible.data() + first; }
+		uint32_t getCount() const { return static_cast<uint32_t>(radii.size()); }
+		uint32_t getVisibleCount() const { return visibleCount; }
+
+	private:
+		void cullRange(const std::array<glm::vec4, 6>& planes, size_t begin, size_t end);
+
+		std::vector<float> centersX;
+		std::vector<float> centersY;
+		std::vector<float> centersZ;
+		std::vector<float> radii;
+		std::vector<uint8_t> visible;
+		uint32_t visibleCount = 0;
+	};
+}
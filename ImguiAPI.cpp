@@ -8,15 +8,19 @@
 #include "VulkanContext.h"
 #include "VulkanInstance.h"
 #include "VulkanDevice.h"
+#include "VulkanAllocator.h"
 #include "VulkanGraphicsPipeline.h"
 #include "VulkanRenderer.h"
 #include "Object.h"
 #include "Vertex.h"
 #include "Camera.h"
+#include "Profiler.h"
+#include "VulkanPipelineManager.h"
 #include "imgui_internal.h"
 #include "glm/gtc/type_ptr.hpp"
 
 my_vulkan::ImguiAPI::ImguiAPI(VulkanContext* context)
+	: context(context)
 {
 	VkDescriptorPoolSize poolSize[] = {
 		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
@@ -94,7 +98,8 @@ void my_vulkan::ImguiAPI::handleInput(VulkanContext* context, Camera* camera)
 		camera->moveDown();
 }
 
-void my_vulkan::ImguiAPI::updateImgui(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Object>>& objects)
+void my_vulkan::ImguiAPI::updateImgui(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Object>>& objects,
+	const RendererFrameStats& frameStats)
 {
 	io = ImGui::GetIO();
 	ImGui_ImplVulkan_NewFrame();
@@ -119,6 +124,23 @@ void my_vulkan::ImguiAPI::updateImgui(VkCommandBuffer commandBuffer, const std::
 
 	//ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
 
+	VulkanAllocatorStats stats = context->device->getAllocator()->getStats();
+	ImGui::Text("GPU memory %.1f / %.1f MB, %u blocks, %u dedicated", stats.bytesUsed / (1024.0f * 1024.0f),
+		stats.bytesReserved / (1024.0f * 1024.0f), stats.blockCount, stats.dedicatedAllocationCount);
+	ImGui::Text("%u allocations, fragmentation %.1f%%", stats.allocationCount, stats.fragmentation * 100.0f);
+	if (frameStats.gpuCulling)
+		ImGui::Text("Meshes culled on the GPU");
+	else
+		ImGui::Text("Culled %u of %u meshes, %u whole objects", frameStats.culledMeshCount, frameStats.meshCount, frameStats.culledObjectCount);
+	ImGui::Text("Recorded draws in %.3f ms on %u threads", frameStats.recordTime, frameStats.recordingThreads);
+	const RenderQueueStats& queueStats = frameStats.queueStats;
+	ImGui::Text("%u draws, %s in %.3f ms", queueStats.drawCount, frameStats.sortedDraws ? "sorted" : "unsorted", frameStats.sortTime);
+	ImGui::Text("Binds: %u pipeline, %u descriptor, %u vertex, %u index", queueStats.pipelineBinds, queueStats.descriptorBinds,
+		queueStats.vertexBufferBinds, queueStats.indexBufferBinds);
+	if (frameStats.particleCount != 0)
+		ImGui::Text("Particles: %u", frameStats.particleCount);
+	ImGui::Text("Pipeline variants: %u, %u building", context->pipelineManager->getVariantCount(), context->pipelineManager->getPendingCount());
+
 	for (auto & object : objects)
 	{
 		ImGui::BeginListBox(object->name.c_str());
@@ -130,6 +152,43 @@ void my_vulkan::ImguiAPI::updateImgui(VkCommandBuffer commandBuffer, const std::
 	}
 
 	ImGui::End();
+
+	//gpu scopes lag the cpu ones by the frames in flight
+	ImGui::Begin("Profiler");
+	if (ImGui::BeginTable("scopes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("scope");
+		ImGui::TableSetupColumn("last ms");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableHeadersRow();
+		for (const ProfilerScopeStats& scope : context->profiler->getStats())
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%s %s", scope.gpu ? "gpu" : "cpu", scope.name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", scope.last);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", scope.p50);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", scope.p95);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", scope.p99);
+		}
+		ImGui::EndTable();
+	}
+	bool tracing = context->profiler->isTracing();
+	if (ImGui::Checkbox("Trace", &tracing))
+		context->profiler->setTracing(tracing);
+	ImGui::SameLine();
+	if (ImGui::Button("Save profile_trace.json"))
+		context->profiler->writeChromeTrace("profile_trace.json");
+	if (tracing)
+		ImGui::Text("%zu events", context->profiler->getTraceEventCount());
+	ImGui::End();
+
 	ImGui::Render();
 	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 }
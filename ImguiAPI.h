@@ -11,15 +11,17 @@ namespace my_vulkan
 	class Camera;
 	class Object;
 	class VulkanContext;
+	struct RendererFrameStats;
 	class ImguiAPI
 	{
 		
 	public:
 		ImguiAPI(VulkanContext* context);
 		void handleInput(VulkanContext* context, Camera* camera);
-		void updateImgui(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Object>>& objects);
+		void updateImgui(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Object>>& objects, const RendererFrameStats& frameStats);
 
 	private:
+		VulkanContext* context;
 		bool show_demo_window = true;
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 		ImGuiIO io;
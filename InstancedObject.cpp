@@ -0,0 +1,56 @@
+#include "InstancedObject.h"
+
+#include <algorithm>
+#include "Model.h"
+#include "VulkanContext.h"
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+my_vulkan::InstancedObject::InstancedObject(const std::string& name, my_vulkan::VulkanContext* context,
+	const std::vector<std::string>& modelPaths, const std::vector<std::string>& texturePaths)
+	: Object(name, context, modelPaths, texturePaths), device(context->device)
+{
+	instanceBuffers.resize(MAX_RENDER_IMAGES, VK_NULL_HANDLE);
+	instanceBufferAllocations.resize(MAX_RENDER_IMAGES);
+	instanceCapacities.resize(MAX_RENDER_IMAGES, 0);
+}
+
+void my_vulkan::InstancedObject::tick(uint32_t currentImage, Camera* camera, PointLight* light)
+{
+	Object::tick(currentImage, camera, light);
+
+	currentFrame = currentImage;
+	drawCount = static_cast<uint32_t>(instances.size());
+	if (drawCount == 0)
+		return;
+
+	reserveInstanceBuffer(currentFrame, drawCount);
+	InstanceData* mapped = static_cast<InstanceData*>(instanceBufferAllocations[currentFrame].mapped);
+	for (uint32_t i = 0; i != drawCount; ++i)
+		mapped[i].model = ubo->model * instances[i];
+}
+
+void my_vulkan::InstancedObject::reserveInstanceBuffer(uint32_t frame, uint32_t count)
+{
+	if (count <= instanceCapacities[frame])
+		return;
+
+	if (instanceBuffers[frame] != VK_NULL_HANDLE)
+		VulkanUtils::destroyBuffer(device->getLogicalDevice(), instanceBuffers[frame], instanceBufferAllocations[frame]);
+
+	//grow geometrically so adding instances one by one does not reallocate every frame
+	uint32_t capacity = std::max(count, instanceCapacities[frame] * 2);
+	VulkanUtils::createBuffer(device, instanceBuffers[frame], instanceBufferAllocations[frame], sizeof(InstanceData) * capacity,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	if (instanceBufferAllocations[frame].mapped == nullptr)
+		throw std::runtime_error("failed to map instance buffer!");
+	instanceCapacities[frame] = capacity;
+}
+
+void my_vulkan::InstancedObject::destroyObject(VkDevice device)
+{
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+		if (instanceBuffers[i] != VK_NULL_HANDLE)
+			VulkanUtils::destroyBuffer(device, instanceBuffers[i], instanceBufferAllocations[i]);
+	Object::destroyObject(device);
+}
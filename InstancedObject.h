@@ -0,0 +1,40 @@
+#pragma once
+#include "Object.h"
+#include "VulkanAllocator.h"
+
+namespace my_vulkan
+{
+	//Draws many copies of the same meshes with one vkCmdDrawIndexed each. Instance transforms are relative to the
+	//object's own transformation and are copied into a per-frame instance vertex buffer every tick
+	class InstancedObject : public Object
+	{
+	public:
+		InstancedObject(const std::string& name, my_vulkan::VulkanContext* context, const std::vector<std::string>& modelPaths,
+			const std::vector<std::string>& texturePaths);
+		void tick(uint32_t currentImage, Camera* camera, PointLight* light) override;
+
+		void addInstance(const glm::mat4& model) { instances.push_back(model); }
+		void clearInstances() { instances.clear(); }
+		uint32_t getInstanceCount() const { return static_cast<uint32_t>(instances.size()); }
+
+		bool isInstanced() const override { return true; }
+
+		void destroyObject(VkDevice device) override;
+
+	protected:
+		VkBuffer getInstanceBuffer() const override { return instanceBuffers[currentFrame]; }
+		uint32_t getDrawInstanceCount() const override { return drawCount; }
+
+	private:
+		//Grows the buffer of frame to hold at least count instances, only safe once the frame's previous submission has completed
+		void reserveInstanceBuffer(uint32_t frame, uint32_t count);
+
+		std::shared_ptr<VulkanDevice> device;
+		std::vector<glm::mat4> instances;
+		std::vector<VkBuffer> instanceBuffers;
+		std::vector<VulkanAllocation> instanceBufferAllocations;
+		std::vector<uint32_t> instanceCapacities;
+		uint32_t currentFrame = 0;
+		uint32_t drawCount = 0;
+	};
+}
@@ -0,0 +1,102 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+my_vulkan::MappedFile::MappedFile(const std::string& filePath)
+{
+	open(filePath);
+}
+
+my_vulkan::MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool my_vulkan::MappedFile::open(const std::string& filePath)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<const uint8_t*>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat{};
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	fileDescriptor = fd;
+	data = static_cast<const uint8_t*>(view);
+	size = static_cast<size_t>(fileStat.st_size);
+#endif
+	return true;
+}
+
+void my_vulkan::MappedFile::close()
+{
+	if (data == nullptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(data), size);
+	::close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
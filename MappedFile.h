@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace my_vulkan
+{
+	//Read-only memory mapping of a whole file, the pages are released in the destructor
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& filePath);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool open(const std::string& filePath);
+		void close();
+
+		bool isOpen() const { return data != nullptr; }
+		const uint8_t* getData() const { return data; }
+		size_t getSize() const { return size; }
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+	};
+}
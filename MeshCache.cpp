@@ -0,0 +1,265 @@
+#include "MeshCache.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include "Vertex.h"
+
+namespace
+{
+	uint64_t getWriteTime(const std::string& filePath, uint64_t& fileSize)
+	{
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(filePath, error);
+		auto size = std::filesystem::file_size(filePath, error);
+		if (error)
+		{
+			fileSize = 0;
+			return 0;
+		}
+		fileSize = size;
+		return static_cast<uint64_t>(time.time_since_epoch().count());
+	}
+
+	uint64_t alignOffset(uint64_t offset)
+	{
+		return (offset + 15) & ~uint64_t(15);
+	}
+
+	//Patches a recorded write time in place at offset into the header, the rest of the cache is still valid
+	void updateWriteTime(const std::string& cachePath, size_t offset, uint64_t writeTime)
+	{
+		std::fstream out(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+		if (!out.is_open())
+			return;
+		out.seekp(offset);
+		out.write(reinterpret_cast<const char*>(&writeTime), sizeof(writeTime));
+	}
+
+	//A missing file passes, a moved timestamp only fails it when the content changed too. touched tells whether only the
+	//timestamp moved
+	bool isUnchanged(const std::string& filePath, uint64_t recordedWriteTime, uint64_t recordedSize, uint64_t recordedHash,
+		uint64_t& writeTime, bool& touched)
+	{
+		uint64_t size;
+		writeTime = getWriteTime(filePath, size);
+		touched = false;
+		if (size == 0 || (recordedWriteTime == writeTime && recordedSize == size))
+			return true;
+		touched = recordedSize == size && recordedHash == my_vulkan::MeshCache::hashFile(filePath);
+		return touched;
+	}
+}
+
+uint64_t my_vulkan::MeshCache::hashFile(const std::string& filePath)
+{
+	//FNV-1a, only needed when the timestamp changed but the content may not have (e.g. a fresh checkout)
+	MappedFile source(filePath);
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i != source.getSize(); ++i)
+	{
+		hash ^= source.getData()[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+my_vulkan::MeshBounds my_vulkan::MeshCache::computeBounds(const std::vector<Vertex>& vertices)
+{
+	MeshBounds bounds{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+	for (const auto& vertex : vertices)
+	{
+		bounds.min = glm::min(bounds.min, vertex.pos);
+		bounds.max = glm::max(bounds.max, vertex.pos);
+	}
+	if (vertices.empty())
+		bounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+	return bounds;
+}
+
+my_vulkan::MeshBounds my_vulkan::MeshCache::computeBounds(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount)
+{
+	MeshBounds bounds{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+	for (size_t i = 0; i != indexCount; ++i)
+	{
+		bounds.min = glm::min(bounds.min, vertices[indices[i]].pos);
+		bounds.max = glm::max(bounds.max, vertices[indices[i]].pos);
+	}
+	if (indexCount == 0)
+		bounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+	return bounds;
+}
+
+bool my_vulkan::MeshCache::open(const std::string& modelPath)
+{
+	close();
+
+	if (!file.open(getCachePath(modelPath)) || file.getSize() < sizeof(Header))
+		return false;
+
+	const auto* candidate = reinterpret_cast<const Header*>(file.getData());
+	bool valid = candidate->magic == MAGIC && candidate->version == VERSION && candidate->vertexStride == sizeof(Vertex) &&
+		candidate->vertexOffset + candidate->vertexCount * sizeof(Vertex) <= file.getSize() &&
+		candidate->indexOffset + candidate->indexCount * sizeof(uint32_t) <= file.getSize() &&
+		candidate->submeshOffset + candidate->submeshCount * sizeof(SubmeshRecord) <= file.getSize() &&
+		candidate->materialLibraryOffset + candidate->materialLibraryCount * sizeof(MaterialLibraryRecord) <= file.getSize() &&
+		candidate->stringOffset + candidate->stringSize <= file.getSize();
+
+	//the draws trust the submesh ranges, so one pointing outside the blobs rejects the cache
+	const auto* records = valid ? reinterpret_cast<const SubmeshRecord*>(file.getData() + candidate->submeshOffset) : nullptr;
+	for (uint64_t i = 0; valid && i != candidate->submeshCount; ++i)
+		valid = uint64_t(records[i].firstIndex) + records[i].indexCount <= candidate->indexCount &&
+			uint64_t(records[i].materialOffset) + records[i].materialLength <= candidate->stringSize &&
+			uint64_t(records[i].texturePathOffset) + records[i].texturePathLength <= candidate->stringSize;
+	const auto* libraries = valid ? reinterpret_cast<const MaterialLibraryRecord*>(file.getData() + candidate->materialLibraryOffset) : nullptr;
+	for (uint64_t i = 0; valid && i != candidate->materialLibraryCount; ++i)
+		valid = uint64_t(libraries[i].pathOffset) + libraries[i].pathLength <= candidate->stringSize;
+
+	//A missing source is fine as long as the cache is intact, the cache then is the asset
+	uint64_t sourceWriteTime = 0;
+	bool touched = false;
+	if (valid)
+		valid = isUnchanged(modelPath, candidate->sourceWriteTime, candidate->sourceSize, candidate->sourceHash, sourceWriteTime, touched);
+
+	//the submesh materials and texture paths come from the mtllibs, an edit there makes them stale as well
+	std::vector<std::pair<size_t, uint64_t>> touchedLibraries;
+	for (uint64_t i = 0; valid && i != candidate->materialLibraryCount; ++i)
+	{
+		std::string materialLibrary(reinterpret_cast<const char*>(file.getData() + candidate->stringOffset + libraries[i].pathOffset),
+			libraries[i].pathLength);
+		uint64_t materialWriteTime = 0;
+		bool materialTouched = false;
+		valid = isUnchanged(materialLibrary, libraries[i].writeTime, libraries[i].size, libraries[i].hash, materialWriteTime, materialTouched);
+		if (materialTouched)
+			touchedLibraries.emplace_back(candidate->materialLibraryOffset + i * sizeof(MaterialLibraryRecord) +
+				offsetof(MaterialLibraryRecord, writeTime), materialWriteTime);
+	}
+
+	if (!valid)
+	{
+		file.close();
+		return false;
+	}
+
+	//only the timestamps moved, record them so the next launch skips the hash
+	if (touched || !touchedLibraries.empty())
+	{
+		file.close();
+		if (touched)
+			updateWriteTime(getCachePath(modelPath), offsetof(Header, sourceWriteTime), sourceWriteTime);
+		for (const auto& library : touchedLibraries)
+			updateWriteTime(getCachePath(modelPath), library.first, library.second);
+		if (!file.open(getCachePath(modelPath)))
+			return false;
+		candidate = reinterpret_cast<const Header*>(file.getData());
+	}
+
+	header = candidate;
+	return true;
+}
+
+void my_vulkan::MeshCache::write(const std::string& modelPath, const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices, const MeshBounds& bounds, const std::vector<Submesh>& submeshes,
+	const std::vector<std::string>& materialLibraries)
+{
+	std::vector<SubmeshRecord> records;
+	std::string strings;
+	for (const auto& submesh : submeshes)
+	{
+		SubmeshRecord record{ submesh.firstIndex, submesh.indexCount, submesh.bounds };
+		record.materialOffset = static_cast<uint32_t>(strings.size());
+		record.materialLength = static_cast<uint32_t>(submesh.material.size());
+		strings += submesh.material;
+		record.texturePathOffset = static_cast<uint32_t>(strings.size());
+		record.texturePathLength = static_cast<uint32_t>(submesh.texturePath.size());
+		strings += submesh.texturePath;
+		records.push_back(record);
+	}
+	std::vector<MaterialLibraryRecord> libraries;
+	for (const auto& materialLibrary : materialLibraries)
+	{
+		MaterialLibraryRecord record{};
+		record.writeTime = getWriteTime(materialLibrary, record.size);
+		if (record.size != 0)
+			record.hash = hashFile(materialLibrary);
+		record.pathOffset = static_cast<uint32_t>(strings.size());
+		record.pathLength = static_cast<uint32_t>(materialLibrary.size());
+		strings += materialLibrary;
+		libraries.push_back(record);
+	}
+
+	Header fileHeader{};
+	fileHeader.magic = MAGIC;
+	fileHeader.version = VERSION;
+	fileHeader.vertexStride = sizeof(Vertex);
+	fileHeader.sourceWriteTime = getWriteTime(modelPath, fileHeader.sourceSize);
+	fileHeader.sourceHash = hashFile(modelPath);
+	fileHeader.vertexOffset = alignOffset(sizeof(Header));
+	fileHeader.vertexCount = vertices.size();
+	fileHeader.indexOffset = alignOffset(fileHeader.vertexOffset + vertices.size() * sizeof(Vertex));
+	fileHeader.indexCount = indices.size();
+	fileHeader.bounds = bounds;
+	fileHeader.submeshOffset = alignOffset(fileHeader.indexOffset + indices.size() * sizeof(uint32_t));
+	fileHeader.submeshCount = records.size();
+	fileHeader.materialLibraryOffset = fileHeader.submeshOffset + records.size() * sizeof(SubmeshRecord);
+	fileHeader.materialLibraryCount = libraries.size();
+	fileHeader.stringOffset = fileHeader.materialLibraryOffset + libraries.size() * sizeof(MaterialLibraryRecord);
+	fileHeader.stringSize = strings.size();
+
+	//Written to a temporary first so an interrupted run never leaves a half written cache behind
+	std::string cachePath = getCachePath(modelPath);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+		{
+			std::cout << "cannot write mesh cache : " << cachePath << std::endl;
+			return;
+		}
+
+		const char zeros[16]{};
+		out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(Header));
+		out.write(zeros, static_cast<std::streamsize>(fileHeader.vertexOffset - sizeof(Header)));
+		out.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(Vertex)));
+		out.write(zeros, static_cast<std::streamsize>(fileHeader.indexOffset - fileHeader.vertexOffset - vertices.size() * sizeof(Vertex)));
+		out.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+		out.write(zeros, static_cast<std::streamsize>(fileHeader.submeshOffset - fileHeader.indexOffset - indices.size() * sizeof(uint32_t)));
+		out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(SubmeshRecord)));
+		out.write(reinterpret_cast<const char*>(libraries.data()), static_cast<std::streamsize>(libraries.size() * sizeof(MaterialLibraryRecord)));
+		out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+		std::filesystem::remove(tempPath, error);
+}
+
+const my_vulkan::Vertex* my_vulkan::MeshCache::getVertices() const
+{
+	return reinterpret_cast<const Vertex*>(file.getData() + header->vertexOffset);
+}
+
+const uint32_t* my_vulkan::MeshCache::getIndices() const
+{
+	return reinterpret_cast<const uint32_t*>(file.getData() + header->indexOffset);
+}
+
+std::vector<my_vulkan::Submesh> my_vulkan::MeshCache::getSubmeshes() const
+{
+	const auto* records = reinterpret_cast<const SubmeshRecord*>(file.getData() + header->submeshOffset);
+	const char* strings = reinterpret_cast<const char*>(file.getData() + header->stringOffset);
+	std::vector<Submesh> submeshes(header->submeshCount);
+	for (size_t i = 0; i != submeshes.size(); ++i)
+	{
+		const SubmeshRecord& record = records[i];
+		submeshes[i].firstIndex = record.firstIndex;
+		submeshes[i].indexCount = record.indexCount;
+		submeshes[i].bounds = record.bounds;
+		submeshes[i].material.assign(strings + record.materialOffset, record.materialLength);
+		submeshes[i].texturePath.assign(strings + record.texturePathOffset, record.texturePathLength);
+	}
+	return submeshes;
+}
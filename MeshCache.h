@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "MappedFile.h"
+
+namespace my_vulkan
+{
+	struct Vertex;
+
+	struct MeshBounds
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	//The triangles of a mesh drawn with one material, firstIndex is relative to the mesh's own first index
+	struct Submesh
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		MeshBounds bounds{};
+		std::string material;
+		//the material's map_Kd relative to the working directory, empty without one
+		std::string texturePath;
+	};
+
+	//Binary mirror of a parsed .obj, written next to the source as "<model>.meshcache".
+	//Layout: Header | vertex blob | index blob | SubmeshRecords | MaterialLibraryRecords | string blob, the vertex and index
+	//blobs 16 byte aligned so they can be used straight from the mapping
+	class MeshCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x48534D4D; //"MMSH"
+		//2: vertices and indices are stored in MeshOptimizer order
+		//3: submeshes, one per material
+		//4: the mtllib the submeshes took their textures from, checked like the source
+		//5: every mtllib of the .obj
+		static constexpr uint32_t VERSION = 5;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vertexStride;
+			uint32_t reserved;
+			uint64_t sourceWriteTime;
+			uint64_t sourceSize;
+			uint64_t sourceHash;
+			uint64_t vertexOffset;
+			uint64_t vertexCount;
+			uint64_t indexOffset;
+			uint64_t indexCount;
+			MeshBounds bounds;
+			uint64_t submeshOffset;
+			uint64_t submeshCount;
+			uint64_t stringOffset;
+			uint64_t stringSize;
+			uint64_t materialLibraryOffset;
+			uint64_t materialLibraryCount;
+		};
+
+		//A Submesh with its names as ranges of the string blob
+		struct SubmeshRecord
+		{
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			MeshBounds bounds;
+			uint32_t materialOffset;
+			uint32_t materialLength;
+			uint32_t texturePathOffset;
+			uint32_t texturePathLength;
+		};
+
+		//An mtllib the submeshes took their materials from, checked like the source. The path is a range of the string
+		//blob, size 0 when the file was missing
+		struct MaterialLibraryRecord
+		{
+			uint64_t writeTime;
+			uint64_t size;
+			uint64_t hash;
+			uint32_t pathOffset;
+			uint32_t pathLength;
+		};
+
+		static std::string getCachePath(const std::string& modelPath) { return modelPath + ".meshcache"; }
+
+		//Maps the cache of modelPath, returns false when there is none or it or one of its mtllibs is stale
+		bool open(const std::string& modelPath);
+		void close() { file.close(); header = nullptr; }
+
+		static void write(const std::string& modelPath, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+			const MeshBounds& bounds, const std::vector<Submesh>& submeshes, const std::vector<std::string>& materialLibraries = {});
+
+		static MeshBounds computeBounds(const std::vector<Vertex>& vertices);
+		//Bounds of the vertices the indices reference
+		static MeshBounds computeBounds(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount);
+		static uint64_t hashFile(const std::string& filePath);
+
+		const Vertex* getVertices() const;
+		const uint32_t* getIndices() const;
+		uint64_t getVertexCount() const { return header->vertexCount; }
+		uint64_t getIndexCount() const { return header->indexCount; }
+		const MeshBounds& getBounds() const { return header->bounds; }
+		//Copied out of the mapping, there are only a handful
+		std::vector<Submesh> getSubmeshes() const;
+
+	private:
+		MappedFile file;
+		const Header* header = nullptr;
+	};
+}
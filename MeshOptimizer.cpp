@@ -0,0 +1,347 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <glm/glm.hpp>
+#include "MeshCache.h"
+#include "Vertex.h"
+
+namespace
+{
+	using my_vulkan::MeshOptimizer;
+
+	//FIFO post-transform cache, a vertex hits while fewer than FIFO_CACHE_SIZE misses happened since it was loaded
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount) : timestamps(vertexCount, 0) {}
+
+		//returns true on a miss
+		bool access(uint32_t vertex)
+		{
+			if (time - timestamps[vertex] <= MeshOptimizer::FIFO_CACHE_SIZE)
+				return false;
+			timestamps[vertex] = time++;
+			return true;
+		}
+		void reset() { time += MeshOptimizer::FIFO_CACHE_SIZE + 1; }
+
+	private:
+		std::vector<uint32_t> timestamps;
+		uint32_t time = MeshOptimizer::FIFO_CACHE_SIZE + 1;
+	};
+
+	//Forsyth's scoring, vertices of the last triangle get a fixed score so the next triangle does not just reuse its edge,
+	//low valence vertices get a boost so no lone triangles are left behind
+	float vertexScore(int32_t cachePosition, uint32_t valence)
+	{
+		if (valence == 0)
+			return -1.0f;
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (cachePosition - 3) / float(MeshOptimizer::CACHE_SIZE - 3), 1.5f);
+		}
+		return score + 2.0f / std::sqrt(float(valence));
+	}
+
+	uint32_t countMisses(FifoCache& cache, const uint32_t* indices, size_t begin, size_t end)
+	{
+		uint32_t misses = 0;
+		for (size_t i = begin * 3; i != end * 3; ++i)
+			misses += cache.access(indices[i]);
+		return misses;
+	}
+}
+
+void my_vulkan::MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	optimizeVertexCache(indices, vertices.size());
+	optimizeOverdraw(indices, vertices);
+	optimizeVertexFetch(vertices, indices);
+}
+
+void my_vulkan::MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes)
+{
+	if (submeshes.size() <= 1)
+	{
+		optimize(vertices, indices);
+		return;
+	}
+	std::vector<uint32_t> submeshIndices;
+	for (const auto& submesh : submeshes)
+	{
+		submeshIndices.assign(indices.begin() + submesh.firstIndex, indices.begin() + submesh.firstIndex + submesh.indexCount);
+		optimizeVertexCache(submeshIndices, vertices.size());
+		optimizeOverdraw(submeshIndices, vertices);
+		std::copy(submeshIndices.begin(), submeshIndices.end(), indices.begin() + submesh.firstIndex);
+	}
+	//first use order over all submeshes, which are drawn from the same vertex buffer
+	optimizeVertexFetch(vertices, indices);
+}
+
+void my_vulkan::MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	//triangles of every vertex, the first liveCounts[v] of them are not emitted yet
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	for (uint32_t index : indices)
+		++liveCounts[index];
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v != vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + liveCounts[v];
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i != indices.size(); ++i)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v != vertexCount; ++v)
+		vertexScores[v] = vertexScore(-1, liveCounts[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	size_t best = 0;
+	for (size_t t = 0; t != triangleCount; ++t)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best])
+			best = t;
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	//the triangle's vertices go in front, so the cache briefly holds up to three entries too many
+	std::array<uint32_t, CACHE_SIZE + 3> cache;
+	std::array<uint32_t, CACHE_SIZE + 3> newCache;
+	size_t cacheCount = 0;
+	size_t inputCursor = 0;
+
+	while (true)
+	{
+		const uint32_t* triangle = &indices[best * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+		emitted[best] = 1;
+
+		for (int k = 0; k != 3; ++k)
+		{
+			uint32_t* live = &adjacency[offsets[triangle[k]]];
+			uint32_t& liveCount = liveCounts[triangle[k]];
+			auto it = std::find(live, live + liveCount, static_cast<uint32_t>(best));
+			std::swap(*it, live[liveCount - 1]);
+			--liveCount;
+		}
+
+		size_t newCount = 0;
+		for (int k = 0; k != 3; ++k)
+			if (std::find(newCache.begin(), newCache.begin() + newCount, triangle[k]) == newCache.begin() + newCount)
+				newCache[newCount++] = triangle[k];
+		for (size_t i = 0; i != cacheCount; ++i)
+			if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+				newCache[newCount++] = cache[i];
+
+		//rescore everything that moved, including what just fell out
+		for (size_t i = 0; i != newCount; ++i)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			float score = vertexScore(cachePositions[vertex], liveCounts[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			for (uint32_t j = 0; j != liveCounts[vertex]; ++j)
+				triangleScores[adjacency[offsets[vertex] + j]] += delta;
+		}
+		cacheCount = std::min<size_t>(newCount, CACHE_SIZE);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+		//the best candidate is almost always next to the cache, only fall back to the input order when nothing is
+		float bestScore = -1.0f;
+		size_t next = triangleCount;
+		for (size_t i = 0; i != cacheCount; ++i)
+		{
+			uint32_t vertex = cache[i];
+			for (uint32_t j = 0; j != liveCounts[vertex]; ++j)
+			{
+				uint32_t t = adjacency[offsets[vertex] + j];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					next = t;
+				}
+			}
+		}
+		if (next == triangleCount)
+		{
+			while (inputCursor != triangleCount && emitted[inputCursor])
+				++inputCursor;
+			if (inputCursor == triangleCount)
+				break;
+			next = inputCursor;
+		}
+		best = next;
+	}
+
+	indices.swap(result);
+}
+
+void my_vulkan::MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	//hard boundaries where the simulated cache missed all three vertices, reordering there costs no reuse at all
+	std::vector<size_t> clusters = { 0 };
+	FifoCache cache(vertices.size());
+	for (size_t t = 0; t != triangleCount; ++t)
+		if (countMisses(cache, indices.data(), t, t + 1) == 3 && t != 0)
+			clusters.push_back(t);
+	clusters.push_back(triangleCount);
+
+	//split further wherever the run since the last split already has an ACMR within threshold of its hard cluster's,
+	//each piece then starts from a cold cache and stays within threshold
+	std::vector<size_t> softClusters;
+	for (size_t c = 0; c + 1 != clusters.size(); ++c)
+	{
+		size_t begin = clusters[c], end = clusters[c + 1];
+		cache.reset();
+		float target = countMisses(cache, indices.data(), begin, end) / float(end - begin) * threshold;
+
+		size_t first = softClusters.size();
+		softClusters.push_back(begin);
+		cache.reset();
+		uint32_t misses = 0;
+		for (size_t t = begin; t != end; ++t)
+		{
+			misses += countMisses(cache, indices.data(), t, t + 1);
+			if (t + 1 != end && misses <= target * (t + 1 - softClusters.back()))
+			{
+				softClusters.push_back(t + 1);
+				cache.reset();
+				misses = 0;
+			}
+		}
+		//a tail worse than the target joins the piece before it
+		if (softClusters.size() - first > 1 && misses > target * (end - softClusters.back()))
+			softClusters.pop_back();
+	}
+	softClusters.push_back(triangleCount);
+
+	size_t clusterCount = softClusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<glm::vec3> centroids(clusterCount);
+	std::vector<glm::vec3> normals(clusterCount);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c != clusterCount; ++c)
+	{
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = softClusters[c]; t != softClusters[c + 1]; ++t)
+		{
+			const glm::vec3& a = vertices[indices[t * 3]].pos;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& v = vertices[indices[t * 3 + 2]].pos;
+			glm::vec3 cross = glm::cross(b - a, v - a);
+			float triangleArea = glm::length(cross);
+			centroid += (a + b + v) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids[c] = area > 0.0f ? centroid / area : centroid;
+		normals[c] = normal;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	//clusters far out along their own normal are likely in front of the rest, drawing them first lets depth testing reject more
+	for (size_t c = 0; c != clusterCount; ++c)
+	{
+		float length = glm::length(normals[c]);
+		sortKeys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+	}
+
+	std::vector<size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (size_t c : order)
+		result.insert(result.end(), indices.begin() + softClusters[c] * 3, indices.begin() + softClusters[c + 1] * 3);
+	indices.swap(result);
+}
+
+void my_vulkan::MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), ~0u);
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == ~0u)
+		{
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+my_vulkan::MeshOptimizerStats my_vulkan::MeshOptimizer::analyze(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexStride)
+{
+	MeshOptimizerStats stats;
+	if (indexCount == 0 || vertexCount == 0)
+		return stats;
+
+	//4KB of fully associative LRU cache lines in front of the vertex buffer, only shader invocations fetch
+	constexpr size_t LINE_COUNT = 64;
+	std::array<size_t, LINE_COUNT> lines;
+	std::array<uint64_t, LINE_COUNT> lastUse{};
+	lines.fill(~size_t(0));
+	uint64_t time = 0;
+	size_t lineMisses = 0;
+
+	FifoCache cache(vertexCount);
+	size_t misses = 0;
+	for (size_t i = 0; i != indexCount; ++i)
+	{
+		if (!cache.access(indices[i]))
+			continue;
+		++misses;
+		size_t firstLine = indices[i] * vertexStride / CACHE_LINE_SIZE;
+		size_t lastLine = ((indices[i] + 1) * vertexStride - 1) / CACHE_LINE_SIZE;
+		for (size_t line = firstLine; line <= lastLine; ++line)
+		{
+			++time;
+			auto hit = std::find(lines.begin(), lines.end(), line);
+			if (hit != lines.end())
+			{
+				lastUse[hit - lines.begin()] = time;
+				continue;
+			}
+			size_t victim = std::min_element(lastUse.begin(), lastUse.end()) - lastUse.begin();
+			lines[victim] = line;
+			lastUse[victim] = time;
+			++lineMisses;
+		}
+	}
+
+	stats.acmr = misses / float(indexCount / 3);
+	stats.atvr = misses / float(vertexCount);
+	stats.overfetch = lineMisses * CACHE_LINE_SIZE / float(vertexCount * vertexStride);
+	return stats;
+}
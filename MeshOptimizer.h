@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_vulkan
+{
+	struct Vertex;
+	struct Submesh;
+
+	struct MeshOptimizerStats
+	{
+		//vertex shader invocations per triangle, 0.5 is the ideal for a regular grid and 3 means no reuse at all
+		float acmr = 0.0f;
+		//vertex shader invocations per vertex, 1 is the ideal
+		float atvr = 0.0f;
+		//vertex buffer bytes fetched over its size, 1 when every cache line is read once
+		float overfetch = 0.0f;
+	};
+
+	//Reorders the triangles of an indexed mesh for the post-transform vertex cache (Forsyth), then in clusters so outward
+	//facing ones draw first without losing more than threshold of that reuse, then the vertices into first-use order.
+	//Only the order changes, the set of triangles stays the same. Runs on the cpu when a mesh is parsed, before MeshCache
+	class MeshOptimizer
+	{
+	public:
+		//the LRU the Forsyth scores assume
+		static constexpr uint32_t CACHE_SIZE = 32;
+		//the FIFO analyze and the cluster split simulate, the size of older hardware
+		static constexpr uint32_t FIFO_CACHE_SIZE = 16;
+		static constexpr uint32_t CACHE_LINE_SIZE = 64;
+		static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+		static void optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		//Triangles only move within their submesh, so the ranges stay valid
+		static void optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<Submesh>& submeshes);
+
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+		//Expects indices already optimized for the vertex cache, threshold is the ACMR increase allowed per cluster
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = OVERDRAW_THRESHOLD);
+		//Drops unreferenced vertices and rewrites indices to match
+		static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		static MeshOptimizerStats analyze(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexStride);
+	};
+}
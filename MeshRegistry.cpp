@@ -0,0 +1,143 @@
+#include "MeshRegistry.h"
+
+#include <algorithm>
+#include <cstring>
+#include "Model.h"
+#include "VulkanUtils.h"
+
+std::shared_ptr<my_vulkan::Mesh> my_vulkan::MeshRegistry::find(const std::string& modelPath, VertexFormat format)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = paths.find(getPathKey(modelPath, format));
+	return it == paths.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<my_vulkan::Mesh> my_vulkan::MeshRegistry::acquire(const std::string& modelPath, const MeshData& meshData,
+	const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+{
+	uint64_t hash = hashContents(meshData);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto range = meshes.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (!equalContents(it->second, meshData))
+			continue;
+		++sharedCount;
+		paths[getPathKey(modelPath, meshData.format)] = it->second.mesh;
+		return it->second.mesh;
+	}
+
+	uint32_t vertexCount = static_cast<uint32_t>(meshData.getVertexCount());
+	uint32_t indexCount = static_cast<uint32_t>(meshData.getIndexCount());
+	uint32_t pageIndex = reservePage(vertexCount, indexCount, meshData.format, device);
+	GeometryPage& page = pages[pageIndex];
+	auto mesh = std::make_shared<Mesh>(modelPath, meshData, uploader, pageIndex, page.vertexBuffer, static_cast<int32_t>(page.vertexCount),
+		page.indexBuffer, page.indexCount);
+	page.vertexCount += vertexCount;
+	page.indexCount += indexCount;
+	RegisteredMesh registered{ mesh, meshData.format };
+	const uint8_t* vertexData = static_cast<const uint8_t*>(meshData.getVertexData());
+	registered.vertexData.assign(vertexData, vertexData + meshData.getVertexStride() * vertexCount);
+	registered.indices.assign(meshData.getIndices(), meshData.getIndices() + indexCount);
+	registered.quantization = meshData.quantization;
+	registered.submeshes = meshData.submeshes;
+	meshes.emplace(hash, std::move(registered));
+	paths[getPathKey(modelPath, meshData.format)] = mesh;
+	return mesh;
+}
+
+uint32_t my_vulkan::MeshRegistry::reservePage(uint32_t vertexCount, uint32_t indexCount, VertexFormat format, const std::shared_ptr<VulkanDevice>& device)
+{
+	for (uint32_t i = 0; i != pages.size(); ++i)
+		if (pages[i].format == format && pages[i].vertexCount + vertexCount <= pages[i].vertexCapacity &&
+			pages[i].indexCount + indexCount <= pages[i].indexCapacity)
+			return i;
+
+	GeometryPage page{};
+	page.vertexCapacity = std::max(PAGE_VERTEX_COUNT, vertexCount);
+	page.indexCapacity = std::max(PAGE_INDEX_COUNT, indexCount);
+	page.format = format;
+	VulkanUtils::createBuffer(device, page.vertexBuffer, page.vertexBufferAllocation, getVertexStride(format) * page.vertexCapacity,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	VulkanUtils::createBuffer(device, page.indexBuffer, page.indexBufferAllocation, sizeof(uint32_t) * page.indexCapacity,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	pages.push_back(page);
+	return static_cast<uint32_t>(pages.size() - 1);
+}
+
+uint64_t my_vulkan::MeshRegistry::hashContents(const MeshData& meshData)
+{
+	//FNV-1a over the vertex blob then the index blob, the counts are mixed in so the split point matters
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	uint64_t counts[3] = { meshData.getVertexCount(), meshData.getIndexCount(), meshData.getVertexStride() };
+	mix(counts, sizeof(counts));
+	mix(meshData.getVertexData(), meshData.getVertexStride() * meshData.getVertexCount());
+	mix(meshData.getIndices(), sizeof(uint32_t) * meshData.getIndexCount());
+	//equal 16 bit positions decode to different places under different bounds
+	if (meshData.format == VertexFormat::COMPRESSED)
+	{
+		float decode[4] = { meshData.quantization.offset.x, meshData.quantization.offset.y, meshData.quantization.offset.z,
+			meshData.quantization.extent };
+		mix(decode, sizeof(decode));
+	}
+	//the same triangles split or textured differently are a different mesh, objects take their materials from it
+	for (const auto& submesh : meshData.submeshes)
+	{
+		uint32_t range[2] = { submesh.firstIndex, submesh.indexCount };
+		mix(range, sizeof(range));
+		mix(submesh.material.data(), submesh.material.size() + 1);
+		mix(submesh.texturePath.data(), submesh.texturePath.size() + 1);
+	}
+	return hash;
+}
+
+bool my_vulkan::MeshRegistry::equalContents(const RegisteredMesh& registered, const MeshData& meshData)
+{
+	if (registered.format != meshData.format || registered.vertexData.size() != meshData.getVertexStride() * meshData.getVertexCount() ||
+		registered.indices.size() != meshData.getIndexCount() || registered.submeshes.size() != meshData.submeshes.size())
+		return false;
+	if (std::memcmp(registered.vertexData.data(), meshData.getVertexData(), registered.vertexData.size()) != 0 ||
+		std::memcmp(registered.indices.data(), meshData.getIndices(), sizeof(uint32_t) * registered.indices.size()) != 0)
+		return false;
+	if (meshData.format == VertexFormat::COMPRESSED && (registered.quantization.offset != meshData.quantization.offset ||
+		registered.quantization.extent != meshData.quantization.extent))
+		return false;
+	for (size_t i = 0; i != registered.submeshes.size(); ++i)
+	{
+		const Submesh& a = registered.submeshes[i];
+		const Submesh& b = meshData.submeshes[i];
+		if (a.firstIndex != b.firstIndex || a.indexCount != b.indexCount || a.material != b.material || a.texturePath != b.texturePath)
+			return false;
+	}
+	return true;
+}
+
+std::string my_vulkan::MeshRegistry::getPathKey(const std::string& modelPath, VertexFormat format)
+{
+	return format == VertexFormat::COMPRESSED ? modelPath + "#compressed" : modelPath;
+}
+
+void my_vulkan::MeshRegistry::destroyRegistry(const VkDevice& device)
+{
+	for (auto& mesh : meshes)
+		mesh.second.mesh->destroyModel(device);
+	for (auto& page : pages)
+	{
+		VulkanUtils::destroyBuffer(device, page.vertexBuffer, page.vertexBufferAllocation);
+		VulkanUtils::destroyBuffer(device, page.indexBuffer, page.indexBufferAllocation);
+	}
+	meshes.clear();
+	paths.clear();
+	pages.clear();
+}
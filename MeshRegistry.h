@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "VulkanAllocator.h"
+#include "Vertex.h"
+#include "MeshCache.h"
+
+namespace my_vulkan
+{
+	class Mesh;
+	class VulkanDevice;
+	class VulkanUploader;
+	struct MeshData;
+
+	//Hands out one Mesh per distinct geometry. Meshes are looked up by path first and then by a hash of their
+	//vertex and index data, so two objects loading the same model (or two copies of it) share one set of GPU buffers.
+	//A hash hit is compared byte for byte against a cpu copy of the registered contents, so a collision uploads a second
+	//mesh instead of drawing the wrong one.
+	//Meshes are packed into large shared vertex and index buffers (geometry pages) so consecutive draws need no
+	//rebinding and indirect draws can address any mesh by firstIndex and vertexOffset. Every page holds one VertexFormat,
+	//a model loaded in both formats is two meshes.
+	//The registry owns the meshes, objects never destroy them
+	class MeshRegistry
+	{
+	public:
+		static constexpr uint32_t PAGE_VERTEX_COUNT = 1024 * 1024;
+		static constexpr uint32_t PAGE_INDEX_COUNT = 4 * 1024 * 1024;
+
+		struct GeometryPage
+		{
+			VkBuffer vertexBuffer;
+			VulkanAllocation vertexBufferAllocation;
+			VkBuffer indexBuffer;
+			VulkanAllocation indexBufferAllocation;
+			uint32_t vertexCapacity;
+			uint32_t indexCapacity;
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			VertexFormat format = VertexFormat::FULL;
+		};
+
+		//Returns the mesh already loaded from modelPath in format, or null
+		std::shared_ptr<Mesh> find(const std::string& modelPath, VertexFormat format = VertexFormat::FULL);
+
+		//Uploads meshData unless a mesh with identical contents is registered, either way modelPath in meshData's format maps to the result
+		std::shared_ptr<Mesh> acquire(const std::string& modelPath, const MeshData& meshData, const std::shared_ptr<VulkanDevice>& device,
+			VulkanUploader* uploader);
+
+		size_t getMeshCount() const { return meshes.size(); }
+		uint32_t getGeometryPageCount() const { return static_cast<uint32_t>(pages.size()); }
+		const GeometryPage& getGeometryPage(uint32_t page) const { return pages[page]; }
+		uint32_t getSharedCount() const { return sharedCount; }
+
+		static uint64_t hashContents(const MeshData& meshData);
+
+		void destroyRegistry(const VkDevice& device);
+
+	private:
+		//Index of a page with room for the mesh, a new one is created when none has (oversized meshes get a page of their own)
+		uint32_t reservePage(uint32_t vertexCount, uint32_t indexCount, VertexFormat format, const std::shared_ptr<VulkanDevice>& device);
+		static std::string getPathKey(const std::string& modelPath, VertexFormat format);
+
+		//What a mesh was uploaded from, everything hashContents reads
+		struct RegisteredMesh
+		{
+			std::shared_ptr<Mesh> mesh;
+			VertexFormat format;
+			std::vector<uint8_t> vertexData;
+			std::vector<uint32_t> indices;
+			VertexQuantization quantization;
+			std::vector<Submesh> submeshes;
+		};
+		static bool equalContents(const RegisteredMesh& registered, const MeshData& meshData);
+
+		std::mutex mutex;
+		std::vector<GeometryPage> pages;
+		std::unordered_multimap<uint64_t, RegisteredMesh> meshes;
+		std::unordered_map<std::string, std::shared_ptr<Mesh>> paths;
+		uint32_t sharedCount = 0;
+	};
+}
@@ -1,95 +1,102 @@
-#define TINYOBJLOADER_IMPLEMENTATION
 #include "Model.h"
 
+#include <chrono>
 #include <iostream>
-#include <tiny_obj_loader.h>
-#include <unordered_map>
 #include "VulkanUtils.h"
 #include "Texture.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
 #include "Vertex.h"
+#include "VulkanUploader.h"
 #include "glm/gtx/io.hpp"
 
-my_vulkan::Mesh::Mesh(const std::string& model_path, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool) : modelPath(model_path)
+std::shared_ptr<my_vulkan::MeshData> my_vulkan::MeshData::load(const std::string& modelPath, ThreadPool* threadPool)
 {
-	loadModel();
-	createBuffers(device, commandPool);
-}
-
-void my_vulkan::Mesh::loadModel()
-{
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
+	auto start = std::chrono::high_resolution_clock::now();
 
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath.data()))
-		throw std::runtime_error(warn + err);
-
-	std::unordered_map<Vertex, int32_t> uniqueVertices{};
-
-	for (const auto& shape : shapes)
+	auto meshData = std::make_shared<MeshData>();
+	if (meshData->cache.open(modelPath))
 	{
-		for(const auto& index : shape.mesh.indices)
-		{
-			Vertex vertex{};
-			vertex.pos = {
-			attrib.vertices[3 * index.vertex_index + 0],
-			attrib.vertices[3 * index.vertex_index + 1],
-			attrib.vertices[3 * index.vertex_index + 2]
-			};
-
-			vertex.normal = {
-			attrib.normals[3 * index.normal_index + 0],
-			attrib.normals[3 * index.normal_index + 1],
-			attrib.normals[3 * index.normal_index + 2]
-			};
-
-			vertex.texCoord = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+		//the mesh is uploaded straight from the mapped pages, the cpu side copies are never materialized
+		meshData->loadedFromCache = true;
+		meshData->bounds = meshData->cache.getBounds();
+		meshData->submeshes = meshData->cache.getSubmeshes();
+	}
+	else
+	{
+		std::vector<std::string> materialLibraries;
+		Mesh::parseObj(modelPath, meshData->vertices, meshData->indices, threadPool, &meshData->submeshes, &materialLibraries);
+		//the cache stores the optimized order, so this only runs the first time a model is seen
+		MeshOptimizer::optimize(meshData->vertices, meshData->indices, meshData->submeshes);
+		meshData->bounds = MeshCache::computeBounds(meshData->vertices);
+		MeshCache::write(modelPath, meshData->vertices, meshData->indices, meshData->bounds, meshData->submeshes, materialLibraries);
+	}
 
-	
+	meshData->loadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return meshData;
+}
 
-			if(uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-		
-			}
-	
-			indices.push_back(uniqueVertices[vertex]);
-		}
-	}
+void my_vulkan::MeshData::compress()
+{
+	quantization = VertexQuantization::fromBounds(bounds.min, bounds.max);
+	const Vertex* source = getVertices();
+	compressedVertices.resize(getVertexCount());
+	for (size_t i = 0; i != compressedVertices.size(); ++i)
+		compressedVertices[i] = CompressedVertex::encode(source[i], quantization);
+	format = VertexFormat::COMPRESSED;
 }
 
-void my_vulkan::Mesh::createBuffers(const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
+const void* my_vulkan::MeshData::getVertexData() const
 {
-	VulkanUtils::createVertexBuffer(vertices, vertexBuffer, vertexBufferMemory, device, commandPool);
-	VulkanUtils::createIndexBuffer(indices, indexBuffer, indexBufferMemory, device, commandPool);
+	if (format == VertexFormat::COMPRESSED)
+		return compressedVertices.data();
+	return getVertices();
 }
 
-std::vector<my_vulkan::Vertex> my_vulkan::Mesh::getVertices() const
+my_vulkan::Mesh::Mesh(const std::string& model_path, const MeshData& meshData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+	: modelPath(model_path), bounds(meshData.bounds), submeshes(meshData.submeshes), boundingSphere(computeBoundingSphere(meshData.bounds)),
+	loadedFromCache(meshData.loadedFromCache), vertexFormat(meshData.format), quantization(meshData.quantization)
 {
-	return vertices; 
+	createBuffers(meshData, device, uploader);
 }
 
-void my_vulkan::Mesh::destroyModel(const VkDevice& device)
+my_vulkan::Mesh::Mesh(const std::string& model_path, const MeshData& meshData, VulkanUploader* uploader, uint32_t geometryPage,
+	VkBuffer vertexBuffer, int32_t vertexOffset, VkBuffer indexBuffer, uint32_t firstIndex)
+	: modelPath(model_path), indexCount(static_cast<uint32_t>(meshData.getIndexCount())), firstIndex(firstIndex), vertexOffset(vertexOffset),
+	geometryPage(geometryPage), ownsBuffers(false), bounds(meshData.bounds), submeshes(meshData.submeshes), boundingSphere(computeBoundingSphere(meshData.bounds)),
+	loadedFromCache(meshData.loadedFromCache), vertexFormat(meshData.format), quantization(meshData.quantization),
+	vertexBuffer(vertexBuffer), indexBuffer(indexBuffer)
 {
-	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
-	vkDestroyBuffer(device, indexBuffer, nullptr);
-	vkFreeMemory(device, indexBufferMemory, nullptr);
+	uploader->uploadBuffer(vertexBuffer, meshData.getVertexData(), meshData.getVertexStride() * meshData.getVertexCount(),
+		meshData.getVertexStride() * vertexOffset);
+	uploader->uploadBuffer(indexBuffer, meshData.getIndices(), sizeof(uint32_t) * indexCount, sizeof(uint32_t) * firstIndex);
 }
 
-void my_vulkan::Mesh::Render(const VkCommandBuffer& commandBuffer)
+glm::vec4 my_vulkan::Mesh::computeBoundingSphere(const MeshBounds& bounds)
 {
-	VkBuffer vertexBuffers[] = { vertexBuffer };
-	VkDeviceSize offsets[] = { 0 };
+	glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+	return glm::vec4(center, glm::length(bounds.max - center));
+}
 
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+void my_vulkan::Mesh::parseObj(const std::string& model_path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+	ThreadPool* threadPool, std::vector<Submesh>* submeshes, std::vector<std::string>* materialLibraries)
+{
+	ObjParser::parse(model_path, vertices, indices, threadPool, submeshes, materialLibraries);
+}
 
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VkIndexType::VK_INDEX_TYPE_UINT32);
+void my_vulkan::Mesh::createBuffers(const MeshData& meshData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+{
+	indexCount = static_cast<uint32_t>(meshData.getIndexCount());
+	VulkanUtils::createDeviceLocalBuffer(meshData.getVertexData(), meshData.getVertexStride() * meshData.getVertexCount(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		vertexBuffer, vertexBufferAllocation, device, uploader);
+	VulkanUtils::createDeviceLocalBuffer(meshData.getIndices(), sizeof(uint32_t) * indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		indexBuffer, indexBufferAllocation, device, uploader);
+}
 
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+void my_vulkan::Mesh::destroyModel(const VkDevice& device)
+{
+	if (!ownsBuffers)
+		return;
+	VulkanUtils::destroyBuffer(device, vertexBuffer, vertexBufferAllocation);
+	VulkanUtils::destroyBuffer(device, indexBuffer, indexBufferAllocation);
 }
@@ -4,37 +4,84 @@
 #include <string>
 #include <vector>
 #include "Vertex.h"
+#include "MeshCache.h"
+#include "VulkanAllocator.h"
 #include <vulkan/vulkan.h>
 
 namespace my_vulkan
 {
 	class VulkanDevice;
+	class VulkanUploader;
 	class Texture;
+	class ThreadPool;
 
-	class Mesh
+	//CPU side geometry of one model, either parsed from the .obj or mapped from its MeshCache.
+	//Produced on a loader thread and consumed by Mesh on the main thread
+	struct MeshData
 	{
-	public:
-		Mesh(const std::string& model_path, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
-		void loadModel();
+		//With a thread pool a model that is not cached yet is parsed in chunks on it, the pool may be the one load runs on
+		static std::shared_ptr<MeshData> load(const std::string& modelPath, ThreadPool* threadPool = nullptr);
 
-		void createBuffers(const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
+		const Vertex* getVertices() const { return loadedFromCache ? cache.getVertices() : vertices.data(); }
+		const uint32_t* getIndices() const { return loadedFromCache ? cache.getIndices() : indices.data(); }
+		size_t getVertexCount() const { return loadedFromCache ? cache.getVertexCount() : vertices.size(); }
+		size_t getIndexCount() const { return loadedFromCache ? cache.getIndexCount() : indices.size(); }
 
-		std::vector<Vertex> getVertices() const;
-		std::vector<uint32_t> getIndices() const { return indices; }
+		//Encodes the vertices into compressedVertices against the bounds, the vertex data then is the compressed one
+		void compress();
+		//What goes into the vertex buffer, getVertexStride bytes per vertex
+		const void* getVertexData() const;
+		size_t getVertexStride() const { return my_vulkan::getVertexStride(format); }
 
-		void destroyModel(const VkDevice& device);
+		std::vector<Vertex> vertices;
+		std::vector<CompressedVertex> compressedVertices;
+		VertexFormat format = VertexFormat::FULL;
+		VertexQuantization quantization;
+		std::vector<uint32_t> indices;
+		//one per material of the .obj, together they cover every index
+		std::vector<Submesh> submeshes;
+		MeshCache cache;
+		MeshBounds bounds{};
+		bool loadedFromCache = false;
+		float loadTime = 0.0f;
+	};
 
-		void Render(const VkCommandBuffer& commandBuffer);
+	class Mesh
+	{
+	public:
+		Mesh(const std::string& model_path, const MeshData& meshData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		//Uploads into buffers owned by someone else (the MeshRegistry's geometry pages), starting at vertexOffset and firstIndex
+		Mesh(const std::string& model_path, const MeshData& meshData, VulkanUploader* uploader, uint32_t geometryPage,
+			VkBuffer vertexBuffer, int32_t vertexOffset, VkBuffer indexBuffer, uint32_t firstIndex);
+		//See ObjParser::parse
+		static void parseObj(const std::string& model_path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+			ThreadPool* threadPool = nullptr, std::vector<Submesh>* submeshes = nullptr, std::vector<std::string>* materialLibraries = nullptr);
+		static glm::vec4 computeBoundingSphere(const MeshBounds& bounds);
+
+		void createBuffers(const MeshData& meshData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
 
+		void destroyModel(const VkDevice& device);
 
 		std::string modelPath;
 
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
+		uint32_t indexCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t vertexOffset = 0;
+		uint32_t geometryPage = 0;
+		bool ownsBuffers = true;
+		MeshBounds bounds{};
+		//firstIndex relative to the mesh's own
+		std::vector<Submesh> submeshes;
+		//mesh space center and radius enclosing bounds, for frustum culling
+		glm::vec4 boundingSphere{};
+		bool loadedFromCache = false;
+		VertexFormat vertexFormat = VertexFormat::FULL;
+		//only meaningful for COMPRESSED, the bindless model matrix of every draw is multiplied by its getMatrix
+		VertexQuantization quantization;
 		VkBuffer vertexBuffer;
-		VkDeviceMemory vertexBufferMemory;
+		VulkanAllocation vertexBufferAllocation;
 		VkBuffer indexBuffer;
-		VkDeviceMemory indexBufferMemory;
+		VulkanAllocation indexBufferAllocation;
 	};
 }
 
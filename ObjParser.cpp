@@ -0,0 +1,590 @@
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <stdexcept>
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "Vertex.h"
+#include "VertexWelder.h"
+
+namespace
+{
+	//0 based into the whole file, -1 when the face leaves it out
+	struct ObjCorner
+	{
+		int32_t position;
+		int32_t texCoord;
+		int32_t normal;
+	};
+
+	enum class ObjLine
+	{
+		POSITION,
+		TEXCOORD,
+		NORMAL,
+		FACE,
+		USEMTL,
+		MTLLIB,
+		OTHER
+	};
+
+	struct ObjChunk
+	{
+		const char* begin;
+		const char* end;
+		//v, vt and vn lines in this chunk
+		size_t positionCount = 0;
+		size_t texCoordCount = 0;
+		size_t normalCount = 0;
+		//how many of each come before this chunk
+		size_t positionBase = 0;
+		size_t texCoordBase = 0;
+		size_t normalBase = 0;
+		//three per triangle
+		std::vector<ObjCorner> corners;
+		//usemtl lines, the material applies from that corner on
+		std::vector<std::pair<size_t, std::string>> materialChanges;
+		//every file named by the mtllib lines, in order
+		std::vector<std::string> materialLibraries;
+	};
+
+	//faces from start on use material, until the next run
+	struct MaterialRun
+	{
+		uint32_t material;
+		size_t start;
+	};
+
+	struct ObjAttributes
+	{
+		std::vector<float> positions;
+		std::vector<float> texCoords;
+		std::vector<float> normals;
+	};
+
+	bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p != end && isSpace(*p))
+			++p;
+		return p;
+	}
+
+	const char* findLineEnd(const char* p, const char* end)
+	{
+		const void* newline = std::memchr(p, '\n', end - p);
+		return newline ? static_cast<const char*>(newline) : end;
+	}
+
+	//The rest of the line without surrounding spaces
+	std::string lineArgument(const char* p, const char* lineEnd)
+	{
+		p = skipSpaces(p, lineEnd);
+		while (lineEnd != p && isSpace(lineEnd[-1]))
+			--lineEnd;
+		return std::string(p, lineEnd);
+	}
+
+	//The whitespace separated words of the rest of the line
+	std::vector<std::string> lineArguments(const char* p, const char* lineEnd)
+	{
+		std::vector<std::string> arguments;
+		for (p = skipSpaces(p, lineEnd); p != lineEnd; p = skipSpaces(p, lineEnd))
+		{
+			const char* wordEnd = p;
+			while (wordEnd != lineEnd && !isSpace(*wordEnd))
+				++wordEnd;
+			arguments.emplace_back(p, wordEnd);
+			p = wordEnd;
+		}
+		return arguments;
+	}
+
+	//Skips the options of a texture map statement like "map_Kd -s 2 2 -clamp on file.png", p is left on the file name.
+	//Unknown options are taken to be part of the file name
+	const char* skipTextureOptions(const char* p, const char* lineEnd)
+	{
+		//option and how many arguments it takes, -o, -s and -t take one to three numbers
+		static const std::pair<const char*, int> options[] = { { "-blendu", 1 }, { "-blendv", 1 }, { "-bm", 1 }, { "-boost", 1 },
+			{ "-cc", 1 }, { "-clamp", 1 }, { "-imfchan", 1 }, { "-mm", 2 }, { "-o", 3 }, { "-s", 3 }, { "-t", 3 }, { "-texres", 1 },
+			{ "-type", 1 } };
+		auto wordEnd = [lineEnd](const char* word)
+		{
+			while (word != lineEnd && !isSpace(*word))
+				++word;
+			return word;
+		};
+
+		for (p = skipSpaces(p, lineEnd); p != lineEnd && *p == '-'; )
+		{
+			const char* optionEnd = wordEnd(p);
+			std::string option(p, optionEnd);
+			auto known = std::find_if(std::begin(options), std::end(options), [&option](const auto& entry) { return option == entry.first; });
+			if (known == std::end(options))
+				break;
+			p = skipSpaces(optionEnd, lineEnd);
+			bool vector = known->second == 3;
+			for (int i = 0; i != known->second && p != lineEnd; ++i)
+			{
+				const char* argumentEnd = wordEnd(p);
+				//the v and w of -o, -s and -t are optional, the file name may follow right after u
+				if (vector && i != 0)
+				{
+					float number;
+					auto result = std::from_chars(*p == '+' ? p + 1 : p, argumentEnd, number);
+					if (result.ec != std::errc() || result.ptr != argumentEnd)
+						break;
+				}
+				p = skipSpaces(argumentEnd, lineEnd);
+			}
+		}
+		return p;
+	}
+
+	//Everything up to and including the last slash
+	std::string getDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	}
+
+	//p is the first non space character of the line and is left after the keyword
+	ObjLine classifyLine(const char*& p, const char* lineEnd)
+	{
+		size_t length = lineEnd - p;
+		if (length >= 2 && p[0] == 'v' && isSpace(p[1]))
+		{
+			p += 1;
+			return ObjLine::POSITION;
+		}
+		if (length >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+		{
+			p += 2;
+			return ObjLine::TEXCOORD;
+		}
+		if (length >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+		{
+			p += 2;
+			return ObjLine::NORMAL;
+		}
+		if (length >= 2 && p[0] == 'f' && isSpace(p[1]))
+		{
+			p += 1;
+			return ObjLine::FACE;
+		}
+		if (length >= 7 && std::memcmp(p, "usemtl", 6) == 0 && isSpace(p[6]))
+		{
+			p += 6;
+			return ObjLine::USEMTL;
+		}
+		if (length >= 7 && std::memcmp(p, "mtllib", 6) == 0 && isSpace(p[6]))
+		{
+			p += 6;
+			return ObjLine::MTLLIB;
+		}
+		return ObjLine::OTHER;
+	}
+
+	//Missing trailing components stay 0, like the w of a position or the v of a 1D texCoord
+	void parseFloats(const char* p, const char* lineEnd, float* values, size_t count)
+	{
+		for (size_t i = 0; i != count; ++i)
+		{
+			p = skipSpaces(p, lineEnd);
+			if (p == lineEnd)
+				return;
+			//from_chars takes no leading plus
+			if (*p == '+')
+				++p;
+			auto result = std::from_chars(p, lineEnd, values[i]);
+			if (result.ec != std::errc())
+				throw std::runtime_error("malformed number in obj line: " + std::string(p, lineEnd));
+			p = result.ptr;
+		}
+	}
+
+	//OBJ indices start at 1 and negative ones count back from the last element defined so far
+	int32_t resolveIndex(const char*& p, const char* tokenEnd, size_t definedCount, size_t totalCount)
+	{
+		int32_t value = 0;
+		auto result = std::from_chars(p, tokenEnd, value);
+		if (result.ec != std::errc() || value == 0)
+			throw std::runtime_error("malformed face index in obj line: " + std::string(p, tokenEnd));
+		p = result.ptr;
+		int64_t index = value > 0 ? int64_t(value) - 1 : int64_t(definedCount) + value;
+		if (index < 0 || index >= int64_t(totalCount))
+			throw std::runtime_error("obj face index out of range: " + std::to_string(value));
+		return static_cast<int32_t>(index);
+	}
+
+	void countChunk(ObjChunk& chunk)
+	{
+		for (const char* p = chunk.begin; p < chunk.end;)
+		{
+			const char* lineEnd = findLineEnd(p, chunk.end);
+			const char* keyword = skipSpaces(p, lineEnd);
+			switch (classifyLine(keyword, lineEnd))
+			{
+			case ObjLine::POSITION: ++chunk.positionCount; break;
+			case ObjLine::TEXCOORD: ++chunk.texCoordCount; break;
+			case ObjLine::NORMAL: ++chunk.normalCount; break;
+			default: break;
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	//Writes the chunk's attributes at its bases, the arrays are already sized for the whole file
+	void parseChunk(ObjChunk& chunk, ObjAttributes& attributes)
+	{
+		size_t positionCount = chunk.positionBase;
+		size_t texCoordCount = chunk.texCoordBase;
+		size_t normalCount = chunk.normalBase;
+		size_t totalPositions = attributes.positions.size() / 3;
+		size_t totalTexCoords = attributes.texCoords.size() / 2;
+		size_t totalNormals = attributes.normals.size() / 3;
+		std::vector<ObjCorner> polygon;
+
+		for (const char* p = chunk.begin; p < chunk.end;)
+		{
+			const char* lineEnd = findLineEnd(p, chunk.end);
+			const char* cursor = skipSpaces(p, lineEnd);
+			switch (classifyLine(cursor, lineEnd))
+			{
+			case ObjLine::POSITION:
+				parseFloats(cursor, lineEnd, &attributes.positions[3 * positionCount++], 3);
+				break;
+			case ObjLine::TEXCOORD:
+				parseFloats(cursor, lineEnd, &attributes.texCoords[2 * texCoordCount++], 2);
+				break;
+			case ObjLine::NORMAL:
+				parseFloats(cursor, lineEnd, &attributes.normals[3 * normalCount++], 3);
+				break;
+			case ObjLine::FACE:
+			{
+				polygon.clear();
+				while ((cursor = skipSpaces(cursor, lineEnd)) != lineEnd)
+				{
+					const char* tokenEnd = cursor;
+					while (tokenEnd != lineEnd && !isSpace(*tokenEnd))
+						++tokenEnd;
+					//v, v/vt, v//vn or v/vt/vn
+					ObjCorner corner{ -1, -1, -1 };
+					corner.position = resolveIndex(cursor, tokenEnd, positionCount, totalPositions);
+					if (cursor != tokenEnd && *cursor == '/')
+					{
+						++cursor;
+						if (cursor != tokenEnd && *cursor != '/')
+							corner.texCoord = resolveIndex(cursor, tokenEnd, texCoordCount, totalTexCoords);
+						if (cursor != tokenEnd && *cursor == '/')
+						{
+							++cursor;
+							corner.normal = resolveIndex(cursor, tokenEnd, normalCount, totalNormals);
+						}
+					}
+					if (cursor != tokenEnd)
+						throw std::runtime_error("malformed face in obj line: " + std::string(p, lineEnd));
+					polygon.push_back(corner);
+				}
+				for (size_t i = 2; i < polygon.size(); ++i)
+				{
+					chunk.corners.push_back(polygon[0]);
+					chunk.corners.push_back(polygon[i - 1]);
+					chunk.corners.push_back(polygon[i]);
+				}
+				break;
+			}
+			case ObjLine::USEMTL:
+				chunk.materialChanges.emplace_back(chunk.corners.size(), lineArgument(cursor, lineEnd));
+				break;
+			case ObjLine::MTLLIB:
+				for (auto& library : lineArguments(cursor, lineEnd))
+					chunk.materialLibraries.push_back(std::move(library));
+				break;
+			default:
+				break;
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	//Shared by the caller of forEachChunk and its helper jobs, outlives the call when a helper only starts afterwards
+	struct ChunkQueue
+	{
+		size_t count = 0;
+		std::atomic<size_t> next{ 0 };
+		size_t finished = 0;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	//Claims chunks until none are left. job and chunks are only touched after a claim, which the caller is still waiting on
+	template<typename F>
+	void runChunks(ChunkQueue& queue, std::vector<ObjChunk>& chunks, F& job)
+	{
+		for (size_t i = queue.next++; i < queue.count; i = queue.next++)
+		{
+			std::exception_ptr error;
+			try
+			{
+				job(chunks[i]);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (error && !queue.error)
+				queue.error = error;
+			if (++queue.finished == queue.count)
+				queue.condition.notify_all();
+		}
+	}
+
+	//The calling thread works through the chunks too and the helpers only take what is left, so this also finishes when
+	//it runs on a worker of threadPool and every other worker is busy
+	template<typename F>
+	void forEachChunk(std::vector<ObjChunk>& chunks, my_vulkan::ThreadPool* threadPool, F&& job)
+	{
+		if (!threadPool || chunks.size() == 1)
+		{
+			for (auto& chunk : chunks)
+				job(chunk);
+			return;
+		}
+		auto queue = std::make_shared<ChunkQueue>();
+		queue->count = chunks.size();
+		size_t helperCount = std::min<size_t>(threadPool->getThreadCount(), chunks.size() - 1);
+		for (size_t i = 0; i != helperCount; ++i)
+			threadPool->submit([queue, &chunks, &job]() { runChunks(*queue, chunks, job); });
+		runChunks(*queue, chunks, job);
+
+		std::unique_lock<std::mutex> lock(queue->mutex);
+		queue->condition.wait(lock, [&queue]() { return queue->finished == queue->count; });
+		if (queue->error)
+			std::rethrow_exception(queue->error);
+	}
+
+	std::vector<ObjChunk> splitChunks(const char* begin, const char* end, size_t chunkCount)
+	{
+		std::vector<ObjChunk> chunks;
+		size_t chunkSize = (end - begin) / chunkCount;
+		const char* chunkBegin = begin;
+		for (size_t i = 1; i < chunkCount && chunkBegin < end; ++i)
+		{
+			const char* split = begin + i * chunkSize;
+			if (split <= chunkBegin)
+				continue;
+			//a chunk always ends after a newline, so no line is cut in two
+			split = findLineEnd(split, end);
+			if (split != end)
+				++split;
+			chunks.push_back({ chunkBegin, split });
+			chunkBegin = split;
+		}
+		if (chunkBegin < end)
+			chunks.push_back({ chunkBegin, end });
+		return chunks;
+	}
+}
+
+void my_vulkan::ObjParser::parse(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+	ThreadPool* threadPool, std::vector<Submesh>* submeshes, std::vector<std::string>* materialLibraryPaths)
+{
+	MappedFile file;
+	if (!file.open(path))
+		throw std::runtime_error("failed to open " + path);
+	const char* begin = reinterpret_cast<const char*>(file.getData());
+	const char* end = begin + file.getSize();
+
+	size_t chunkCount = 1;
+	if (threadPool)
+		chunkCount = std::max<size_t>(1, std::min<size_t>(threadPool->getThreadCount() * 4, file.getSize() / MIN_CHUNK_SIZE));
+	std::vector<ObjChunk> chunks = splitChunks(begin, end, chunkCount);
+
+	//the first pass only counts, so the second can resolve negative indices and write each chunk's attributes in place
+	forEachChunk(chunks, threadPool, countChunk);
+	ObjAttributes attributes;
+	size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+	for (auto& chunk : chunks)
+	{
+		chunk.positionBase = positionCount;
+		chunk.texCoordBase = texCoordCount;
+		chunk.normalBase = normalCount;
+		positionCount += chunk.positionCount;
+		texCoordCount += chunk.texCoordCount;
+		normalCount += chunk.normalCount;
+	}
+	attributes.positions.resize(3 * positionCount);
+	attributes.texCoords.resize(2 * texCoordCount);
+	attributes.normals.resize(3 * normalCount);
+	forEachChunk(chunks, threadPool, [&attributes](ObjChunk& chunk) { parseChunk(chunk, attributes); });
+
+	size_t cornerCount = 0;
+	for (const auto& chunk : chunks)
+		cornerCount += chunk.corners.size();
+	size_t firstIndex = indices.size();
+	indices.reserve(firstIndex + cornerCount);
+
+	std::vector<std::string> materials{ "" };
+	std::vector<MaterialRun> runs{ { 0, firstIndex } };
+	auto useMaterial = [&](const std::string& name)
+	{
+		uint32_t material = static_cast<uint32_t>(std::find(materials.begin(), materials.end(), name) - materials.begin());
+		if (material == materials.size())
+			materials.push_back(name);
+		if (runs.back().start == indices.size())
+			runs.back().material = material;
+		else if (runs.back().material != material)
+			runs.push_back({ material, indices.size() });
+	};
+
+	//welding stays on one thread, chunks in file order, so the output does not depend on the chunk count
+	VertexWelder welder(vertices, positionCount);
+	for (auto& chunk : chunks)
+	{
+		size_t change = 0;
+		for (size_t i = 0; i != chunk.corners.size(); ++i)
+		{
+			while (change != chunk.materialChanges.size() && chunk.materialChanges[change].first == i)
+				useMaterial(chunk.materialChanges[change++].second);
+			const ObjCorner& corner = chunk.corners[i];
+			Vertex vertex{};
+			vertex.pos = { attributes.positions[3 * corner.position + 0], attributes.positions[3 * corner.position + 1],
+				attributes.positions[3 * corner.position + 2] };
+			if (corner.texCoord >= 0)
+				vertex.texCoord = { attributes.texCoords[2 * corner.texCoord + 0], 1.0f - attributes.texCoords[2 * corner.texCoord + 1] };
+			if (corner.normal >= 0)
+				vertex.normal = { attributes.normals[3 * corner.normal + 0], attributes.normals[3 * corner.normal + 1],
+					attributes.normals[3 * corner.normal + 2] };
+			indices.push_back(welder.weld(vertex));
+		}
+		while (change != chunk.materialChanges.size())
+			useMaterial(chunk.materialChanges[change++].second);
+		std::vector<ObjCorner>().swap(chunk.corners);
+	}
+
+	if (!submeshes)
+		return;
+
+	//a stable counting sort of the runs by material, so each material is one range however often the file switches
+	std::vector<size_t> materialIndexCounts(materials.size(), 0);
+	for (size_t i = 0; i != runs.size(); ++i)
+	{
+		size_t runEnd = i + 1 == runs.size() ? indices.size() : runs[i + 1].start;
+		materialIndexCounts[runs[i].material] += runEnd - runs[i].start;
+	}
+	std::vector<size_t> materialFirstIndices(materials.size());
+	size_t offset = firstIndex;
+	for (size_t i = 0; i != materials.size(); ++i)
+	{
+		materialFirstIndices[i] = offset;
+		offset += materialIndexCounts[i];
+	}
+	if (runs.size() > 1)
+	{
+		std::vector<uint32_t> grouped(indices.size() - firstIndex);
+		std::vector<size_t> cursors = materialFirstIndices;
+		for (size_t i = 0; i != runs.size(); ++i)
+		{
+			size_t runEnd = i + 1 == runs.size() ? indices.size() : runs[i + 1].start;
+			std::copy(indices.begin() + runs[i].start, indices.begin() + runEnd, grouped.begin() + (cursors[runs[i].material] - firstIndex));
+			cursors[runs[i].material] += runEnd - runs[i].start;
+		}
+		std::copy(grouped.begin(), grouped.end(), indices.begin() + firstIndex);
+	}
+
+	std::vector<std::string> materialLibraries;
+	for (const auto& chunk : chunks)
+		for (const auto& library : chunk.materialLibraries)
+		{
+			//relative to the .obj
+			std::string libraryPath = getDirectory(path) + library;
+			if (std::find(materialLibraries.begin(), materialLibraries.end(), libraryPath) == materialLibraries.end())
+				materialLibraries.push_back(libraryPath);
+		}
+	std::vector<ObjMaterial> libraryMaterials;
+	for (const auto& library : materialLibraries)
+	{
+		if (!std::filesystem::exists(library))
+		{
+			std::cout << "cannot find material library : " << library << std::endl;
+			continue;
+		}
+		auto materialsOfLibrary = parseMtl(library);
+		libraryMaterials.insert(libraryMaterials.end(), materialsOfLibrary.begin(), materialsOfLibrary.end());
+	}
+	if (materialLibraryPaths)
+		*materialLibraryPaths = materialLibraries;
+
+	for (size_t i = 0; i != materials.size(); ++i)
+	{
+		if (materialIndexCounts[i] == 0)
+			continue;
+		Submesh submesh;
+		submesh.firstIndex = static_cast<uint32_t>(materialFirstIndices[i]);
+		submesh.indexCount = static_cast<uint32_t>(materialIndexCounts[i]);
+		submesh.bounds = MeshCache::computeBounds(vertices, indices.data() + submesh.firstIndex, submesh.indexCount);
+		submesh.material = materials[i];
+		auto libraryMaterial = std::find_if(libraryMaterials.begin(), libraryMaterials.end(),
+			[&submesh](const ObjMaterial& material) { return material.name == submesh.material; });
+		if (libraryMaterial != libraryMaterials.end())
+			submesh.texturePath = libraryMaterial->diffuseTexture;
+		submeshes->push_back(submesh);
+	}
+}
+
+std::vector<my_vulkan::ObjMaterial> my_vulkan::ObjParser::parseMtl(const std::string& path)
+{
+	MappedFile file;
+	if (!file.open(path))
+		throw std::runtime_error("failed to open " + path);
+	const char* p = reinterpret_cast<const char*>(file.getData());
+	const char* end = p + file.getSize();
+
+	//texture paths in the .mtl are relative to it
+	std::string directory = getDirectory(path);
+
+	std::vector<ObjMaterial> materials;
+	while (p < end)
+	{
+		const char* lineEnd = findLineEnd(p, end);
+		const char* keyword = skipSpaces(p, lineEnd);
+		const char* keywordEnd = keyword;
+		while (keywordEnd != lineEnd && !isSpace(*keywordEnd))
+			++keywordEnd;
+		std::string name(keyword, keywordEnd);
+
+		if (name == "newmtl")
+		{
+			materials.emplace_back();
+			materials.back().name = lineArgument(keywordEnd, lineEnd);
+		}
+		else if (!materials.empty() && name == "Kd")
+			parseFloats(keywordEnd, lineEnd, &materials.back().diffuse.x, 3);
+		else if (!materials.empty() && name == "map_Kd")
+		{
+			//options like -bm come before the file name, which may contain spaces
+			std::string argument = lineArgument(skipTextureOptions(keywordEnd, lineEnd), lineEnd);
+			if (!argument.empty())
+				materials.back().diffuseTexture = directory + argument;
+		}
+		p = lineEnd + 1;
+	}
+	return materials;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace my_vulkan
+{
+	struct Vertex;
+	struct Submesh;
+	class ThreadPool;
+
+	//One newmtl block of a .mtl file, only what the renderer uses
+	struct ObjMaterial
+	{
+		std::string name;
+		glm::vec3 diffuse{ 1.0f };
+		//relative to the working directory, empty without a map_Kd
+		std::string diffuseTexture;
+	};
+
+	//Reads Wavefront .obj files straight out of a memory mapping with std::from_chars, nothing of the file is copied.
+	//v, vt and vn go into flat float arrays and faces into corner indices, then every corner is welded into the output
+	//vertices in a single pass, so the only full size copies alive at once are those arrays and the output
+	class ObjParser
+	{
+	public:
+		//chunks smaller than this are not worth a job
+		static constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+		//Appends the triangles of the file, polygons are fanned. With a thread pool the file is cut into chunks at line
+		//boundaries that are counted and parsed in parallel. The calling thread parses chunks too, so it may run on the pool.
+		//With submeshes the appended triangles are grouped by usemtl into one range per material, in order of first use
+		//and with firstIndex into indices, and the map_Kd of their material becomes their texturePath. Every mtllib is read,
+		//the first library defining a material wins. materialLibraries receives their paths relative to the working directory
+		static void parse(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+			ThreadPool* threadPool = nullptr, std::vector<Submesh>* submeshes = nullptr, std::vector<std::string>* materialLibraries = nullptr);
+
+		static std::vector<ObjMaterial> parseMtl(const std::string& path);
+	};
+}
@@ -1,10 +1,9 @@
 #include "Object.h"
 #define GLM_FORCE_RADIANCE
-#include <iostream>
-#include <ostream>
+#include <unordered_map>
 #include "VulkanUtils.h"
 #include "VulkanDescriptors.h"
-#include "VulkanUniformBuffers.h"
+#include "VulkanUniformArena.h"
 #include "Texture.h"
 #include "Model.h"
 #include "VulkanContext.h"
@@ -12,17 +11,77 @@
 #include "Camera.h"
 #include "vulkan/vulkan.h"
 #include "BlinnPhongTexture.h"
+#include "AssetLoader.h"
+#include "VulkanBindlessTextures.h"
+#include "VulkanImage.h"
+#include "MeshRegistry.h"
+#include "RenderQueue.h"
 
 my_vulkan::Object::Object(const std::string& name, my_vulkan::VulkanContext* context, const std::vector<std::string>& modelPaths,
-                          const std::vector<std::string>& texturePaths) : modelPaths(modelPaths), texturePaths(texturePaths), name(name)
+                          const std::vector<std::string>& texturePaths, VertexFormat vertexFormat)
+	: modelPaths(modelPaths), texturePaths(texturePaths), name(name),
+	vertexFormat(context->bindlessTextures ? vertexFormat : VertexFormat::FULL)
 {
-	textures.resize(texturePaths.size());
+	if (!texturePaths.empty() && texturePaths.size() != modelPaths.size())
+		throw std::runtime_error(name + " needs one texture per model or none!");
 	meshes.resize(modelPaths.size());
 
-	for(int i = 0; i != texturePaths.size(); ++i)
+	//queue every asset before waiting on the first one, the uploads are recorded into the shared batch.
+	//Models another object already loaded are taken from the registry and never parsed again
+	std::vector<std::string> missingModelPaths;
+	for (const auto& modelPath : modelPaths)
+		if (!context->meshRegistry->find(modelPath, this->vertexFormat))
+			missingModelPaths.push_back(modelPath);
+	context->assetLoader->prefetch(missingModelPaths, texturePaths);
+	for (size_t i = 0; i != modelPaths.size(); ++i)
 	{
-		textures[i] = std::make_shared<BlinnPhongTexture>(texturePaths[i], context->device, context->commandPool);
-		meshes[i] = std::make_shared<Mesh>(modelPaths[i], context->device, context->commandPool);
+		meshes[i] = context->meshRegistry->find(modelPaths[i], this->vertexFormat);
+		if (meshes[i])
+			continue;
+		auto meshData = context->assetLoader->getMesh(modelPaths[i]);
+		if (this->vertexFormat == VertexFormat::COMPRESSED)
+			meshData->compress();
+		meshes[i] = context->meshRegistry->acquire(modelPaths[i], *meshData, context->device, context->uploader.get());
+	}
+
+	//the material textures are only known once the meshes are, they are all queued before the first is waited on
+	std::vector<std::string> partTexturePaths;
+	for (size_t i = 0; i != meshes.size(); ++i)
+	{
+		Mesh* mesh = meshes[i].get();
+		if (!texturePaths.empty())
+		{
+			parts.push_back({ mesh, mesh->firstIndex, mesh->indexCount, mesh->boundingSphere });
+			partTexturePaths.push_back(texturePaths[i]);
+			continue;
+		}
+		for (const auto& submesh : mesh->submeshes)
+		{
+			if (submesh.texturePath.empty())
+				throw std::runtime_error("material " + submesh.material + " of " + modelPaths[i] + " has no map_Kd!");
+			parts.push_back({ mesh, mesh->firstIndex + submesh.firstIndex, submesh.indexCount, Mesh::computeBoundingSphere(submesh.bounds) });
+			partTexturePaths.push_back(submesh.texturePath);
+		}
+	}
+	context->assetLoader->prefetch({}, partTexturePaths);
+
+	std::unordered_map<std::string, uint32_t> textureIndices;
+	for (size_t i = 0; i != parts.size(); ++i)
+	{
+		auto it = textureIndices.find(partTexturePaths[i]);
+		if (it != textureIndices.end())
+		{
+			parts[i].texture = it->second;
+			continue;
+		}
+		const std::string& texturePath = partTexturePaths[i];
+		auto imageData = context->assetLoader->getImage(texturePath);
+		auto texture = std::make_shared<BlinnPhongTexture>(texturePath, *imageData, context->device, context->uploader.get());
+		if (context->bindlessTextures)
+			texture->bindlessIndex = context->bindlessTextures->registerTexture(texture->getTextureImage()->getImageView(), texture->getTextureSampler());
+		parts[i].texture = static_cast<uint32_t>(textures.size());
+		textureIndices.emplace(texturePath, parts[i].texture);
+		textures.push_back(texture);
 	}
 
 	transformation.position = { 0, 0, 0 };
@@ -31,9 +90,8 @@ my_vulkan::Object::Object(const std::string& name, my_vulkan::VulkanContext* con
 	ubo = new VertexUniformBufferObject;
 	ubo->model = glm::mat4(1.0f);
 	updateTransformationMatrix();
-	uniformBuffers = std::make_shared<VulkanUniformBuffers>(context->device, VulkanUBOFor::VERTEX_SHADER);
-	uniformBuffersDescriptors = std::make_shared<VulkanDescriptors>(context->device, uniformBuffers.get(),
-		VK_NULL_HANDLE, VK_NULL_HANDLE, VulkanDescriptorFor::VERTEX_SHADER_UNIFORM_BUFFER);
+	uniformArena = context->uniformArena.get();
+	bindless = context->bindlessTextures != nullptr;
 	moveSpeed = 1.0f;
 	rotateSpeed = 2.0f;
 
@@ -45,11 +103,15 @@ void my_vulkan::Object::tick(uint32_t currentImage, Camera* camera, PointLight*
 	ubo->proj = camera->matrices.perspective;
 	ubo->proj[1][1] *= -1;
 
-	uniformBuffers->updateUniformBuffer(currentImage, ubo);
+	//the bindless path takes view, projection and lighting from the renderer's frame uniforms
+	if (bindless)
+		return;
+
+	uboOffset = uniformArena->push(*ubo);
 
 	for (const auto & texture : textures)
 	{
-		texture->update(currentImage, camera, light);
+		texture->update(uniformArena, camera, light);
 	}
 
 }
@@ -80,17 +142,50 @@ void my_vulkan::Object::setScale(glm::vec3 scale)
 	updateTransformationMatrix();
 }
 
-void my_vulkan::Object::Render(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkPipelineLayout layout)
+void my_vulkan::Object::enqueueDraws(RenderQueue& queue, uint32_t currentFrame, VkPipeline pipeline, const glm::mat4& viewProjection,
+	const uint8_t* meshVisibility)
 {
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1,
-		&uniformBuffersDescriptors->getDescriptorSets().at(currentFrame), 0, nullptr);
-	for (size_t i = 0; i != textures.size(); ++i)
+	DrawPacket packet{};
+	packet.pipeline = pipeline;
+	packet.instanceBuffer = getInstanceBuffer();
+	packet.instanceCount = getDrawInstanceCount();
+	packet.vertexUniformOffset = uboOffset;
+	packet.pushConstants.model = ubo->model;
+	if (packet.instanceCount == 0)
+		return;
+
+	for (size_t i = 0; i != parts.size(); ++i)
 	{
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1,
-			&textures[i]->sampleDescriptor->getDescriptorSets().at(currentFrame), 0, nullptr);
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 1,
-			&textures[i]->uboDescriptor->getDescriptorSets().at(currentFrame), 0, nullptr);
-		meshes[i]->Render(commandBuffer);
+		if (meshVisibility && !meshVisibility[i])
+			continue;
+		const ObjectPart& part = parts[i];
+		const Mesh* mesh = part.mesh;
+		const auto& texture = textures[part.texture];
+		packet.vertexBuffer = mesh->vertexBuffer;
+		packet.indexBuffer = mesh->indexBuffer;
+		packet.indexCount = part.indexCount;
+		packet.firstIndex = part.firstIndex;
+		packet.vertexOffset = mesh->vertexOffset;
+		//compressed positions are in [0, 1] of the mesh bounds
+		if (mesh->vertexFormat == VertexFormat::COMPRESSED)
+			packet.pushConstants.model = ubo->model * mesh->quantization.getMatrix();
+
+		uint64_t textureId;
+		if (bindless)
+		{
+			packet.pushConstants.textureIndex = texture->bindlessIndex;
+			textureId = texture->bindlessIndex;
+		}
+		else
+		{
+			packet.textureSet = texture->sampleDescriptor->getDescriptorSets().at(currentFrame);
+			packet.fragmentUniformOffset = texture->uboOffset;
+			textureId = (uint64_t)packet.textureSet;
+		}
+
+		//clip space w is the view space distance
+		glm::vec4 center = viewProjection * (ubo->model * glm::vec4(glm::vec3(part.boundingSphere), 1.0f));
+		queue.push(packet, textureId, center.w);
 	}
 }
 
@@ -108,11 +203,8 @@ void my_vulkan::Object::updateTransformationMatrix()
 void my_vulkan::Object::destroyObject(VkDevice device)
 {
 	delete ubo;
-	for (int i = 0; i != texturePaths.size(); ++i)
+	for (const auto& texture : textures)
 	{
-		textures[i]->destroyTexture(device);
-		meshes[i]->destroyModel(device);
+		texture->destroyTexture(device);
 	}
-	uniformBuffers->DestroyVulkanUniformBuffers(device);
-	uniformBuffersDescriptors->DestroyVulkanDescriptor(device);
 }
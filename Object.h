@@ -4,6 +4,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
+#include "Vertex.h"
 
 namespace my_vulkan
 {
@@ -14,13 +15,27 @@ namespace my_vulkan
 namespace my_vulkan
 {
 	class VulkanContext;
-	class VulkanUniformBuffers;
+	class VulkanUniformArena;
 	class Mesh;
 	class VulkanDescriptors;
 	class Texture;
 	class VulkanDevice;
 	class Camera;
 	class VertexUniformBufferObject;
+	class RenderQueue;
+
+	//One draw of an object, a submesh of one of its meshes with the texture it samples
+	struct ObjectPart
+	{
+		Mesh* mesh;
+		//into the mesh's index buffer, the mesh's own firstIndex already added
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		//mesh space center and radius of the submesh, for frustum culling
+		glm::vec4 boundingSphere;
+		//into textures
+		uint32_t texture;
+	};
 
 	class Object
 	{
@@ -28,8 +43,10 @@ namespace my_vulkan
 		const std::vector<std::string> modelPaths;
 
 	public:
+		//Either one texture per model, drawn over the whole model, or none, and each model is drawn per material with the
+		//map_Kd of its .mtl. COMPRESSED loads every mesh as CompressedVertex, which needs the bindless path and falls back to FULL without it
 		Object(const std::string& name, my_vulkan::VulkanContext* context, const std::vector<std::string>& modelPaths,
-			const std::vector<std::string>& texturePaths);
+			const std::vector<std::string>& texturePaths, VertexFormat vertexFormat = VertexFormat::FULL);
 
 		virtual void tick(uint32_t currentImage, Camera* camera, PointLight* light);
 
@@ -37,10 +54,17 @@ namespace my_vulkan
 		void setPosition(float* pos);
 		void setRotation(glm::vec3 rot);
 		void setScale(glm::vec3 scale);
-		void Render(uint32_t currentFrame, VkCommandBuffer commandBuffer, VkPipelineLayout layout);
+		//Pushes one draw packet per part, carrying both the non-bindless set offsets and the bindless push constants.
+		//meshVisibility holds one byte per part from the renderer's frustum culling, parts with 0 are skipped. Null draws all
+		void enqueueDraws(RenderQueue& queue, uint32_t currentFrame, VkPipeline pipeline, const glm::mat4& viewProjection,
+			const uint8_t* meshVisibility = nullptr);
 		void updateTransformationMatrix();
 
-		void destroyObject(VkDevice device);
+		//Instanced objects are drawn with the graphics pipeline's instanced variant
+		virtual bool isInstanced() const { return false; }
+
+		//Meshes are owned by the context's MeshRegistry and outlive the object
+		virtual void destroyObject(VkDevice device);
 
 		std::string name;
 		float moveSpeed;
@@ -54,9 +78,23 @@ namespace my_vulkan
 
 		VertexUniformBufferObject* ubo{};
 		std::vector<std::shared_ptr<Mesh>> meshes;
+		//one per distinct texture path, parts sharing a texture share the entry
 		std::vector<std::shared_ptr<BlinnPhongTexture>> textures;
-		std::shared_ptr<VulkanUniformBuffers> uniformBuffers;
-		std::shared_ptr<VulkanDescriptors> uniformBuffersDescriptors;
+		std::vector<ObjectPart> parts;
+		VulkanUniformArena* uniformArena;
+		bool bindless;
+		uint32_t uboOffset = 0;
+		//A VulkanPipelineManager key sharing the graphics pipeline layout, 0 draws with the default pipeline. Plain objects
+		//with a variant are drawn on the cpu path even when the rest are gpu driven.
+		//Variants of compressed objects have to start from getCompressedPipelineDesc
+		uint64_t pipelineKey = 0;
+		//The format of every mesh, compressed objects are always drawn on the cpu path
+		VertexFormat vertexFormat;
+
+	protected:
+		//The vertex buffer bound to binding 1 and how many copies each mesh draws, 0 draws nothing
+		virtual VkBuffer getInstanceBuffer() const { return VK_NULL_HANDLE; }
+		virtual uint32_t getDrawInstanceCount() const { return 1; }
 	};
 }
 
@@ -0,0 +1,228 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanComputePipeline.h"
+#include "VulkanGraphicsPipeline.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanUtils.h"
+#include "Profiler.h"
+
+my_vulkan::ParticleSystem::ParticleSystem(const std::shared_ptr<VulkanDevice>& device, VulkanGraphicsPipeline* graphicsPipeline,
+	const VkExtent2D& extent, uint32_t particleCount)
+	: device(device->getLogicalDevice()), computeQueue(device->getComputeQueue()), particleCount(particleCount)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+	groupCount = (particleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	if (particleCount == 0 || groupCount > properties.limits.maxComputeWorkGroupCount[0])
+		throw std::runtime_error("particle count is out of range for one dispatch!");
+	pointSize = device->supportsLargePoints() ? std::min(2.0f, properties.limits.pointSizeRange[1]) : 1.0f;
+
+	createBuffers(device);
+	createDescriptorSets(device);
+	createPipelines(device, graphicsPipeline, extent);
+	createCommandBuffers(device);
+	timeline = VulkanUtils::createTimelineSemaphore(this->device);
+}
+
+void my_vulkan::ParticleSystem::createBuffers(const std::shared_ptr<VulkanDevice>& device)
+{
+	//written on the compute queue and read as vertices on the graphics queue, shared instead of transferring ownership every step
+	std::vector<uint32_t> queueFamilies{ device->getGraphicsQueueFamily(), device->getComputeQueueFamily() };
+	for (uint32_t i = 0; i != 2; ++i)
+		VulkanUtils::createBuffer(device, particleBuffers[i], particleBuffersAllocations[i], sizeof(Particle) * particleCount,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, queueFamilies);
+}
+
+void my_vulkan::ParticleSystem::createDescriptorSets(const std::shared_ptr<VulkanDevice>& device)
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+	for (uint32_t i = 0; i != 2; ++i)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].pImmutableSamplers = nullptr;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	descriptorSetLayout = device->getDescriptorLayoutCache()->getLayout(bindings);
+
+	std::vector<VkDescriptorSetLayout> layouts(2, descriptorSetLayout);
+	descriptorAllocator = device->getDescriptorAllocator().get();
+	descriptorPool = descriptorAllocator->allocate(layouts, descriptorSets);
+
+	for (uint32_t i = 0; i != 2; ++i)
+	{
+		VkDescriptorBufferInfo bufferInfos[2]{};
+		bufferInfos[0].buffer = particleBuffers[i ^ 1];
+		bufferInfos[0].range = VK_WHOLE_SIZE;
+		bufferInfos[1].buffer = particleBuffers[i];
+		bufferInfos[1].range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet writeInfos[2]{};
+		for (uint32_t j = 0; j != 2; ++j)
+		{
+			writeInfos[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeInfos[j].descriptorCount = 1;
+			writeInfos[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writeInfos[j].dstSet = descriptorSets[i];
+			writeInfos[j].dstBinding = j;
+			writeInfos[j].dstArrayElement = 0;
+			writeInfos[j].pBufferInfo = &bufferInfos[j];
+		}
+		vkUpdateDescriptorSets(this->device, 2, writeInfos, 0, nullptr);
+	}
+}
+
+void my_vulkan::ParticleSystem::createPipelines(const std::shared_ptr<VulkanDevice>& device, VulkanGraphicsPipeline* graphicsPipeline,
+	const VkExtent2D& extent)
+{
+	VkPushConstantRange simulationRange{};
+	simulationRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	simulationRange.offset = 0;
+	simulationRange.size = sizeof(SimulationPushConstants);
+	simulationPipeline = std::make_shared<VulkanComputePipeline>(device, "shaders/particle.spv",
+		std::vector<VkDescriptorSetLayout>{ descriptorSetLayout }, std::vector<VkPushConstantRange>{ simulationRange });
+
+	VkPushConstantRange drawRange{};
+	drawRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	drawRange.offset = 0;
+	drawRange.size = sizeof(DrawPushConstants);
+	drawPipelineLayout = graphicsPipeline->createPipelineLayout(this->device, {}, { drawRange });
+	drawPipeline = graphicsPipeline->createGraphicsPipeline(this->device, extent, device->getMsaaSamples(),
+		"shaders/particle_vert.spv", "shaders/particle_frag.spv", VertexInput::PARTICLE, drawPipelineLayout);
+}
+
+void my_vulkan::ParticleSystem::createCommandBuffers(const std::shared_ptr<VulkanDevice>& device)
+{
+	commandPools.resize(MAX_RENDER_IMAGES);
+	commandBuffers.resize(MAX_RENDER_IMAGES);
+	submitValues.assign(MAX_RENDER_IMAGES, 0);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		VkCommandPoolCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		createInfo.queueFamilyIndex = device->getComputeQueueFamily();
+		createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		if (vkCreateCommandPool(this->device, &createInfo, nullptr, &commandPools[i]) != VK_SUCCESS)
+			throw std::runtime_error("failed to create particle command pool!");
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandBufferCount = 1;
+		allocateInfo.commandPool = commandPools[i];
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		if (vkAllocateCommandBuffers(this->device, &allocateInfo, &commandBuffers[i]) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate particle command buffer!");
+	}
+}
+
+void my_vulkan::ParticleSystem::simulate(uint32_t frame, float deltaTime, VkSemaphore graphicsTimeline, Profiler* profiler)
+{
+	//the frame drawing this frame's last step waited on it, so this returns at once
+	VulkanUtils::waitTimelineSemaphore(device, timeline, submitValues[frame]);
+	vkResetCommandPool(device, commandPools[frame], 0);
+
+	uint64_t nextStep = step + 1;
+	uint32_t target = static_cast<uint32_t>(nextStep % 2);
+
+	VkCommandBuffer commandBuffer = commandBuffers[frame];
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin recording command buffer!");
+
+	//the previous step was submitted to this queue without a semaphore in between
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		1, &barrier, 0, nullptr, 0, nullptr);
+
+	SimulationPushConstants constants{};
+	//a hitch would fling particles out of their orbits
+	constants.deltaTime = std::min(deltaTime, 0.05f);
+	constants.particleCount = particleCount;
+	//the first step seeds the particles on the gpu, nothing is uploaded
+	constants.initialize = step == 0 ? 1 : 0;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulationPipeline->getComputePipeline());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulationPipeline->getComputePipelineLayout(), 0, 1,
+		&descriptorSets[target], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, simulationPipeline->getComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+		sizeof(SimulationPushConstants), &constants);
+	uint32_t scope = profiler ? profiler->beginGpuScope(commandBuffer, "particles", true) : Profiler::NO_SCOPE;
+	vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+	if (profiler)
+		profiler->endGpuScope(commandBuffer, scope);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to record command buffer!");
+
+	//a value of 0 is already reached, so the first two steps wait on nothing
+	uint64_t waitValue = drawValues[target];
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = 1;
+	timelineInfo.pWaitSemaphoreValues = &waitValue;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &nextStep;
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &graphicsTimeline;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &timeline;
+
+	if (vkQueueSubmit(computeQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit particle simulation!");
+	step = nextStep;
+	submitValues[frame] = step;
+}
+
+void my_vulkan::ParticleSystem::recordDraw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection)
+{
+	if (step == 0)
+		return;
+
+	DrawPushConstants constants{};
+	constants.viewProjection = viewProjection;
+	constants.pointSize = pointSize;
+
+	VkDeviceSize offset = 0;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+	vkCmdPushConstants(commandBuffer, drawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants), &constants);
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &particleBuffers[step % 2], &offset);
+	vkCmdDraw(commandBuffer, particleCount, 1, 0, 0);
+}
+
+void my_vulkan::ParticleSystem::destroyParticleSystem(const VkDevice& device)
+{
+	for (auto& commandPool : commandPools)
+		vkDestroyCommandPool(device, commandPool, nullptr);
+	vkDestroySemaphore(device, timeline, nullptr);
+	vkDestroyPipeline(device, drawPipeline, nullptr);
+	vkDestroyPipelineLayout(device, drawPipelineLayout, nullptr);
+	simulationPipeline->destroyComputePipeline(device);
+	descriptorAllocator->free(descriptorPool, descriptorSets);
+	for (uint32_t i = 0; i != 2; ++i)
+		VulkanUtils::destroyBuffer(device, particleBuffers[i], particleBuffersAllocations[i]);
+}
+
+my_vulkan::ParticleSystem::~ParticleSystem()
+{
+
+}
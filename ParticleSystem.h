@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include "VulkanAllocator.h"
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+	class VulkanComputePipeline;
+	class VulkanGraphicsPipeline;
+	class VulkanDescriptorAllocator;
+	class Profiler;
+
+	//Particles simulated by shaders/particle.comp on the async compute queue and drawn as point sprites straight from the
+	//storage buffer. Two buffers ping-pong, each step reads the one the frame before drew and writes the other, so a step
+	//overlaps the previous frame's graphics work. Steps signal timeline, which the frame drawing them waits on
+	class ParticleSystem
+	{
+	public:
+		static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+		//Must match the push constants of shaders/particle.comp
+		struct SimulationPushConstants
+		{
+			float deltaTime;
+			uint32_t particleCount;
+			uint32_t initialize;
+		};
+
+		//Must match the push constants of shaders/particle.vert
+		struct DrawPushConstants
+		{
+			glm::mat4 viewProjection;
+			float pointSize;
+		};
+
+		ParticleSystem(const std::shared_ptr<VulkanDevice>& device, VulkanGraphicsPipeline* graphicsPipeline, const VkExtent2D& extent,
+			uint32_t particleCount);
+
+		//Submits the next step to the compute queue. graphicsTimeline is the frame timeline the renderer signals, the step waits on
+		//it until the frame that drew the buffer it overwrites is done. Only call once the frame's previous submission has completed.
+		//A profiler times the dispatch as a compute scope
+		void simulate(uint32_t frame, float deltaTime, VkSemaphore graphicsTimeline, Profiler* profiler = nullptr);
+		//Inside the render pass with viewport and scissor set, draws the last simulated step
+		void recordDraw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+		//The frame timeline value of the submission that draws the last simulated step
+		void setDrawValue(uint64_t graphicsValue) { drawValues[step % 2] = graphicsValue; }
+
+		//Signaled with the step count, the frame drawing a step waits on it at the vertex input stage
+		VkSemaphore getTimelineSemaphore() const { return timeline; }
+		uint64_t getTimelineValue() const { return step; }
+		uint32_t getParticleCount() const { return particleCount; }
+
+		void destroyParticleSystem(const VkDevice& device);
+
+		~ParticleSystem();
+
+	private:
+		void createBuffers(const std::shared_ptr<VulkanDevice>& device);
+		void createDescriptorSets(const std::shared_ptr<VulkanDevice>& device);
+		void createPipelines(const std::shared_ptr<VulkanDevice>& device, VulkanGraphicsPipeline* graphicsPipeline, const VkExtent2D& extent);
+		void createCommandBuffers(const std::shared_ptr<VulkanDevice>& device);
+
+		VkDevice device;
+		VkQueue computeQueue;
+		uint32_t particleCount;
+		uint32_t groupCount;
+		float pointSize;
+
+		std::array<VkBuffer, 2> particleBuffers;
+		std::array<VulkanAllocation, 2> particleBuffersAllocations;
+
+		//set i reads buffer i ^ 1 and writes buffer i
+		VkDescriptorSetLayout descriptorSetLayout;
+		VulkanDescriptorAllocator* descriptorAllocator;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> descriptorSets;
+
+		std::shared_ptr<VulkanComputePipeline> simulationPipeline;
+		VkPipelineLayout drawPipelineLayout;
+		VkPipeline drawPipeline;
+
+		//per frame in flight, reset once the frame's previous step has completed
+		std::vector<VkCommandPool> commandPools;
+		std::vector<VkCommandBuffer> commandBuffers;
+		std::vector<uint64_t> submitValues;
+
+		VkSemaphore timeline;
+		//steps simulated so far, step n writes buffer n % 2 and signals timeline with n
+		uint64_t step = 0;
+		//per buffer, the frame timeline value of the last frame that drew it
+		std::array<uint64_t, 2> drawValues{};
+	};
+}
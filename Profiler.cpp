@@ -0,0 +1,234 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+my_vulkan::Profiler::Profiler(const std::shared_ptr<VulkanDevice>& device)
+	: device(device->getLogicalDevice()), origin(clock::now())
+{
+	createQueryPools(device);
+}
+
+void my_vulkan::Profiler::createQueryPools(const std::shared_ptr<VulkanDevice>& device)
+{
+	gpuScopes.resize(MAX_RENDER_IMAGES);
+	submitTimes.resize(MAX_RENDER_IMAGES, origin);
+
+	//without host resets the queries would have to be reset inside a command buffer of every queue that writes them
+	if (!device->supportsHostQueryReset())
+		return;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+	timestampPeriod = properties.limits.timestampPeriod;
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device->getPhysicalDevice(), &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device->getPhysicalDevice(), &familyCount, families.data());
+	graphicsTimestamps = families[device->getGraphicsQueueFamily()].timestampValidBits != 0;
+	computeTimestamps = families[device->getComputeQueueFamily()].timestampValidBits != 0;
+	if (!graphicsTimestamps && !computeTimestamps)
+		return;
+
+	VkQueryPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = MAX_GPU_SCOPES * 2;
+
+	queryPools.resize(MAX_RENDER_IMAGES);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		if (vkCreateQueryPool(this->device, &createInfo, nullptr, &queryPools[i]) != VK_SUCCESS)
+			throw std::runtime_error("failed to create timestamp query pool!");
+		vkResetQueryPool(this->device, queryPools[i], 0, createInfo.queryCount);
+	}
+}
+
+void my_vulkan::Profiler::beginFrame(uint32_t frame)
+{
+	clock::time_point now = clock::now();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (frameStarted)
+		addSample("frame", false, getThreadTrack(), std::chrono::duration<double, std::micro>(frameStart - origin).count(),
+			std::chrono::duration<double, std::micro>(now - frameStart).count());
+	frameStart = now;
+	frameStarted = true;
+
+	currentFrame = frame;
+	if (queryPools.empty())
+		return;
+	resolveGpuScopes(frame);
+	vkResetQueryPool(device, queryPools[frame], 0, MAX_GPU_SCOPES * 2);
+	gpuScopes[frame].clear();
+}
+
+void my_vulkan::Profiler::resolveGpuScopes(uint32_t frame)
+{
+	std::vector<GpuScope>& scopes = gpuScopes[frame];
+	if (scopes.empty())
+		return;
+
+	//no wait, a frame whose queries never landed (a skipped submit) is dropped rather than stalling
+	std::vector<uint64_t> timestamps(scopes.size() * 2);
+	if (vkGetQueryPoolResults(device, queryPools[frame], 0, static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t),
+		timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		return;
+
+	//gpu ticks have no relation to the cpu clock, each queue's first timestamp is pinned to the submit time on the trace
+	double submit = std::chrono::duration<double, std::micro>(submitTimes[frame] - origin).count();
+	uint64_t base[2] = { ~0ull, ~0ull };
+	for (size_t i = 0; i != scopes.size(); ++i)
+		base[scopes[i].compute] = std::min(base[scopes[i].compute], timestamps[i * 2]);
+
+	for (size_t i = 0; i != scopes.size(); ++i)
+	{
+		uint64_t begin = timestamps[i * 2];
+		uint64_t end = std::max(begin, timestamps[i * 2 + 1]);
+		double start = submit + static_cast<double>(begin - base[scopes[i].compute]) * timestampPeriod / 1000.0;
+		double duration = static_cast<double>(end - begin) * timestampPeriod / 1000.0;
+		addSample(scopes[i].name, true, scopes[i].compute ? 101 : 100, start, duration);
+	}
+}
+
+void my_vulkan::Profiler::markSubmit()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	submitTimes[currentFrame] = clock::now();
+}
+
+void my_vulkan::Profiler::addCpuSample(const char* name, clock::time_point start, clock::time_point end)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	addSample(name, false, getThreadTrack(), std::chrono::duration<double, std::micro>(start - origin).count(),
+		std::chrono::duration<double, std::micro>(end - start).count());
+}
+
+void my_vulkan::Profiler::addSample(const char* name, bool gpu, uint32_t track, double start, double duration)
+{
+	std::deque<float>& window = samples[{ name, gpu }];
+	window.push_back(static_cast<float>(duration / 1000.0));
+	if (window.size() > SAMPLE_WINDOW)
+		window.pop_front();
+
+	if (tracing && traceEvents.size() < MAX_TRACE_EVENTS)
+		traceEvents.push_back({ name, track, start, duration });
+}
+
+uint32_t my_vulkan::Profiler::getThreadTrack()
+{
+	auto it = threadTracks.find(std::this_thread::get_id());
+	if (it != threadTracks.end())
+		return it->second;
+	uint32_t track = static_cast<uint32_t>(threadTracks.size());
+	threadTracks.emplace(std::this_thread::get_id(), track);
+	return track;
+}
+
+uint32_t my_vulkan::Profiler::beginGpuScope(VkCommandBuffer commandBuffer, const char* name, bool compute)
+{
+	if (!(compute ? computeTimestamps : graphicsTimestamps))
+		return NO_SCOPE;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<GpuScope>& scopes = gpuScopes[currentFrame];
+	if (scopes.size() == MAX_GPU_SCOPES)
+		return NO_SCOPE;
+
+	uint32_t scope = static_cast<uint32_t>(scopes.size());
+	scopes.push_back({ name, compute });
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[currentFrame], scope * 2);
+	return scope;
+}
+
+void my_vulkan::Profiler::endGpuScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+	if (scope == NO_SCOPE)
+		return;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[currentFrame], scope * 2 + 1);
+}
+
+std::vector<my_vulkan::ProfilerScopeStats> my_vulkan::Profiler::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<ProfilerScopeStats> stats;
+	stats.reserve(samples.size());
+	std::vector<float> sorted;
+	for (const auto& [key, window] : samples)
+	{
+		if (window.empty())
+			continue;
+		sorted.assign(window.begin(), window.end());
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](float p) { return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))]; };
+		stats.push_back({ key.first, key.second, window.back(), percentile(0.5f), percentile(0.95f), percentile(0.99f) });
+	}
+	return stats;
+}
+
+void my_vulkan::Profiler::setTracing(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (enabled && !tracing)
+		traceEvents.clear();
+	tracing = enabled;
+}
+
+size_t my_vulkan::Profiler::getTraceEventCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return traceEvents.size();
+}
+
+void my_vulkan::Profiler::writeChromeTrace(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::ofstream out(path, std::ios::trunc);
+	if (!out)
+	{
+		std::cout << "cannot write trace : " << path << std::endl;
+		return;
+	}
+
+	//the chrome://tracing json format, complete events with microsecond timestamps
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	for (uint32_t track = 0; track != threadTracks.size(); ++track)
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << track << ",\"args\":{\"name\":\"cpu thread " << track << "\"}},\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":100,\"args\":{\"name\":\"gpu graphics\"}},\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":101,\"args\":{\"name\":\"gpu compute\"}}";
+	for (const TraceEvent& event : traceEvents)
+		out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.track << ",\"ts\":" << std::fixed
+			<< event.start << ",\"dur\":" << event.duration << "}";
+	out << "\n]}\n";
+	std::cout << traceEvents.size() << " trace events written to " << path << std::endl;
+}
+
+void my_vulkan::Profiler::destroyProfiler(const VkDevice& device)
+{
+	for (VkQueryPool queryPool : queryPools)
+		vkDestroyQueryPool(device, queryPool, nullptr);
+	queryPools.clear();
+}
+
+my_vulkan::Profiler::~Profiler()
+{
+
+}
+
+my_vulkan::ProfileScope::ProfileScope(Profiler* profiler, const char* name)
+	: profiler(profiler), name(name)
+{
+	if (profiler != nullptr)
+		start = std::chrono::high_resolution_clock::now();
+}
+
+my_vulkan::ProfileScope::~ProfileScope()
+{
+	if (profiler != nullptr)
+		profiler->addCpuSample(name, start, std::chrono::high_resolution_clock::now());
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+
+	struct ProfilerScopeStats
+	{
+		std::string name;
+		bool gpu;
+		//in ms, over the last SAMPLE_WINDOW samples
+		float last;
+		float p50;
+		float p95;
+		float p99;
+	};
+
+	//CPU scope timers and GPU timestamp queries, one query pool per frame in flight. A frame's timestamps are read back
+	//when its slot comes around again, once the frame timeline says it has completed, so GPU numbers lag by a frame.
+	//Every scope keeps a rolling window for percentiles and, while tracing, a chrome://tracing event per sample.
+	//Scope names are stored by pointer and must be string literals
+	class Profiler
+	{
+	public:
+		static constexpr uint32_t MAX_GPU_SCOPES = 32;
+		static constexpr uint32_t NO_SCOPE = ~0u;
+		static constexpr size_t SAMPLE_WINDOW = 240;
+		static constexpr size_t MAX_TRACE_EVENTS = 1 << 20;
+
+		Profiler(const std::shared_ptr<VulkanDevice>& device);
+
+		//Resolves the slot's previous timestamps and resets its queries, only call once the frame's previous submission has completed
+		void beginFrame(uint32_t frame);
+		//The cpu time the frame's work was handed to the gpu, its gpu scopes are placed on the trace relative to it
+		void markSubmit();
+
+		void addCpuSample(const char* name, std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end);
+
+		//Returns NO_SCOPE when the queue family has no timestamps or the frame ran out of queries, endGpuScope then does nothing.
+		//compute scopes are recorded into command buffers of the async compute queue
+		uint32_t beginGpuScope(VkCommandBuffer commandBuffer, const char* name, bool compute = false);
+		void endGpuScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		std::vector<ProfilerScopeStats> getStats();
+
+		void setTracing(bool enabled);
+		bool isTracing() const { return tracing; }
+		size_t getTraceEventCount();
+		void writeChromeTrace(const std::string& path);
+
+		void destroyProfiler(const VkDevice& device);
+
+		~Profiler();
+
+	private:
+		using clock = std::chrono::high_resolution_clock;
+
+		struct GpuScope
+		{
+			const char* name;
+			bool compute;
+		};
+
+		struct TraceEvent
+		{
+			const char* name;
+			uint32_t track;
+			double start;
+			double duration;
+		};
+
+		void createQueryPools(const std::shared_ptr<VulkanDevice>& device);
+		void resolveGpuScopes(uint32_t frame);
+		//callers hold mutex
+		void addSample(const char* name, bool gpu, uint32_t track, double start, double duration);
+		uint32_t getThreadTrack();
+
+		VkDevice device;
+		std::vector<VkQueryPool> queryPools;
+		std::vector<std::vector<GpuScope>> gpuScopes;
+		std::vector<clock::time_point> submitTimes;
+		bool graphicsTimestamps = false;
+		bool computeTimestamps = false;
+		//ns per tick
+		float timestampPeriod = 1.0f;
+		uint32_t currentFrame = 0;
+
+		clock::time_point origin;
+		clock::time_point frameStart;
+		bool frameStarted = false;
+
+		std::mutex mutex;
+		//keyed by name and whether the samples came from the gpu
+		std::map<std::pair<std::string, bool>, std::deque<float>> samples;
+		std::map<std::thread::id, uint32_t> threadTracks;
+		bool tracing = false;
+		std::vector<TraceEvent> traceEvents;
+	};
+
+	//Times its own lifetime as a cpu scope, a null profiler makes it a no-op
+	class ProfileScope
+	{
+	public:
+		ProfileScope(Profiler* profiler, const char* name);
+		~ProfileScope();
+
+	private:
+		Profiler* profiler;
+		const char* name;
+		std::chrono::high_resolution_clock::time_point start;
+	};
+}
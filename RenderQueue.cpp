@@ -0,0 +1,151 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+my_vulkan::RenderQueueStats& my_vulkan::RenderQueueStats::operator+=(const RenderQueueStats& rhs)
+{
+	drawCount += rhs.drawCount;
+	pipelineBinds += rhs.pipelineBinds;
+	descriptorBinds += rhs.descriptorBinds;
+	vertexBufferBinds += rhs.vertexBufferBinds;
+	indexBufferBinds += rhs.indexBufferBinds;
+	return *this;
+}
+
+void my_vulkan::RenderQueue::clear()
+{
+	packets.clear();
+	entries.clear();
+}
+
+uint64_t my_vulkan::RenderQueue::getId(std::unordered_map<uint64_t, uint32_t>& ids, uint64_t handle, uint32_t bits)
+{
+	auto it = ids.find(handle);
+	if (it != ids.end())
+		return it->second;
+	//ids past the field wrap around, which only costs some grouping
+	uint32_t id = static_cast<uint32_t>(ids.size()) & ((1u << bits) - 1);
+	ids.emplace(handle, id);
+	return id;
+}
+
+void my_vulkan::RenderQueue::push(const DrawPacket& packet, uint64_t textureId, float depth)
+{
+	//a non-negative float's bits order like the float itself
+	float clampedDepth = std::max(depth, 0.0f);
+	uint32_t depthBits;
+	memcpy(&depthBits, &clampedDepth, sizeof(depthBits));
+
+	uint64_t key = getId(pipelineIds, (uint64_t)packet.pipeline, PIPELINE_BITS);
+	key = (key << TEXTURE_BITS) | getId(textureIds, textureId, TEXTURE_BITS);
+	key = (key << MESH_BITS) | getId(meshIds, (uint64_t)packet.vertexBuffer, MESH_BITS);
+	key = (key << DEPTH_BITS) | (depthBits >> (31 - DEPTH_BITS));
+
+	entries.push_back({ key, static_cast<uint32_t>(packets.size()) });
+	packets.push_back(packet);
+}
+
+void my_vulkan::RenderQueue::sort()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//lsd radix sort over the key bytes, stable so equal keys keep their push order
+	scratch.resize(entries.size());
+	for (uint32_t shift = 0; shift != 64; shift += 8)
+	{
+		size_t counts[256]{};
+		for (const SortEntry& entry : entries)
+			++counts[(entry.key >> shift) & 0xFF];
+		//a byte every key shares leaves the order as it is
+		if (counts[(entries.empty() ? 0 : entries[0].key >> shift) & 0xFF] == entries.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			size_t digitCount = count;
+			count = offset;
+			offset += digitCount;
+		}
+		for (const SortEntry& entry : entries)
+			scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+		entries.swap(scratch);
+	}
+
+	sortTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+my_vulkan::RenderQueueStats my_vulkan::RenderQueue::submit(VkCommandBuffer commandBuffer, VkPipelineLayout layout, bool bindless,
+	VkDescriptorSet vertexSet, VkDescriptorSet fragmentSet, size_t begin, size_t end) const
+{
+	RenderQueueStats stats;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+	VkDescriptorSet boundTextureSet = VK_NULL_HANDLE;
+	//~0u marks the dynamic offsets as not bound yet
+	uint32_t boundVertexOffset = ~0u;
+	uint32_t boundFragmentOffset = ~0u;
+
+	for (size_t i = begin; i != end; ++i)
+	{
+		const DrawPacket& packet = packets[entries[i].packet];
+		//every pipeline shares the layout, so switching keeps the bound sets
+		if (packet.pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+			boundPipeline = packet.pipeline;
+			++stats.pipelineBinds;
+		}
+
+		if (bindless)
+			vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MeshPushConstants),
+				&packet.pushConstants);
+		else
+		{
+			if (packet.vertexUniformOffset != boundVertexOffset)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &vertexSet, 1, &packet.vertexUniformOffset);
+				boundVertexOffset = packet.vertexUniformOffset;
+				++stats.descriptorBinds;
+			}
+			if (packet.textureSet != boundTextureSet)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &packet.textureSet, 0, nullptr);
+				boundTextureSet = packet.textureSet;
+				++stats.descriptorBinds;
+			}
+			if (packet.fragmentUniformOffset != boundFragmentOffset)
+			{
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 1, &fragmentSet, 1, &packet.fragmentUniformOffset);
+				boundFragmentOffset = packet.fragmentUniformOffset;
+				++stats.descriptorBinds;
+			}
+		}
+
+		if (packet.vertexBuffer != boundVertexBuffer || (packet.instanceBuffer != VK_NULL_HANDLE && packet.instanceBuffer != boundInstanceBuffer))
+		{
+			VkBuffer vertexBuffers[] = { packet.vertexBuffer, packet.instanceBuffer };
+			VkDeviceSize offsets[] = { 0, 0 };
+			uint32_t bindingCount = packet.instanceBuffer != VK_NULL_HANDLE ? 2 : 1;
+			vkCmdBindVertexBuffers(commandBuffer, 0, bindingCount, vertexBuffers, offsets);
+			boundVertexBuffer = packet.vertexBuffer;
+			if (bindingCount == 2)
+				boundInstanceBuffer = packet.instanceBuffer;
+			++stats.vertexBufferBinds;
+		}
+		if (packet.indexBuffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, packet.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundIndexBuffer = packet.indexBuffer;
+			++stats.indexBufferBinds;
+		}
+
+		vkCmdDrawIndexed(commandBuffer, packet.indexCount, packet.instanceCount, packet.firstIndex, packet.vertexOffset, 0);
+		++stats.drawCount;
+	}
+	return stats;
+}
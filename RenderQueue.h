@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include "VulkanUtils.h"
+
+namespace my_vulkan
+{
+	//Everything one mesh draw needs, so the draw can be issued in any order without going back to its object
+	struct DrawPacket
+	{
+		VkPipeline pipeline;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		//VK_NULL_HANDLE unless instanced, then bound to binding 1
+		VkBuffer instanceBuffer = VK_NULL_HANDLE;
+		uint32_t instanceCount = 1;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		//set 1 and the dynamic offsets of sets 0 and 2, only read by the non-bindless pipeline
+		VkDescriptorSet textureSet = VK_NULL_HANDLE;
+		uint32_t vertexUniformOffset = 0;
+		uint32_t fragmentUniformOffset = 0;
+		//only read by the bindless pipeline
+		MeshPushConstants pushConstants{};
+	};
+
+	struct RenderQueueStats
+	{
+		uint32_t drawCount = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorBinds = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t indexBufferBinds = 0;
+
+		RenderQueueStats& operator+=(const RenderQueueStats& rhs);
+	};
+
+	//Collects the frame's draw packets under a 64 bit key, pipeline | texture | vertex buffer | depth from the most
+	//significant bits down, and radix sorts them so equal state ends up adjacent. Submission then skips every bind that
+	//would not change the bound state. Opaque draws within the same state go front to back
+	class RenderQueue
+	{
+	public:
+		static constexpr uint32_t PIPELINE_BITS = 10;
+		static constexpr uint32_t TEXTURE_BITS = 14;
+		static constexpr uint32_t MESH_BITS = 14;
+		static constexpr uint32_t DEPTH_BITS = 26;
+
+		void clear();
+		//textureId is the bindless index or any value identifying the texture set, depth the view space distance
+		void push(const DrawPacket& packet, uint64_t textureId, float depth);
+		//Orders the packets by key, packets never sorted are submitted in push order
+		void sort();
+
+		//Records the sorted packets [begin, end). The bindless frame sets and viewport are expected to be bound already,
+		//nothing else is, so every range starts from scratch and may go to its own secondary buffer
+		RenderQueueStats submit(VkCommandBuffer commandBuffer, VkPipelineLayout layout, bool bindless, VkDescriptorSet vertexSet,
+			VkDescriptorSet fragmentSet, size_t begin, size_t end) const;
+
+		size_t getPacketCount() const { return packets.size(); }
+		//in ms, of the last sort
+		float getSortTime() const { return sortTime; }
+
+	private:
+		struct SortEntry
+		{
+			uint64_t key;
+			uint32_t packet;
+		};
+
+		//small ids for handles, stable across frames so equal state keeps its place in the order
+		uint64_t getId(std::unordered_map<uint64_t, uint32_t>& ids, uint64_t handle, uint32_t bits);
+
+		std::vector<DrawPacket> packets;
+		std::vector<SortEntry> entries;
+		std::vector<SortEntry> scratch;
+		std::unordered_map<uint64_t, uint32_t> pipelineIds;
+		std::unordered_map<uint64_t, uint32_t> textureIds;
+		std::unordered_map<uint64_t, uint32_t> meshIds;
+		float sortTime = 0.0f;
+	};
+}
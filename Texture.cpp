@@ -1,5 +1,6 @@
 ﻿#define STB_IMAGE_IMPLEMENTATION
 
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include "VulkanUtils.h"
@@ -8,56 +9,103 @@
 #include "VulkanImage.h"
 #include "Texture.h"
 #include "VulkanDescriptors.h"
+#include "VulkanUploader.h"
+#include "TextureCompressor.h"
 #include "Vertex.h"
 
-my_vulkan::Texture::Texture(const std::string& filePath, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
+my_vulkan::ImageData::~ImageData()
+{
+	if (pixels)
+		stbi_image_free(pixels);
+}
+
+std::shared_ptr<my_vulkan::ImageData> my_vulkan::ImageData::load(const std::string& filePath)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	auto imageData = std::make_shared<ImageData>();
+	if (imageData->cache.open(filePath))
+	{
+		imageData->width = static_cast<int>(imageData->cache.getWidth());
+		imageData->height = static_cast<int>(imageData->cache.getHeight());
+		imageData->loadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return imageData;
+	}
+
+	int texChannels;
+	imageData->pixels = stbi_load(filePath.c_str(), &imageData->width, &imageData->height, &texChannels, STBI_rgb_alpha);
+	if (!imageData->pixels)
+		throw std::runtime_error("failed to load texture image : " + filePath);
+
+	imageData->loadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return imageData;
+}
+
+my_vulkan::Texture::Texture(const std::string& filePath, const ImageData& imageData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
 {
 	name.insert(0, filePath.substr(filePath.find_last_of('/') + 1, filePath.find_last_of('.') - filePath.find_last_of('/') - 1));
-	createTextureImage(filePath, device, commandPool);
+	createTextureImage(imageData, device, uploader);
 	createTextureSampler(device);
 	createDescriptor(device);
 }
 
-void my_vulkan::Texture::createTextureImage(const std::string& filePath, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
+void my_vulkan::Texture::createTextureImage(const ImageData& imageData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
 {
-	int texWidth, texHeight, texChannels;
+	if (!imageData.isCompressed())
+	{
+		createTextureImage(imageData.pixels, imageData.width, imageData.height, VK_FORMAT_R8G8B8A8_SRGB, device, uploader);
+		return;
+	}
+
+	const TextureCache& cache = imageData.cache;
+	if (device->supportsTextureCompressionBC())
+	{
+		createCompressedTextureImage(cache, device, uploader);
+		return;
+	}
+
+	//without BC support only the top level is decoded and the chain is blitted like for any other image
+	std::vector<uint8_t> pixels = TextureCompressor::decompress(cache.getData(), cache.getWidth(), cache.getHeight(), cache.getFormat());
+	VkFormat format = cache.getFormat() == VK_FORMAT_BC7_SRGB_BLOCK ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	createTextureImage(pixels.data(), imageData.width, imageData.height, format, device, uploader);
+}
 
-	stbi_uc* pixels = stbi_load(filePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+void my_vulkan::Texture::createTextureImage(const unsigned char* pixels, int texWidth, int texHeight, VkFormat format,
+	const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+{
 	VkDeviceSize imageSize = texWidth * texHeight * STBI_rgb_alpha; //4 bytes per pixel
 
 	auto mipmapLevel = static_cast<uint32_t>(std::floor(std::log2(std::max(texHeight, texWidth))));
 	mipLevels = mipmapLevel;
-	if (!pixels)
-		throw std::runtime_error("failed to load texture image!"); 
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	VulkanUtils::createBuffer(device, stagingBuffer, stagingBufferMemory, imageSize, 
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-	void* data;
-	vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, imageSize);
-	vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-	stbi_image_free(pixels);
 
 	textureImage = std::make_shared<VulkanImage>(device, texWidth, texHeight, 1, mipmapLevel, 1, 
-		VK_IMAGE_TYPE_2D, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_TYPE_2D, format, VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_SHARING_MODE_EXCLUSIVE, 
 		VK_SAMPLE_COUNT_1_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
 
-	textureImage->transitionImageLayout(device, commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipmapLevel);
-	textureImage->copyBufferToImage(device, commandPool, stagingBuffer, texWidth, texHeight);
+	//recorded into the uploader's batch, staging may submit it so the command buffer is fetched per step
+	textureImage->transitionImageLayout(uploader->getCommandBuffer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipmapLevel);
+	uploader->uploadImage(textureImage.get(), pixels, imageSize, texWidth, texHeight, mipmapLevel);
 
-	generateMipmaps(device, commandPool, texWidth, texHeight, mipmapLevel);
+	//blits are graphics queue work, they run once the copy on the transfer queue is done
+	generateMipmaps(device, uploader->getGraphicsCommandBuffer(), texWidth, texHeight, mipmapLevel);
+}
+
+void my_vulkan::Texture::createCompressedTextureImage(const TextureCache& cache, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+{
+	mipLevels = cache.getLevelCount();
 
-	vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-	vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
+	textureImage = std::make_shared<VulkanImage>(device, cache.getWidth(), cache.getHeight(), 1, mipLevels, 1,
+		VK_IMAGE_TYPE_2D, cache.getFormat(), VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_SHARING_MODE_EXCLUSIVE,
+		VK_SAMPLE_COUNT_1_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	textureImage->transitionImageLayout(uploader->getCommandBuffer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+	uploader->uploadImageLevels(textureImage.get(), cache.getData(), cache.getLevelSizes(), cache.getWidth(), cache.getHeight());
+	textureImage->transitionImageLayout(uploader->getGraphicsCommandBuffer(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
 }
 
-void my_vulkan::Texture::generateMipmaps(const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
+void my_vulkan::Texture::generateMipmaps(const std::shared_ptr<VulkanDevice>& device, VkCommandBuffer commandBuffer, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 {
 	VkFormatProperties formatProperties;
 	vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), textureImage->getImageFormat(), &formatProperties);
@@ -65,8 +113,6 @@ void my_vulkan::Texture::generateMipmaps(const std::shared_ptr<VulkanDevice>& de
 		throw std::runtime_error("texture image format does not support linear blitting!");
 	}
 
-	VkCommandBuffer commandBuffer = VulkanUtils::beginSingleTimeCommand(device->getLogicalDevice(), commandPool);
-
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.image = textureImage->getImage();
@@ -139,8 +185,6 @@ void my_vulkan::Texture::generateMipmaps(const std::shared_ptr<VulkanDevice>& de
 		0, nullptr,
 		0, nullptr,
 		1, &barrier);
-
-	VulkanUtils::endSingleTimeCommands(device->getLogicalDevice(), commandBuffer, commandPool, device->getGraphicsQueue());
 }
 
 void my_vulkan::Texture::createTextureSampler(const std::shared_ptr<VulkanDevice>& device)
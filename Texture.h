@@ -3,22 +3,50 @@
 #include <memory>
 #include <string>
 #include <vulkan/vulkan.h>
+#include "TextureCache.h"
 
 namespace my_vulkan
 {
 	class VulkanImage;
 	class VulkanDevice;
 	class VulkanDescriptors;
+	class VulkanUploader;
+
+	//Decoded rgba8 pixels, or the mapped blocks of the texture's cooked cache when it has one. Produced on a loader thread
+	//and consumed by Texture on the main thread
+	struct ImageData
+	{
+		ImageData() = default;
+		ImageData(const ImageData&) = delete;
+		ImageData& operator=(const ImageData&) = delete;
+		~ImageData();
+
+		static std::shared_ptr<ImageData> load(const std::string& filePath);
+
+		bool isCompressed() const { return cache.isOpen(); }
+
+		//null when compressed
+		unsigned char* pixels = nullptr;
+		TextureCache cache;
+		int width = 0;
+		int height = 0;
+		float loadTime = 0.0f;
+	};
 
 	class Texture
 	{
 	public:
-		Texture(const std::string& filePath, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
-		void createTextureImage(const std::string& filePath, const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
+		Texture(const std::string& filePath, const ImageData& imageData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		void createTextureImage(const ImageData& imageData, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		//rgba8 pixels, the mip chain is blitted on the gpu
+		void createTextureImage(const unsigned char* pixels, int texWidth, int texHeight, VkFormat format,
+			const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		//Uploads the cooked levels as they are, no blits
+		void createCompressedTextureImage(const TextureCache& cache, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
 
 		void createTextureSampler(const std::shared_ptr<VulkanDevice>& device);
 		void createDescriptor(const std::shared_ptr<VulkanDevice>& device);
-		void generateMipmaps(const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+		void generateMipmaps(const std::shared_ptr<VulkanDevice>& device, VkCommandBuffer commandBuffer, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
 		void destroyTexture(VkDevice device);
 
 		std::shared_ptr<VulkanImage>& getTextureImage() { return textureImage; }
@@ -28,6 +56,8 @@ namespace my_vulkan
 		bool operator==(const std::string& rhs) const { return name == rhs; }
 
 		uint32_t mipLevels;
+		//slot in the bindless texture table, only meaningful when the context has one
+		uint32_t bindlessIndex = 0;
 		std::string name;
 		std::shared_ptr<VulkanImage> textureImage;
 		std::shared_ptr<VulkanDescriptors> sampleDescriptor;
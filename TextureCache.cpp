@@ -0,0 +1,168 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <stb_image.h>
+#include "TextureCompressor.h"
+
+namespace
+{
+	constexpr uint32_t DXGI_FORMAT_BC5_UNORM = 83;
+	constexpr uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+	constexpr uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+	constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+	uint32_t toDxgiFormat(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC5_UNORM_BLOCK: return DXGI_FORMAT_BC5_UNORM;
+		case VK_FORMAT_BC7_UNORM_BLOCK: return DXGI_FORMAT_BC7_UNORM;
+		case VK_FORMAT_BC7_SRGB_BLOCK: return DXGI_FORMAT_BC7_UNORM_SRGB;
+		default: throw std::runtime_error("texture cache only holds bc7 and bc5!");
+		}
+	}
+
+	VkFormat fromDxgiFormat(uint32_t format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC5_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case DXGI_FORMAT_BC7_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
+		case DXGI_FORMAT_BC7_UNORM_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+}
+
+static_assert(sizeof(my_vulkan::TextureCache::Header) == 4 + 124 + 20, "dds header layout");
+
+bool my_vulkan::TextureCache::isNormalMap(const std::string& texturePath)
+{
+	std::string name = std::filesystem::path(texturePath).filename().string();
+	std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return name.find("normal") != std::string::npos;
+}
+
+size_t my_vulkan::TextureCache::cook(const std::string& texturePath, ThreadPool* threadPool)
+{
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(texturePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+		throw std::runtime_error("failed to load texture image : " + texturePath);
+	std::vector<uint8_t> level(pixels, pixels + size_t(width) * height * 4);
+	stbi_image_free(pixels);
+
+	bool normalMap = isNormalMap(texturePath);
+	VkFormat format = normalMap ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+
+	//the whole chain down to 1x1, filtered on the source pixels instead of the previous level's blocks
+	std::vector<std::vector<uint8_t>> levels;
+	uint32_t levelWidth = static_cast<uint32_t>(width), levelHeight = static_cast<uint32_t>(height);
+	while (true)
+	{
+		levels.push_back(TextureCompressor::compress(level.data(), levelWidth, levelHeight, format, threadPool));
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+		level = TextureCompressor::downsample(level.data(), levelWidth, levelHeight, !normalMap, normalMap);
+		levelWidth = std::max(levelWidth / 2, 1u);
+		levelHeight = std::max(levelHeight / 2, 1u);
+	}
+
+	write(getCachePath(texturePath), format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+
+	size_t size = sizeof(Header);
+	for (const auto& blocks : levels)
+		size += blocks.size();
+	return size;
+}
+
+void my_vulkan::TextureCache::write(const std::string& cachePath, VkFormat format, uint32_t width, uint32_t height,
+	const std::vector<std::vector<uint8_t>>& levels)
+{
+	Header fileHeader{};
+	fileHeader.magic = MAGIC;
+	fileHeader.size = 124;
+	//caps | height | width | pixel format | mip map count | linear size
+	fileHeader.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+	fileHeader.height = height;
+	fileHeader.width = width;
+	fileHeader.pitchOrLinearSize = static_cast<uint32_t>(levels.empty() ? 0 : levels[0].size());
+	fileHeader.mipMapCount = static_cast<uint32_t>(levels.size());
+	fileHeader.pixelFormat.size = sizeof(PixelFormat);
+	fileHeader.pixelFormat.flags = 0x4; //fourCC
+	fileHeader.pixelFormat.fourCC = FOURCC_DX10;
+	//texture | mipmap | complex
+	fileHeader.caps = 0x1000 | 0x400000 | 0x8;
+	fileHeader.dxgiFormat = toDxgiFormat(format);
+	fileHeader.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	fileHeader.arraySize = 1;
+
+	//Written to a temporary first so an interrupted run never leaves a half written cache behind
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+		{
+			std::cout << "cannot write texture cache : " << cachePath << std::endl;
+			return;
+		}
+
+		out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(Header));
+		for (const auto& blocks : levels)
+			out.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+		std::filesystem::remove(tempPath, error);
+}
+
+bool my_vulkan::TextureCache::open(const std::string& texturePath)
+{
+	close();
+
+	std::string cachePath = getCachePath(texturePath);
+	//A missing source is fine as long as the cache is intact, the cache then is the asset
+	std::error_code error;
+	auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+	if (error)
+		return false;
+	auto sourceTime = std::filesystem::last_write_time(texturePath, error);
+	if (!error && sourceTime > cacheTime)
+		return false;
+
+	if (!file.open(cachePath) || file.getSize() < sizeof(Header))
+		return false;
+
+	const auto* candidate = reinterpret_cast<const Header*>(file.getData());
+	VkFormat candidateFormat = fromDxgiFormat(candidate->dxgiFormat);
+	bool valid = candidate->magic == MAGIC && candidate->size == 124 && candidate->pixelFormat.fourCC == FOURCC_DX10 &&
+		candidateFormat != VK_FORMAT_UNDEFINED && candidate->resourceDimension == DDS_DIMENSION_TEXTURE2D &&
+		candidate->arraySize == 1 && candidate->width != 0 && candidate->height != 0 && candidate->mipMapCount != 0 &&
+		candidate->mipMapCount <= 32;
+
+	//the uploader copies every level straight out of the mapping, so they have to be all there
+	std::vector<VkDeviceSize> sizes;
+	VkDeviceSize total = 0;
+	for (uint32_t level = 0; valid && level != candidate->mipMapCount; ++level)
+	{
+		sizes.push_back(TextureCompressor::getCompressedSize(std::max(candidate->width >> level, 1u), std::max(candidate->height >> level, 1u)));
+		total += sizes.back();
+	}
+	if (!valid || sizeof(Header) + total > file.getSize())
+	{
+		file.close();
+		return false;
+	}
+
+	header = candidate;
+	format = candidateFormat;
+	levelSizes = std::move(sizes);
+	return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "MappedFile.h"
+
+namespace my_vulkan
+{
+	class ThreadPool;
+
+	//Block compressed mip chain of a texture, cooked offline next to the source as "<texture>.dds".
+	//Plain DDS with the DX10 extension header so other tools can open it: magic | DDS_HEADER | DDS_HEADER_DXT10 | levels,
+	//the levels back to back from the largest, which is exactly what the uploader copies from
+	class TextureCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x20534444; //"DDS "
+		static constexpr uint32_t FOURCC_DX10 = 0x30315844; //"DX10"
+
+		struct PixelFormat
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t fourCC;
+			uint32_t rgbBitCount;
+			uint32_t rBitMask;
+			uint32_t gBitMask;
+			uint32_t bBitMask;
+			uint32_t aBitMask;
+		};
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t size;
+			uint32_t flags;
+			uint32_t height;
+			uint32_t width;
+			uint32_t pitchOrLinearSize;
+			uint32_t depth;
+			uint32_t mipMapCount;
+			uint32_t reserved1[11];
+			PixelFormat pixelFormat;
+			uint32_t caps;
+			uint32_t caps2;
+			uint32_t caps3;
+			uint32_t caps4;
+			uint32_t reserved2;
+			//DDS_HEADER_DXT10
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension;
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+
+		static std::string getCachePath(const std::string& texturePath) { return texturePath + ".dds"; }
+		//Normal maps are cooked to BC5, everything else to sRGB BC7. Decided by "normal" in the file name
+		static bool isNormalMap(const std::string& texturePath);
+
+		//Decodes texturePath, builds the full mip chain and writes its cache, returns the bytes written. With a thread pool
+		//the blocks of each level are encoded in parallel, never pass the pool the caller itself runs on
+		static size_t cook(const std::string& texturePath, ThreadPool* threadPool = nullptr);
+		//levels[0] is width x height, every following level halves both down to 1x1
+		static void write(const std::string& cachePath, VkFormat format, uint32_t width, uint32_t height,
+			const std::vector<std::vector<uint8_t>>& levels);
+
+		//Maps the cache of texturePath, returns false when there is none, it is older than the source or holds a format
+		//the renderer does not read
+		bool open(const std::string& texturePath);
+		void close() { file.close(); header = nullptr; levelSizes.clear(); }
+		bool isOpen() const { return header != nullptr; }
+
+		VkFormat getFormat() const { return format; }
+		uint32_t getWidth() const { return header->width; }
+		uint32_t getHeight() const { return header->height; }
+		uint32_t getLevelCount() const { return static_cast<uint32_t>(levelSizes.size()); }
+		const std::vector<VkDeviceSize>& getLevelSizes() const { return levelSizes; }
+		//all levels, getDataSize() bytes
+		const uint8_t* getData() const { return file.getData() + sizeof(Header); }
+		size_t getDataSize() const { return file.getSize() - sizeof(Header); }
+
+	private:
+		MappedFile file;
+		const Header* header = nullptr;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		std::vector<VkDeviceSize> levelSizes;
+	};
+}
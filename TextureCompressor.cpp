@@ -0,0 +1,439 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include "ThreadPool.h"
+
+namespace
+{
+	constexpr int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//least significant bit first, the order every BC format packs its fields in
+	struct BitWriter
+	{
+		uint8_t* data;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t bits)
+		{
+			for (uint32_t i = 0; i != bits; ++i, ++position)
+				if ((value >> i) & 1)
+					data[position >> 3] |= uint8_t(1 << (position & 7));
+		}
+	};
+
+	struct BitReader
+	{
+		const uint8_t* data;
+		uint32_t position = 0;
+
+		uint32_t read(uint32_t bits)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i != bits; ++i, ++position)
+				value |= uint32_t((data[position >> 3] >> (position & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	int interpolateBC7(int e0, int e1, int weight)
+	{
+		return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+	}
+
+	//7 bit channels sharing one p-bit as their lowest bit, the p-bit with the smaller error wins
+	void quantizeBC7Endpoint(const float* endpoint, int* quantized, int& pbit)
+	{
+		float bestError = -1.0f;
+		for (int p = 0; p != 2; ++p)
+		{
+			int candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c != 4; ++c)
+			{
+				int q = std::clamp(int(std::lround((endpoint[c] - p) / 2.0f)), 0, 127);
+				candidate[c] = q;
+				float difference = float(q * 2 + p) - endpoint[c];
+				error += difference * difference;
+			}
+			if (bestError < 0.0f || error < bestError)
+			{
+				bestError = error;
+				pbit = p;
+				std::copy(candidate, candidate + 4, quantized);
+			}
+		}
+	}
+
+	//Picks the closest of the 16 palette entries for every pixel, returns the squared error
+	uint32_t fitBC7Indices(const uint8_t* rgba, const int* e0, const int* e1, uint8_t* indices)
+	{
+		int palette[16][4];
+		for (int i = 0; i != 16; ++i)
+			for (int c = 0; c != 4; ++c)
+				palette[i][c] = interpolateBC7(e0[c], e1[c], BC7_WEIGHTS4[i]);
+
+		uint32_t totalError = 0;
+		for (int pixel = 0; pixel != 16; ++pixel)
+		{
+			uint32_t bestError = ~0u;
+			for (int i = 0; i != 16; ++i)
+			{
+				uint32_t error = 0;
+				for (int c = 0; c != 4; ++c)
+				{
+					int difference = palette[i][c] - rgba[pixel * 4 + c];
+					error += uint32_t(difference * difference);
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[pixel] = uint8_t(i);
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	void getBC4Palette(int r0, int r1, int* palette)
+	{
+		palette[0] = r0;
+		palette[1] = r1;
+		if (r0 > r1)
+		{
+			for (int i = 1; i != 7; ++i)
+				palette[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+		}
+		else
+		{
+			for (int i = 1; i != 5; ++i)
+				palette[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	//One channel of rgba, the extremes become the endpoints of the eight value mode
+	void encodeBC4Block(const uint8_t* rgba, int channel, uint8_t* block)
+	{
+		int minimum = 255, maximum = 0;
+		for (int pixel = 0; pixel != 16; ++pixel)
+		{
+			minimum = std::min<int>(minimum, rgba[pixel * 4 + channel]);
+			maximum = std::max<int>(maximum, rgba[pixel * 4 + channel]);
+		}
+		int palette[8];
+		getBC4Palette(maximum, minimum, palette);
+
+		std::memset(block, 0, 8);
+		block[0] = uint8_t(maximum);
+		block[1] = uint8_t(minimum);
+		BitWriter writer{ block + 2 };
+		for (int pixel = 0; pixel != 16; ++pixel)
+		{
+			int value = rgba[pixel * 4 + channel];
+			int best = 0;
+			for (int i = 1; i != 8; ++i)
+				if (std::abs(palette[i] - value) < std::abs(palette[best] - value))
+					best = i;
+			writer.write(uint32_t(best), 3);
+		}
+	}
+
+	void decodeBC4Block(const uint8_t* block, int channel, uint8_t* rgba)
+	{
+		int palette[8];
+		getBC4Palette(block[0], block[1], palette);
+		BitReader reader{ block + 2 };
+		for (int pixel = 0; pixel != 16; ++pixel)
+			rgba[pixel * 4 + channel] = uint8_t(palette[reader.read(3)]);
+	}
+
+	float srgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+}
+
+void my_vulkan::TextureCompressor::encodeBC7Block(const uint8_t* rgba, uint8_t* block)
+{
+	//the principal axis of the pixels in RGBA space, by power iteration on their covariance
+	float mean[4] = {};
+	for (int pixel = 0; pixel != 16; ++pixel)
+		for (int c = 0; c != 4; ++c)
+			mean[c] += rgba[pixel * 4 + c] / 16.0f;
+	float covariance[4][4] = {};
+	for (int pixel = 0; pixel != 16; ++pixel)
+		for (int i = 0; i != 4; ++i)
+			for (int j = 0; j != 4; ++j)
+				covariance[i][j] += (rgba[pixel * 4 + i] - mean[i]) * (rgba[pixel * 4 + j] - mean[j]);
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration != 8; ++iteration)
+	{
+		float next[4] = {};
+		for (int i = 0; i != 4; ++i)
+			for (int j = 0; j != 4; ++j)
+				next[i] += covariance[i][j] * axis[j];
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length < 1e-6f)
+			break;
+		for (int i = 0; i != 4; ++i)
+			axis[i] = next[i] / length;
+	}
+
+	float minimum = 0.0f, maximum = 0.0f;
+	for (int pixel = 0; pixel != 16; ++pixel)
+	{
+		float t = 0.0f;
+		for (int c = 0; c != 4; ++c)
+			t += (rgba[pixel * 4 + c] - mean[c]) * axis[c];
+		minimum = std::min(minimum, t);
+		maximum = std::max(maximum, t);
+	}
+	float endpoints[2][4];
+	for (int c = 0; c != 4; ++c)
+	{
+		endpoints[0][c] = std::clamp(mean[c] + minimum * axis[c], 0.0f, 255.0f);
+		endpoints[1][c] = std::clamp(mean[c] + maximum * axis[c], 0.0f, 255.0f);
+	}
+
+	//quantize, pick indices, then refit the endpoints to those indices by least squares and try again
+	uint32_t bestError = ~0u;
+	int bestEndpoints[2][4] = {};
+	int bestPbits[2] = {};
+	uint8_t bestIndices[16] = {};
+	for (int iteration = 0; iteration != 3; ++iteration)
+	{
+		int quantized[2][4], pbits[2], expanded[2][4];
+		for (int e = 0; e != 2; ++e)
+		{
+			quantizeBC7Endpoint(endpoints[e], quantized[e], pbits[e]);
+			for (int c = 0; c != 4; ++c)
+				expanded[e][c] = quantized[e][c] * 2 + pbits[e];
+		}
+		uint8_t indices[16];
+		uint32_t error = fitBC7Indices(rgba, expanded[0], expanded[1], indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			std::memcpy(bestEndpoints, quantized, sizeof(quantized));
+			std::memcpy(bestPbits, pbits, sizeof(pbits));
+			std::memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (error == 0)
+			break;
+
+		float a = 0.0f, b = 0.0f, d = 0.0f, x0[4] = {}, x1[4] = {};
+		for (int pixel = 0; pixel != 16; ++pixel)
+		{
+			float w = BC7_WEIGHTS4[indices[pixel]] / 64.0f;
+			a += (1.0f - w) * (1.0f - w);
+			b += (1.0f - w) * w;
+			d += w * w;
+			for (int c = 0; c != 4; ++c)
+			{
+				x0[c] += (1.0f - w) * rgba[pixel * 4 + c];
+				x1[c] += w * rgba[pixel * 4 + c];
+			}
+		}
+		float determinant = a * d - b * b;
+		if (std::abs(determinant) < 1e-6f)
+			break;
+		for (int c = 0; c != 4; ++c)
+		{
+			endpoints[0][c] = std::clamp((d * x0[c] - b * x1[c]) / determinant, 0.0f, 255.0f);
+			endpoints[1][c] = std::clamp((a * x1[c] - b * x0[c]) / determinant, 0.0f, 255.0f);
+		}
+	}
+
+	//the first index is stored without its top bit, so it has to be below 8
+	if (bestIndices[0] >= 8)
+	{
+		for (int c = 0; c != 4; ++c)
+			std::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+		std::swap(bestPbits[0], bestPbits[1]);
+		for (auto& index : bestIndices)
+			index = uint8_t(15 - index);
+	}
+
+	std::memset(block, 0, BLOCK_SIZE);
+	BitWriter writer{ block };
+	writer.write(1 << 6, 7);
+	for (int c = 0; c != 4; ++c)
+	{
+		writer.write(uint32_t(bestEndpoints[0][c]), 7);
+		writer.write(uint32_t(bestEndpoints[1][c]), 7);
+	}
+	writer.write(uint32_t(bestPbits[0]), 1);
+	writer.write(uint32_t(bestPbits[1]), 1);
+	writer.write(bestIndices[0], 3);
+	for (int pixel = 1; pixel != 16; ++pixel)
+		writer.write(bestIndices[pixel], 4);
+}
+
+void my_vulkan::TextureCompressor::decodeBC7Block(const uint8_t* block, uint8_t* rgba)
+{
+	BitReader reader{ block };
+	uint32_t mode = 0;
+	while (mode != 8 && reader.read(1) == 0)
+		++mode;
+	if (mode != 6)
+		throw std::runtime_error("only bc7 mode 6 blocks can be decoded, found mode " + std::to_string(mode));
+
+	int endpoints[2][4];
+	for (int c = 0; c != 4; ++c)
+	{
+		endpoints[0][c] = int(reader.read(7));
+		endpoints[1][c] = int(reader.read(7));
+	}
+	for (int e = 0; e != 2; ++e)
+	{
+		int pbit = int(reader.read(1));
+		for (int c = 0; c != 4; ++c)
+			endpoints[e][c] = endpoints[e][c] * 2 + pbit;
+	}
+	for (int pixel = 0; pixel != 16; ++pixel)
+	{
+		int index = int(reader.read(pixel == 0 ? 3 : 4));
+		for (int c = 0; c != 4; ++c)
+			rgba[pixel * 4 + c] = uint8_t(interpolateBC7(endpoints[0][c], endpoints[1][c], BC7_WEIGHTS4[index]));
+	}
+}
+
+void my_vulkan::TextureCompressor::encodeBC5Block(const uint8_t* rgba, uint8_t* block)
+{
+	encodeBC4Block(rgba, 0, block);
+	encodeBC4Block(rgba, 1, block + 8);
+}
+
+void my_vulkan::TextureCompressor::decodeBC5Block(const uint8_t* block, uint8_t* rgba)
+{
+	decodeBC4Block(block, 0, rgba);
+	decodeBC4Block(block + 8, 1, rgba);
+	for (int pixel = 0; pixel != 16; ++pixel)
+	{
+		rgba[pixel * 4 + 2] = 0;
+		rgba[pixel * 4 + 3] = 255;
+	}
+}
+
+std::vector<uint8_t> my_vulkan::TextureCompressor::compress(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format,
+	ThreadPool* threadPool)
+{
+	if (format != VK_FORMAT_BC7_SRGB_BLOCK && format != VK_FORMAT_BC7_UNORM_BLOCK && format != VK_FORMAT_BC5_UNORM_BLOCK)
+		throw std::runtime_error("texture compressor only writes bc7 and bc5!");
+
+	uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	std::vector<uint8_t> blocks(getCompressedSize(width, height));
+	auto encodeRows = [&](uint32_t firstRow, uint32_t lastRow)
+	{
+		uint8_t pixels[64];
+		for (uint32_t by = firstRow; by != lastRow; ++by)
+		{
+			for (uint32_t bx = 0; bx != blocksX; ++bx)
+			{
+				for (uint32_t y = 0; y != 4; ++y)
+				{
+					uint32_t sourceY = std::min(by * 4 + y, height - 1);
+					for (uint32_t x = 0; x != 4; ++x)
+					{
+						uint32_t sourceX = std::min(bx * 4 + x, width - 1);
+						std::memcpy(pixels + (y * 4 + x) * 4, rgba + (size_t(sourceY) * width + sourceX) * 4, 4);
+					}
+				}
+				uint8_t* block = blocks.data() + (size_t(by) * blocksX + bx) * BLOCK_SIZE;
+				if (format == VK_FORMAT_BC5_UNORM_BLOCK)
+					encodeBC5Block(pixels, block);
+				else
+					encodeBC7Block(pixels, block);
+			}
+		}
+	};
+
+	if (!threadPool || blocksY < 2)
+	{
+		encodeRows(0, blocksY);
+		return blocks;
+	}
+	uint32_t jobCount = std::min(blocksY, threadPool->getThreadCount() * 4);
+	std::vector<std::future<void>> jobs;
+	for (uint32_t i = 0; i != jobCount; ++i)
+		jobs.push_back(threadPool->submit([&encodeRows, i, jobCount, blocksY]() { encodeRows(blocksY * i / jobCount, blocksY * (i + 1) / jobCount); }));
+	for (auto& job : jobs)
+		job.get();
+	return blocks;
+}
+
+std::vector<uint8_t> my_vulkan::TextureCompressor::decompress(const uint8_t* blocks, uint32_t width, uint32_t height, VkFormat format)
+{
+	uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	std::vector<uint8_t> rgba(size_t(width) * height * 4);
+	uint8_t pixels[64];
+	for (uint32_t by = 0; by != blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx != blocksX; ++bx)
+		{
+			const uint8_t* block = blocks + (size_t(by) * blocksX + bx) * BLOCK_SIZE;
+			if (format == VK_FORMAT_BC5_UNORM_BLOCK)
+				decodeBC5Block(block, pixels);
+			else
+				decodeBC7Block(block, pixels);
+			for (uint32_t y = 0; y != 4 && by * 4 + y < height; ++y)
+				for (uint32_t x = 0; x != 4 && bx * 4 + x < width; ++x)
+					std::memcpy(rgba.data() + ((size_t(by) * 4 + y) * width + bx * 4 + x) * 4, pixels + (y * 4 + x) * 4, 4);
+		}
+	}
+	return rgba;
+}
+
+std::vector<uint8_t> my_vulkan::TextureCompressor::downsample(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, bool normalMap)
+{
+	std::array<float, 256> toLinear;
+	for (int i = 0; i != 256; ++i)
+		toLinear[i] = srgb ? srgbToLinear(i / 255.0f) : i / 255.0f;
+
+	uint32_t nextWidth = std::max(width / 2, 1u), nextHeight = std::max(height / 2, 1u);
+	std::vector<uint8_t> next(size_t(nextWidth) * nextHeight * 4);
+	for (uint32_t y = 0; y != nextHeight; ++y)
+	{
+		for (uint32_t x = 0; x != nextWidth; ++x)
+		{
+			//odd sizes drop their last row or column, like the blits did
+			float sum[4] = {};
+			for (uint32_t sy = 0; sy != 2; ++sy)
+			{
+				for (uint32_t sx = 0; sx != 2; ++sx)
+				{
+					const uint8_t* pixel = rgba + (size_t(std::min(y * 2 + sy, height - 1)) * width + std::min(x * 2 + sx, width - 1)) * 4;
+					for (int c = 0; c != 3; ++c)
+						sum[c] += toLinear[pixel[c]] * 0.25f;
+					sum[3] += pixel[3] / 255.0f * 0.25f;
+				}
+			}
+			if (normalMap)
+			{
+				float n[3] = { sum[0] * 2.0f - 1.0f, sum[1] * 2.0f - 1.0f, sum[2] * 2.0f - 1.0f };
+				float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length > 1e-6f)
+					for (int c = 0; c != 3; ++c)
+						sum[c] = n[c] / length * 0.5f + 0.5f;
+			}
+			uint8_t* out = next.data() + (size_t(y) * nextWidth + x) * 4;
+			for (int c = 0; c != 3; ++c)
+				out[c] = uint8_t(std::lround(std::clamp(srgb ? linearToSrgb(sum[c]) : sum[c], 0.0f, 1.0f) * 255.0f));
+			out[3] = uint8_t(std::lround(std::clamp(sum[3], 0.0f, 1.0f) * 255.0f));
+		}
+	}
+	return next;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class ThreadPool;
+
+	//BC7 and BC5 block encoders for the offline texture cooker, with decoders so they can be checked on the cpu.
+	//BC7 only uses mode 6 (one subset, 7 bit RGBA endpoints with a p-bit each, 4 bit indices), so decodeBC7Block only
+	//reads that mode. BC5 is two BC4 blocks holding a normal map's x and y
+	class TextureCompressor
+	{
+	public:
+		//bytes per 4x4 block, the same for both formats
+		static constexpr uint32_t BLOCK_SIZE = 16;
+
+		//rgba holds the 4x4 pixels row by row
+		static void encodeBC7Block(const uint8_t* rgba, uint8_t* block);
+		static void decodeBC7Block(const uint8_t* block, uint8_t* rgba);
+		//Only reads r and g, decodes to (r, g, 0, 255)
+		static void encodeBC5Block(const uint8_t* rgba, uint8_t* block);
+		static void decodeBC5Block(const uint8_t* block, uint8_t* rgba);
+
+		//format is VK_FORMAT_BC7_SRGB_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK or VK_FORMAT_BC5_UNORM_BLOCK. Blocks go row by row,
+		//the ones over the edge repeat the last row and column. With a thread pool the block rows are split between workers,
+		//never pass the pool the caller itself runs on
+		static std::vector<uint8_t> compress(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format,
+			ThreadPool* threadPool = nullptr);
+		static std::vector<uint8_t> decompress(const uint8_t* blocks, uint32_t width, uint32_t height, VkFormat format);
+
+		//The next mip level with a 2x2 box filter, averaged in linear space when srgb. Normal maps are renormalized
+		static std::vector<uint8_t> downsample(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb, bool normalMap);
+
+		static size_t getCompressedSize(uint32_t width, uint32_t height) { return size_t((width + 3) / 4) * ((height + 3) / 4) * BLOCK_SIZE; }
+	};
+}
@@ -0,0 +1,39 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+my_vulkan::ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+	workers.reserve(threadCount);
+	for (uint32_t i = 0; i != threadCount; ++i)
+		workers.emplace_back([this]() { workerLoop(); });
+}
+
+void my_vulkan::ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping && jobs.empty())
+				return;
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+		job();
+	}
+}
+
+my_vulkan::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
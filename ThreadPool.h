@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace my_vulkan
+{
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		template<typename F>
+		auto submit(F&& job) -> std::future<decltype(job())>
+		{
+			using Result = decltype(job());
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+			std::future<Result> result = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.emplace([task]() { (*task)(); });
+			}
+			condition.notify_one();
+			return result;
+		}
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping = false;
+	};
+}
@@ -1 +1,78 @@
 #include "Vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+	uint16_t quantizeUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t quantizeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float signNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+my_vulkan::VertexQuantization my_vulkan::VertexQuantization::fromBounds(const glm::vec3& min, const glm::vec3& max)
+{
+	VertexQuantization quantization;
+	quantization.offset = min;
+	quantization.extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+	//a single point still needs an invertible matrix
+	if (quantization.extent <= 0.0f)
+		quantization.extent = 1.0f;
+	return quantization;
+}
+
+glm::mat4 my_vulkan::VertexQuantization::getMatrix() const
+{
+	return glm::scale(glm::translate(glm::mat4(1.0f), offset), glm::vec3(extent));
+}
+
+my_vulkan::CompressedVertex my_vulkan::CompressedVertex::encode(const Vertex& vertex, const VertexQuantization& quantization)
+{
+	CompressedVertex compressed{};
+	glm::vec3 pos = (vertex.pos - quantization.offset) / quantization.extent;
+	compressed.pos[0] = quantizeUnorm16(pos.x);
+	compressed.pos[1] = quantizeUnorm16(pos.y);
+	compressed.pos[2] = quantizeUnorm16(pos.z);
+
+	compressed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+	compressed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+
+	//project onto the octahedron and fold the lower half over the diagonals
+	float sum = std::abs(vertex.normal.x) + std::abs(vertex.normal.y) + std::abs(vertex.normal.z);
+	glm::vec3 normal = sum > 0.0f ? vertex.normal / sum : glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec2 octahedral(normal.x, normal.y);
+	if (normal.z < 0.0f)
+		octahedral = glm::vec2((1.0f - std::abs(normal.y)) * signNotZero(normal.x), (1.0f - std::abs(normal.x)) * signNotZero(normal.y));
+	compressed.normal[0] = quantizeSnorm16(octahedral.x);
+	compressed.normal[1] = quantizeSnorm16(octahedral.y);
+	return compressed;
+}
+
+my_vulkan::Vertex my_vulkan::CompressedVertex::decode(const VertexQuantization& quantization) const
+{
+	//mirrors what the vertex input formats and shader.vert do on the gpu
+	Vertex vertex{};
+	vertex.pos = quantization.offset + glm::vec3(pos[0], pos[1], pos[2]) * (quantization.extent / 65535.0f);
+	vertex.texCoord = glm::vec2(glm::unpackHalf1x16(texCoord[0]), glm::unpackHalf1x16(texCoord[1]));
+
+	glm::vec2 octahedral(std::max(normal[0] / 32767.0f, -1.0f), std::max(normal[1] / 32767.0f, -1.0f));
+	glm::vec3 n(octahedral.x, octahedral.y, 1.0f - std::abs(octahedral.x) - std::abs(octahedral.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	vertex.normal = glm::normalize(n);
+	return vertex;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
 #include "vulkan/vulkan.h"
@@ -49,6 +50,109 @@ namespace my_vulkan
 			return pos == other.pos && texCoord == other.texCoord && normal == other.normal;
 		}
 	};
+
+	//COMPRESSED meshes store CompressedVertex and are drawn with the graphics pipeline's compressed variant
+	enum class VertexFormat
+	{
+		FULL,
+		COMPRESSED
+	};
+
+	//Maps a quantized position back to mesh space, pos = offset + unorm16 * extent. extent is the longest side of the
+	//mesh bounds on every axis, so the mapping is a translation and a uniform scale that folds into the model matrix
+	//without bending normals
+	struct VertexQuantization
+	{
+		glm::vec3 offset{ 0.0f };
+		float extent = 1.0f;
+
+		static VertexQuantization fromBounds(const glm::vec3& min, const glm::vec3& max);
+		glm::mat4 getMatrix() const;
+	};
+
+	//16 bytes against Vertex's 32: the position as unorm16 against the mesh bounds, texCoord as half floats and the
+	//normal octahedral encoded in two snorm16. shader.vert built with COMPRESSED decodes the normal, the rest the vertex
+	//input formats and VertexQuantization::getMatrix do
+	struct CompressedVertex
+	{
+		//w is padding, three component 16 bit formats are rarely supported as vertex input
+		uint16_t pos[4];
+		uint16_t texCoord[2];
+		int16_t normal[2];
+
+		static CompressedVertex encode(const Vertex& vertex, const VertexQuantization& quantization);
+		Vertex decode(const VertexQuantization& quantization) const;
+
+		static VkVertexInputBindingDescription getBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(CompressedVertex);
+			bindingDescription.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		//Same locations as Vertex, so the shaders only differ in how they read the normal
+		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset = offsetof(CompressedVertex, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(CompressedVertex, texCoord);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[2].offset = offsetof(CompressedVertex, normal);
+
+			return attributeDescriptions;
+		}
+	};
+
+	inline size_t getVertexStride(VertexFormat format)
+	{
+		return format == VertexFormat::COMPRESSED ? sizeof(CompressedVertex) : sizeof(Vertex);
+	}
+
+	//Per-instance input of the instanced pipeline, the model matrix takes the four locations after the vertex attributes
+	struct InstanceData
+	{
+		glm::mat4 model;
+
+		static VkVertexInputBindingDescription getBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+
+			bindingDescription.binding = 1;
+			bindingDescription.stride = sizeof(InstanceData);
+			bindingDescription.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE; //Move to the next entry after each instance
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions()
+		{
+			//a mat4 input is four vec4 columns on consecutive locations
+			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+			for (uint32_t i = 0; i != 4; ++i)
+			{
+				attributeDescriptions[i].binding = 1;
+				attributeDescriptions[i].location = 3 + i;
+				attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				attributeDescriptions[i].offset = offsetof(InstanceData, model) + sizeof(glm::vec4) * i;
+			}
+
+			return attributeDescriptions;
+		}
+	};
 }
 
 namespace std
@@ -59,10 +163,11 @@ namespace std
 		{
 			size_t hashValue = 0;
 
-			// Hash each component using the std::hash function
-			hashValue ^= std::hash<glm::vec3>()(vertex.pos);
-			hashValue ^= std::hash<glm::vec3>()(vertex.normal);
-			hashValue ^= std::hash<glm::vec2>()(vertex.texCoord);
+			// Combine the component hashes order dependently, xoring them made mirrored attributes collide
+			auto combine = [&hashValue](size_t value) { hashValue ^= value + 0x9e3779b97f4a7c15ull + (hashValue << 6) + (hashValue >> 2); };
+			combine(std::hash<glm::vec3>()(vertex.pos));
+			combine(std::hash<glm::vec3>()(vertex.normal));
+			combine(std::hash<glm::vec2>()(vertex.texCoord));
 
 			return hashValue;
 		}
@@ -0,0 +1,69 @@
+#include "VertexWelder.h"
+
+#include <cstring>
+#include "Vertex.h"
+
+my_vulkan::VertexWelder::VertexWelder(std::vector<Vertex>& vertices, size_t expectedCount)
+	: vertices(vertices)
+{
+	//kept at most half full
+	size_t capacity = 64;
+	while (capacity < expectedCount * 2)
+		capacity *= 2;
+	rehash(capacity);
+}
+
+uint64_t my_vulkan::VertexWelder::hash(const Vertex& vertex)
+{
+	//every float's bits go through their own multiply, so swapping or mirroring components changes the hash
+	const float* values[] = { &vertex.pos.x, &vertex.pos.y, &vertex.pos.z, &vertex.texCoord.x, &vertex.texCoord.y,
+		&vertex.normal.x, &vertex.normal.y, &vertex.normal.z };
+	uint64_t hash = 0x9E3779B97F4A7C15ull;
+	for (const float* value : values)
+	{
+		//-0 compares equal to 0, so it has to hash the same
+		float component = *value == 0.0f ? 0.0f : *value;
+		uint32_t bits;
+		std::memcpy(&bits, &component, sizeof(bits));
+		hash = (hash ^ bits) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 32;
+	}
+	//murmur3's finalizer
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+uint32_t my_vulkan::VertexWelder::weld(const Vertex& vertex)
+{
+	if ((vertices.size() + 1) * 2 > slots.size())
+		rehash(slots.size() * 2);
+
+	for (size_t slot = hash(vertex) & mask;; slot = (slot + 1) & mask)
+	{
+		uint32_t index = slots[slot];
+		if (index == EMPTY)
+		{
+			index = static_cast<uint32_t>(vertices.size());
+			slots[slot] = index;
+			vertices.push_back(vertex);
+			return index;
+		}
+		if (vertices[index] == vertex)
+			return index;
+	}
+}
+
+void my_vulkan::VertexWelder::rehash(size_t capacity)
+{
+	slots.assign(capacity, EMPTY);
+	mask = capacity - 1;
+	for (uint32_t index = 0; index != vertices.size(); ++index)
+	{
+		size_t slot = hash(vertices[index]) & mask;
+		while (slots[slot] != EMPTY)
+			slot = (slot + 1) & mask;
+		slots[slot] = index;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace my_vulkan
+{
+	struct Vertex;
+
+	//Merges identical vertices while a mesh is parsed. An open addressing table of indices into the output vertices,
+	//linear probing on a mixed 64 bit hash of the vertex bits, so each corner costs one probe sequence and no allocation
+	class VertexWelder
+	{
+	public:
+		//expectedCount sizes the table up front, it grows past that anyway
+		VertexWelder(std::vector<Vertex>& vertices, size_t expectedCount = 0);
+
+		//Index of the vertex equal to vertex, appending it to the vertices first if there is none
+		uint32_t weld(const Vertex& vertex);
+
+		static uint64_t hash(const Vertex& vertex);
+
+	private:
+		static constexpr uint32_t EMPTY = ~0u;
+
+		void rehash(size_t capacity);
+
+		std::vector<Vertex>& vertices;
+		std::vector<uint32_t> slots;
+		size_t mask = 0;
+	};
+}
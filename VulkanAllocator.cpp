@@ -0,0 +1,325 @@
+#include "VulkanAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "VulkanUtils.h"
+
+namespace my_vulkan
+{
+	//One vkAllocateMemory carved into power of two nodes. Level 0 is the whole block, every level halves the node size
+	struct VulkanMemoryBlock
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint8_t* mapped = nullptr;
+		uint32_t maxLevel = 0;
+		std::vector<std::unordered_set<VkDeviceSize>> freeNodes;
+		uint32_t allocationCount = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize allocatedBytes = 0;
+
+		VkDeviceSize nodeSize(uint32_t level) const { return size >> level; }
+
+		bool allocate(uint32_t level, VkDeviceSize& offset)
+		{
+			//find the smallest free node that fits and split it down to the requested level
+			int32_t found = static_cast<int32_t>(level);
+			while (found >= 0 && freeNodes[found].empty())
+				--found;
+			if (found < 0)
+				return false;
+
+			offset = *freeNodes[found].begin();
+			freeNodes[found].erase(freeNodes[found].begin());
+			for (uint32_t i = static_cast<uint32_t>(found); i < level; ++i)
+				freeNodes[i + 1].insert(offset + nodeSize(i + 1));
+			return true;
+		}
+
+		void free(VkDeviceSize offset, uint32_t level)
+		{
+			//merge with the buddy for as long as it is free as well
+			while (level > 0)
+			{
+				VkDeviceSize buddy = offset ^ nodeSize(level);
+				auto it = freeNodes[level].find(buddy);
+				if (it == freeNodes[level].end())
+					break;
+				freeNodes[level].erase(it);
+				offset = std::min(offset, buddy);
+				--level;
+			}
+			freeNodes[level].insert(offset);
+		}
+
+		VkDeviceSize largestFreeNode() const
+		{
+			for (uint32_t level = 0; level <= maxLevel; ++level)
+				if (!freeNodes[level].empty())
+					return nodeSize(level);
+			return 0;
+		}
+	};
+}
+
+my_vulkan::VulkanAllocator::VulkanAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+	: physicalDevice(physicalDevice), device(device)
+{
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	//two pools per memory type, one for linear resources and one for optimal tiling images
+	pools.resize(memoryProperties.memoryTypeCount * 2);
+	for (uint32_t i = 0; i != memoryProperties.memoryTypeCount; ++i)
+	{
+		//small heaps such as the host visible BAR window get smaller blocks so one block can't eat the heap
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+		while (blockSize > heapSize / 8 && blockSize > MIN_ALLOCATION_SIZE)
+			blockSize >>= 1;
+
+		pools[i * 2].memoryTypeIndex = pools[i * 2 + 1].memoryTypeIndex = i;
+		pools[i * 2].blockSize = pools[i * 2 + 1].blockSize = blockSize;
+	}
+}
+
+my_vulkan::VulkanAllocation my_vulkan::VulkanAllocator::allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags requiredProperties)
+{
+	VkMemoryDedicatedRequirements dedicatedRequirements{};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+	VkMemoryRequirements2 requirements{};
+	requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	requirements.pNext = &dedicatedRequirements;
+	VkBufferMemoryRequirementsInfo2 info{};
+	info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+	info.buffer = buffer;
+	vkGetBufferMemoryRequirements2(device, &info, &requirements);
+
+	VulkanAllocation allocation = allocate(requirements.memoryRequirements, dedicatedRequirements, requiredProperties, false, buffer, VK_NULL_HANDLE);
+	if (vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+		throw std::runtime_error("failed to bind buffer memory!");
+	return allocation;
+}
+
+my_vulkan::VulkanAllocation my_vulkan::VulkanAllocator::allocateImageMemory(VkImage image, VkMemoryPropertyFlags requiredProperties, VkImageTiling tiling)
+{
+	VkMemoryDedicatedRequirements dedicatedRequirements{};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+	VkMemoryRequirements2 requirements{};
+	requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	requirements.pNext = &dedicatedRequirements;
+	VkImageMemoryRequirementsInfo2 info{};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+	info.image = image;
+	vkGetImageMemoryRequirements2(device, &info, &requirements);
+
+	VulkanAllocation allocation = allocate(requirements.memoryRequirements, dedicatedRequirements, requiredProperties,
+		tiling == VK_IMAGE_TILING_OPTIMAL, VK_NULL_HANDLE, image);
+	if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS)
+		throw std::runtime_error("failed to bind image memory!");
+	return allocation;
+}
+
+my_vulkan::VulkanAllocation my_vulkan::VulkanAllocator::allocate(const VkMemoryRequirements& requirements,
+	const VkMemoryDedicatedRequirements& dedicatedRequirements, VkMemoryPropertyFlags requiredProperties, bool optimalTiling,
+	VkBuffer dedicatedBuffer, VkImage dedicatedImage)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	uint32_t memoryTypeIndex = VulkanUtils::findMemoryType(physicalDevice, requiredProperties, requirements.memoryTypeBits);
+	uint32_t poolIndex = memoryTypeIndex * 2 + (optimalTiling ? 1 : 0);
+	Pool& pool = pools[poolIndex];
+
+	//render targets and other large images would waste most of a block, the driver may also ask for it explicitly
+	if (dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation ||
+		requirements.size > pool.blockSize / 2 || requirements.alignment > pool.blockSize)
+		return allocateDedicated(requirements.size, memoryTypeIndex, dedicatedBuffer, dedicatedImage);
+
+	//nodes are aligned to their own size, so a node at least as large as the alignment satisfies it
+	VkDeviceSize nodeSize = MIN_ALLOCATION_SIZE;
+	while (nodeSize < requirements.size || nodeSize < requirements.alignment)
+		nodeSize <<= 1;
+
+	VulkanAllocation allocation{};
+	allocation.allocator = this;
+	allocation.size = requirements.size;
+	allocation.poolIndex = poolIndex;
+
+	for (auto& block : pool.blocks)
+	{
+		uint32_t level = block->maxLevel;
+		while (block->nodeSize(level) < nodeSize)
+			--level;
+		if (block->allocate(level, allocation.offset))
+		{
+			allocation.block = block.get();
+			allocation.level = level;
+			break;
+		}
+	}
+
+	if (allocation.block == nullptr)
+	{
+		VulkanMemoryBlock* block = createBlock(pool);
+		uint32_t level = block->maxLevel;
+		while (block->nodeSize(level) < nodeSize)
+			--level;
+		block->allocate(level, allocation.offset);
+		allocation.block = block;
+		allocation.level = level;
+	}
+
+	VulkanMemoryBlock* block = allocation.block;
+	++block->allocationCount;
+	block->usedBytes += requirements.size;
+	block->allocatedBytes += block->nodeSize(allocation.level);
+	allocation.memory = block->memory;
+	allocation.mapped = block->mapped != nullptr ? block->mapped + allocation.offset : nullptr;
+	return allocation;
+}
+
+my_vulkan::VulkanAllocation my_vulkan::VulkanAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, VkBuffer buffer, VkImage image)
+{
+	VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+	dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+	dedicatedInfo.buffer = buffer;
+	dedicatedInfo.image = image;
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.pNext = &dedicatedInfo;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VulkanAllocation allocation{};
+	allocation.allocator = this;
+	allocation.size = size;
+	allocation.dedicated = true;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate dedicated memory!");
+
+	if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		vkMapMemory(device, allocation.memory, 0, size, 0, &allocation.mapped);
+
+	++dedicatedAllocationCount;
+	dedicatedBytes += size;
+	return allocation;
+}
+
+my_vulkan::VulkanMemoryBlock* my_vulkan::VulkanAllocator::createBlock(Pool& pool)
+{
+	auto block = std::make_unique<VulkanMemoryBlock>();
+	block->size = pool.blockSize;
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = block->size;
+	allocInfo.memoryTypeIndex = pool.memoryTypeIndex;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate memory block!");
+
+	if (memoryProperties.memoryTypes[pool.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		void* mapped;
+		vkMapMemory(device, block->memory, 0, block->size, 0, &mapped);
+		block->mapped = static_cast<uint8_t*>(mapped);
+	}
+
+	for (VkDeviceSize nodeSize = block->size; nodeSize > MIN_ALLOCATION_SIZE; nodeSize >>= 1)
+		++block->maxLevel;
+	block->freeNodes.resize(block->maxLevel + 1);
+	block->freeNodes[0].insert(0);
+
+	pool.blocks.push_back(std::move(block));
+	return pool.blocks.back().get();
+}
+
+void my_vulkan::VulkanAllocator::destroyBlock(VulkanMemoryBlock* block)
+{
+	if (block->mapped != nullptr)
+		vkUnmapMemory(device, block->memory);
+	vkFreeMemory(device, block->memory, nullptr);
+}
+
+void my_vulkan::VulkanAllocator::free(VulkanAllocation& allocation)
+{
+	if (allocation.memory == VK_NULL_HANDLE)
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (allocation.dedicated)
+	{
+		if (allocation.mapped != nullptr)
+			vkUnmapMemory(device, allocation.memory);
+		vkFreeMemory(device, allocation.memory, nullptr);
+		--dedicatedAllocationCount;
+		dedicatedBytes -= allocation.size;
+	}
+	else
+	{
+		VulkanMemoryBlock* block = allocation.block;
+		block->free(allocation.offset, allocation.level);
+		--block->allocationCount;
+		block->usedBytes -= allocation.size;
+		block->allocatedBytes -= block->nodeSize(allocation.level);
+
+		//keep one empty block around per pool so load/unload cycles don't hit vkAllocateMemory every time
+		Pool& pool = pools[allocation.poolIndex];
+		if (block->allocationCount == 0 && pool.blocks.size() > 1)
+		{
+			destroyBlock(block);
+			pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+				[block](const std::unique_ptr<VulkanMemoryBlock>& b) { return b.get() == block; }));
+		}
+	}
+	allocation = VulkanAllocation{};
+}
+
+my_vulkan::VulkanAllocatorStats my_vulkan::VulkanAllocator::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	VulkanAllocatorStats stats{};
+	VkDeviceSize freeBytes = 0;
+	VkDeviceSize largestFreeBytes = 0;
+	for (const auto& pool : pools)
+	{
+		for (const auto& block : pool.blocks)
+		{
+			VkDeviceSize largest = block->largestFreeNode();
+			++stats.blockCount;
+			stats.allocationCount += block->allocationCount;
+			stats.bytesReserved += block->size;
+			stats.bytesUsed += block->usedBytes;
+			stats.bytesAllocated += block->allocatedBytes;
+			stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+			freeBytes += block->size - block->allocatedBytes;
+			largestFreeBytes += largest;
+		}
+	}
+
+	stats.dedicatedAllocationCount = dedicatedAllocationCount;
+	stats.allocationCount += dedicatedAllocationCount;
+	stats.bytesReserved += dedicatedBytes;
+	stats.bytesUsed += dedicatedBytes;
+	stats.bytesAllocated += dedicatedBytes;
+	stats.fragmentation = freeBytes > 0 ? 1.0f - static_cast<float>(largestFreeBytes) / static_cast<float>(freeBytes) : 0.0f;
+	return stats;
+}
+
+void my_vulkan::VulkanAllocator::destroyAllocator()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& pool : pools)
+	{
+		for (auto& block : pool.blocks)
+			destroyBlock(block.get());
+		pool.blocks.clear();
+	}
+}
+
+my_vulkan::VulkanAllocator::~VulkanAllocator()
+{
+
+}
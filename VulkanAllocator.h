@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class VulkanAllocator;
+	struct VulkanMemoryBlock;
+
+	//A range of device memory handed out by VulkanAllocator, the resource is already bound to memory + offset
+	struct VulkanAllocation
+	{
+		VulkanAllocator* allocator = nullptr;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		//persistently mapped pointer to offset, null unless the memory type is host visible
+		void* mapped = nullptr;
+
+		VulkanMemoryBlock* block = nullptr;
+		uint32_t poolIndex = 0;
+		uint32_t level = 0;
+		bool dedicated = false;
+	};
+
+	struct VulkanAllocatorStats
+	{
+		uint32_t blockCount = 0;
+		uint32_t dedicatedAllocationCount = 0;
+		uint32_t allocationCount = 0;
+		//device memory owned by blocks and dedicated allocations
+		VkDeviceSize bytesReserved = 0;
+		//bytes the resources asked for
+		VkDeviceSize bytesUsed = 0;
+		//power of two nodes handed out, the gap to bytesUsed is internal fragmentation
+		VkDeviceSize bytesAllocated = 0;
+		VkDeviceSize largestFreeRange = 0;
+		//share of free block memory that is not part of its block's largest free range
+		float fragmentation = 0.0f;
+	};
+
+	//Sub-allocates buffers and images out of large per-memory-type blocks with a buddy allocator.
+	//Linear and optimal tiling resources come from separate blocks so bufferImageGranularity never has to be
+	//checked between neighbours, and resources the driver wants dedicated memory for get their own allocation
+	class VulkanAllocator
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+		static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+
+		VulkanAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+		~VulkanAllocator();
+
+		VulkanAllocation allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags requiredProperties);
+		VulkanAllocation allocateImageMemory(VkImage image, VkMemoryPropertyFlags requiredProperties, VkImageTiling tiling);
+		void free(VulkanAllocation& allocation);
+
+		VulkanAllocatorStats getStats();
+
+		void destroyAllocator();
+
+	private:
+		struct Pool
+		{
+			uint32_t memoryTypeIndex;
+			VkDeviceSize blockSize;
+			std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks;
+		};
+
+		VulkanAllocation allocate(const VkMemoryRequirements& requirements, const VkMemoryDedicatedRequirements& dedicatedRequirements,
+			VkMemoryPropertyFlags requiredProperties, bool optimalTiling, VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+		VulkanAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex, VkBuffer buffer, VkImage image);
+		VulkanMemoryBlock* createBlock(Pool& pool);
+		void destroyBlock(VulkanMemoryBlock* block);
+
+		VkPhysicalDevice physicalDevice;
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		std::vector<Pool> pools;
+		std::mutex mutex;
+
+		uint32_t dedicatedAllocationCount = 0;
+		VkDeviceSize dedicatedBytes = 0;
+	};
+}
@@ -0,0 +1,93 @@
+#include "VulkanBindlessTextures.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanDevice.h"
+#include "VulkanDescriptorLayoutCache.h"
+
+my_vulkan::VulkanBindlessTextures::VulkanBindlessTextures(const std::shared_ptr<VulkanDevice>& device)
+	: device(device->getLogicalDevice())
+{
+	createDescriptorSet(device);
+}
+
+void my_vulkan::VulkanBindlessTextures::createDescriptorSet(const std::shared_ptr<VulkanDevice>& device)
+{
+	VkPhysicalDeviceVulkan12Properties properties12{};
+	properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &properties12;
+	vkGetPhysicalDeviceProperties2(device->getPhysicalDevice(), &properties);
+	capacity = std::min({ MAX_BINDLESS_TEXTURES, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		properties12.maxDescriptorSetUpdateAfterBindSampledImages });
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorCount = capacity;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	//slots past textureCount are never written, and new textures are added while earlier frames are in flight
+	VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+	descriptorSetLayout = device->getDescriptorLayoutCache()->getLayout({ binding }, { bindingFlags },
+		VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = capacity;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if (vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create bindless descriptor pool!");
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &descriptorSetLayout;
+
+	if (vkAllocateDescriptorSets(this->device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate bindless descriptor set!");
+}
+
+uint32_t my_vulkan::VulkanBindlessTextures::registerTexture(VkImageView imageView, VkSampler sampler)
+{
+	if (textureCount == capacity)
+		throw std::runtime_error("bindless texture table is full!");
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = sampler;
+
+	VkWriteDescriptorSet writeInfo{};
+	writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeInfo.descriptorCount = 1;
+	writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writeInfo.dstSet = descriptorSet;
+	writeInfo.dstBinding = 0;
+	writeInfo.dstArrayElement = textureCount;
+	writeInfo.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(device, 1, &writeInfo, 0, nullptr);
+
+	return textureCount++;
+}
+
+void my_vulkan::VulkanBindlessTextures::destroyBindlessTextures(const VkDevice& device)
+{
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+}
+
+my_vulkan::VulkanBindlessTextures::~VulkanBindlessTextures()
+{
+
+}
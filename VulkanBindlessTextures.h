@@ -0,0 +1,38 @@
+#pragma once
+#include <memory>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+
+	//One update-after-bind descriptor set holding a sampler2D[] of every texture in the scene. It is bound once per
+	//frame and meshes pick their texture with the index registerTexture returned, passed through push constants
+	class VulkanBindlessTextures
+	{
+	public:
+		static constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+
+		VulkanBindlessTextures(const std::shared_ptr<VulkanDevice>& device);
+
+		uint32_t registerTexture(VkImageView imageView, VkSampler sampler);
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+		VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+		uint32_t getTextureCount() const { return textureCount; }
+
+		void destroyBindlessTextures(const VkDevice& device);
+
+		~VulkanBindlessTextures();
+
+	private:
+		void createDescriptorSet(const std::shared_ptr<VulkanDevice>& device);
+
+		VkDevice device;
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorPool descriptorPool;
+		VkDescriptorSet descriptorSet;
+		uint32_t capacity;
+		uint32_t textureCount = 0;
+	};
+}
@@ -4,16 +4,31 @@
 
 #include "VulkanDevice.h"
 #include "VulkanUtils.h"
+#include "VulkanPipelineCache.h"
 
-my_vulkan::VulkanComputePipeline::VulkanComputePipeline(const std::shared_ptr<VulkanDevice>& device)
+my_vulkan::VulkanComputePipeline::VulkanComputePipeline(const std::shared_ptr<VulkanDevice>& device, const std::string& shaderPath,
+	const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
 {
-	createComputePipeline(device);
+	createComputePipeline(device, shaderPath, setLayouts, pushConstantRanges);
 }
 
-void my_vulkan::VulkanComputePipeline::createComputePipeline(const std::shared_ptr<VulkanDevice>& device)
+void my_vulkan::VulkanComputePipeline::createComputePipeline(const std::shared_ptr<VulkanDevice>& device, const std::string& shaderPath,
+	const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
 {
-	auto computeShader = VulkanUtils::readFile("shaders/compute.spv");
-	auto computeShaderModule = VulkanUtils::createShaderModule(computeShader, device->getLogicalDevice());
+	//the layout has to exist before the pipeline referencing it
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	if (vkCreatePipelineLayout(device->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline layout!");
+	}
+
+	VulkanPipelineCache* pipelineCache = device->getPipelineCache().get();
+	auto computeShaderModule = pipelineCache->getShaderModule(shaderPath);
 
 	VkPipelineShaderStageCreateInfo computeShaderStageCreateInfo{};
 	computeShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -26,20 +41,12 @@ void my_vulkan::VulkanComputePipeline::createComputePipeline(const std::shared_p
 	pipelineInfo.layout = computePipelineLayout;
 	pipelineInfo.stage = computeShaderStageCreateInfo;
 
-	if(vkCreateComputePipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+	if(vkCreateComputePipelines(device->getLogicalDevice(), pipelineCache->getPipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
 		throw std::runtime_error("failed to create compute pipeline!");
+}
 
-	auto setLayout = VulkanUtils::createDescriptorSetLayout(device->getLogicalDevice(), VulkanDescriptorFor::COMPUTE_SHADER_UNIFORM_BUFFER);
-
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &setLayout;
-
-	if (vkCreatePipelineLayout(device->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create compute pipeline layout!");
-	}
-
-	vkDestroyShaderModule(device->getLogicalDevice(), computeShaderModule, nullptr);
-
+void my_vulkan::VulkanComputePipeline::destroyComputePipeline(const VkDevice& device)
+{
+	vkDestroyPipeline(device, computePipeline, nullptr);
+	vkDestroyPipelineLayout(device, computePipelineLayout, nullptr);
 }
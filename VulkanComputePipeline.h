@@ -1,5 +1,7 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "vulkan/vulkan.h"
 
@@ -13,17 +15,20 @@ namespace my_vulkan
 	{
 	public:
 
-		VulkanComputePipeline(const std::shared_ptr<VulkanDevice>& device);
+		VulkanComputePipeline(const std::shared_ptr<VulkanDevice>& device, const std::string& shaderPath,
+			const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges = {});
 
-		void createComputePipeline(const std::shared_ptr<VulkanDevice>& device);
+		void createComputePipeline(const std::shared_ptr<VulkanDevice>& device, const std::string& shaderPath,
+			const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
 
 		VkPipeline getComputePipeline() { return computePipeline; }
 		VkPipelineLayout& getComputePipelineLayout() { return computePipelineLayout; }
 
+		void destroyComputePipeline(const VkDevice& device);
+
 	private:
 		VkPipeline computePipeline;
 		VkPipelineLayout computePipelineLayout;
 	};
 
 }
-
@@ -9,52 +9,121 @@
 #include "VulkanUtils.h"
 #include "Vertex.h"
 #include "Camera.h"
+#ifndef MY_VULKAN_HEADLESS_ONLY
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_vulkan.h>
-#include "Arona.h"
 #include "imgui_internal.h"
+#endif
+#include "Arona.h"
 #include "VulkanUtils.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "VulkanUploader.h"
+#include "VulkanUniformArena.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanBindlessTextures.h"
+#include "MeshRegistry.h"
+#include "VulkanIndirectDraws.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "VulkanPipelineManager.h"
 
-my_vulkan::VulkanContext::VulkanContext() : startTime(clock.now())
+my_vulkan::VulkanContext::VulkanContext(bool headless) : headless(headless), wind(WIDTH, HEIGHT, "Vulkan", headless), startTime(clock.now())
 {
 	
-	instance = std::make_shared<VulkanInstance>(enableValidationLayer, validationLayers);
+	instance = std::make_shared<VulkanInstance>(enableValidationLayer, validationLayers, headless);
+
+	if (!headless)
+		createWindowSurface();
+
+	device = std::make_shared<VulkanDevice>(enableValidationLayer, instance->getInstance(), surface,
+		headless ? headlessDeviceExtensions : deviceExtensions, validationLayers);
 
-	createWindowSurface();
+	if (headless)
+		swapChain = std::make_shared<VulkanSwapChain>(device, VkExtent2D{ WIDTH, HEIGHT }, MAX_RENDER_IMAGES);
+	else
+		swapChain = std::make_shared<VulkanSwapChain>(device->getPhysicalDevice(), device->getLogicalDevice(), surface, wind.window);
 
-	device = std::make_shared<VulkanDevice>(enableValidationLayer, instance->getInstance(), surface, deviceExtensions, validationLayers);
+	createUploadCommandPool(device->getLogicalDevice(), device->getPhysicalDevice());
 
-	swapChain = std::make_shared<VulkanSwapChain>(device->getPhysicalDevice(), device->getLogicalDevice(), surface, wind.window);
+	threadPool = std::make_shared<ThreadPool>();
+	assetLoader = std::make_shared<AssetLoader>(threadPool.get());
+	uploader = std::make_shared<VulkanUploader>(device, uploadCommandPool);
+	meshRegistry = std::make_shared<MeshRegistry>();
+	uniformArena = std::make_shared<VulkanUniformArena>(device);
+	profiler = std::make_shared<Profiler>(device);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+		frameDescriptorAllocators.push_back(std::make_shared<VulkanDescriptorAllocator>(device->getLogicalDevice(), false));
 
-	createCommandPool(device->getLogicalDevice(), device->getPhysicalDevice());
+	if (device->supportsBindlessTextures())
+		bindlessTextures = std::make_shared<VulkanBindlessTextures>(device);
+	if (device->supportsIndirectDrawCount())
+		indirectDraws = std::make_shared<VulkanIndirectDraws>(device, meshRegistry.get());
 
-	graphicsPipeline = std::make_shared<VulkanGraphicsPipeline>(device, swapChain, commandPool);
+	graphicsPipeline = std::make_shared<VulkanGraphicsPipeline>(device, swapChain, uploadCommandPool, bindlessTextures.get(),
+		indirectDraws ? indirectDraws->getDescriptorSetLayout() : VK_NULL_HANDLE);
+	pipelineManager = std::make_shared<VulkanPipelineManager>(device->getLogicalDevice(), graphicsPipeline.get(), threadPool.get());
 }
 
 void my_vulkan::VulkanContext::createWindowSurface()
 {
+	//without glfw the window already refused to open
+#ifndef MY_VULKAN_HEADLESS_ONLY
 	if (glfwCreateWindowSurface(instance->getInstance(), wind.window, nullptr, &surface) != VK_SUCCESS)
 		throw std::runtime_error("failed to create window surface!");
+#endif
 }
 
-void my_vulkan::VulkanContext::createCommandPool(const VkDevice& device, const VkPhysicalDevice& physicalDevice)
+void my_vulkan::VulkanContext::createUploadCommandPool(const VkDevice& device, const VkPhysicalDevice& physicalDevice)
 {
 	VkCommandPoolCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	createInfo.queueFamilyIndex = VulkanDevice::queryQueueFamilyIndices(physicalDevice).graphicsAndComputeQueue.value();
-	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	if (vkCreateCommandPool(device, &createInfo, nullptr, &commandPool) != VK_SUCCESS)
+	//one-shot buffers are short lived and freed one by one as their batch retires
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	if (vkCreateCommandPool(device, &createInfo, nullptr, &uploadCommandPool) != VK_SUCCESS)
 		throw std::runtime_error("failed to create command pool!");
 }
 
+void my_vulkan::VulkanContext::createParticleSystem(uint32_t particleCount)
+{
+	if (particleSystem)
+	{
+		vkDeviceWaitIdle(device->getLogicalDevice());
+		particleSystem->destroyParticleSystem(device->getLogicalDevice());
+		particleSystem.reset();
+	}
+	if (particleCount != 0)
+		particleSystem = std::make_shared<ParticleSystem>(device, graphicsPipeline.get(), swapChain->getSwapChainExtent(), particleCount);
+}
+
 my_vulkan::VulkanContext::~VulkanContext()
 {
-	ImGui_ImplGlfw_Shutdown();
-	ImGui_ImplVulkan_Shutdown();
-	ImGui::DestroyContext();
-	vkDestroyCommandPool(device->getLogicalDevice(), commandPool, nullptr);
-	vkDestroySurfaceKHR(instance->getInstance(), surface, nullptr);
-	vkDestroyCommandPool(device->getLogicalDevice(), commandPool, nullptr);
+	//headless runs never create the imgui overlay
+#ifndef MY_VULKAN_HEADLESS_ONLY
+	if (ImGui::GetCurrentContext())
+	{
+		ImGui_ImplGlfw_Shutdown();
+		ImGui_ImplVulkan_Shutdown();
+		ImGui::DestroyContext();
+	}
+#endif
+	uploader->destroyUploader(device->getLogicalDevice());
+	meshRegistry->destroyRegistry(device->getLogicalDevice());
+	uniformArena->destroyArena(device->getLogicalDevice());
+	for (auto& frameDescriptorAllocator : frameDescriptorAllocators)
+		frameDescriptorAllocator->destroyAllocator();
+	if (bindlessTextures)
+		bindlessTextures->destroyBindlessTextures(device->getLogicalDevice());
+	if (indirectDraws)
+		indirectDraws->destroyIndirectDraws(device->getLogicalDevice());
+	if (particleSystem)
+		particleSystem->destroyParticleSystem(device->getLogicalDevice());
+	profiler->destroyProfiler(device->getLogicalDevice());
+	pipelineManager->destroyPipelineManager(device->getLogicalDevice());
+	vkDestroyCommandPool(device->getLogicalDevice(), uploadCommandPool, nullptr);
+	if (surface != VK_NULL_HANDLE)
+		vkDestroySurfaceKHR(instance->getInstance(), surface, nullptr);
 	graphicsPipeline->destroyGraphicsPipeline(device->getLogicalDevice());
 	swapChain->DestroySwapChain(device->getLogicalDevice());
 	device->destroyDevice();
@@ -1,5 +1,7 @@
 ﻿#pragma once
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <vector>
@@ -26,6 +28,17 @@ namespace my_vulkan
 	class Arona;
 	class Camera;
 	class ImguiAPI;
+	class ThreadPool;
+	class AssetLoader;
+	class VulkanUploader;
+	class VulkanUniformArena;
+	class VulkanDescriptorAllocator;
+	class VulkanBindlessTextures;
+	class MeshRegistry;
+	class VulkanIndirectDraws;
+	class ParticleSystem;
+	class Profiler;
+	class VulkanPipelineManager;
 	class VulkanContext
 	{
 		friend class ImguiAPI;
@@ -39,36 +52,55 @@ namespace my_vulkan
 		const bool enableValidationLayer = true;
 #endif
 
-		VulkanContext();
+		//Headless contexts create no window, surface or swap chain and render into offscreen targets instead. Builds with
+		//MY_VULKAN_HEADLESS_ONLY (the CMake target) have no GLFW or imgui and can only create headless contexts
+		VulkanContext(bool headless = false);
 		~VulkanContext();
 		void run();
 		void createWindowSurface();
-		void createCommandPool(const VkDevice& device, const VkPhysicalDevice& physicalDevice);
+		void createUploadCommandPool(const VkDevice& device, const VkPhysicalDevice& physicalDevice);
+		//Replaces the current particle system, 0 particles removes it
+		void createParticleSystem(uint32_t particleCount);
 
 		static void updateImgui(VkCommandBuffer commandBuffer);
 
-		VkCommandPool& getCommandPool() { return commandPool; }
+		VkCommandPool& getUploadCommandPool() { return uploadCommandPool; }
 
 
 		const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_monitor" };
 		const std::vector<const char*> deviceExtensions = { "VK_KHR_swapchain", "VK_KHR_shader_non_semantic_info" };
+		const std::vector<const char*> headlessDeviceExtensions = { "VK_KHR_shader_non_semantic_info" };
 
-		VulkanWindow wind{ 1920, 1080, "Vulkan" };
+		const bool headless;
+		//window stays null when headless
+		VulkanWindow wind;
 
 
 		std::shared_ptr<VulkanInstance> instance;
-		VkSurfaceKHR surface;
-		VkCommandPool commandPool;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
+		//one-shot and upload work only, every frame in flight records from the renderer's own frame contexts
+		VkCommandPool uploadCommandPool;
 		std::shared_ptr<VulkanDevice> device;
 		std::shared_ptr<VulkanSwapChain> swapChain;
 		std::shared_ptr<VulkanGraphicsPipeline> graphicsPipeline;
-		std::shared_ptr<VulkanComputePipeline> computePipeline;
-
+		std::shared_ptr<ThreadPool> threadPool;
+		std::shared_ptr<AssetLoader> assetLoader;
+		std::shared_ptr<VulkanUploader> uploader;
+		std::shared_ptr<MeshRegistry> meshRegistry;
+		std::shared_ptr<VulkanUniformArena> uniformArena;
+		//null when the device has no descriptor indexing, objects then bind a sampler set per mesh
+		std::shared_ptr<VulkanBindlessTextures> bindlessTextures;
+		//null unless the device supports indirect count draws, the renderer then culls and draws plain meshes on the gpu
+		std::shared_ptr<VulkanIndirectDraws> indirectDraws;
+		//descriptor sets that only live for one frame, reset once the frame's previous submission has completed
+		std::vector<std::shared_ptr<VulkanDescriptorAllocator>> frameDescriptorAllocators;
+		//null until createParticleSystem, simulated on the async compute queue and drawn after the objects
+		std::shared_ptr<ParticleSystem> particleSystem;
+		//cpu scopes and gpu timestamps of every frame, gpu timing is off when the device cannot reset queries from the host
+		std::shared_ptr<Profiler> profiler;
+		//material variants of graphicsPipeline, built on the thread pool
+		std::shared_ptr<VulkanPipelineManager> pipelineManager;
 
-		std::vector<VkBuffer> shaderStorageBuffers;
-		std::vector<VkDeviceMemory> shaderStorageBuffersMemory;
-		std::shared_ptr<VulkanUniformBuffers> ComputeUniformBuffers;
-		std::shared_ptr<VulkanDescriptors> shaderStorageBuffersDescriptors;
 		static std::chrono::high_resolution_clock clock;
 		const std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
 
@@ -33,9 +33,9 @@ VkImage& my_vulkan::VulkanDepthResources::getImage()
 	return image->getImage();
 }
 
-VkDeviceMemory& my_vulkan::VulkanDepthResources::getImageMemory()
+my_vulkan::VulkanAllocation& my_vulkan::VulkanDepthResources::getAllocation()
 {
-	return image->getImageMemory();
+	return image->getAllocation();
 }
 
 VkFormat& my_vulkan::VulkanDepthResources::getImageFormat()
@@ -52,3 +52,8 @@ VkImageView& my_vulkan::VulkanDepthResources::getImageView()
 {
 	return image->getImageView();
 }
+
+void my_vulkan::VulkanDepthResources::destroyDepthResources(const VkDevice& device)
+{
+	image->destroyImage(device);
+}
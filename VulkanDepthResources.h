@@ -8,6 +8,7 @@ namespace my_vulkan
 	class VulkanDevice;
 	class VulkanImage;
 	class VulkanUtils;
+	struct VulkanAllocation;
 
 	class VulkanDepthResources
 	{
@@ -20,11 +21,13 @@ namespace my_vulkan
 		bool hasStencilComponent(VkFormat format) const { return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT; }
 
 		VkImage& getImage();
-		VkDeviceMemory& getImageMemory();
+		VulkanAllocation& getAllocation();
 		VkFormat& getImageFormat();
 		VkImageLayout& getImageCurrentLayout();
 		VkImageView& getImageView();
 
+		void destroyDepthResources(const VkDevice& device);
+
 	private:
 		std::shared_ptr<VulkanImage> image;
 	};
@@ -0,0 +1,105 @@
+#include "VulkanDescriptorAllocator.h"
+
+#include <iterator>
+#include <stdexcept>
+
+my_vulkan::VulkanDescriptorAllocator::VulkanDescriptorAllocator(VkDevice device, bool freeDescriptorSets)
+	: device(device), freeDescriptorSets(freeDescriptorSets)
+{
+
+}
+
+VkDescriptorPool my_vulkan::VulkanDescriptorAllocator::grabPool()
+{
+	if (!freePools.empty())
+	{
+		VkDescriptorPool pool = freePools.back();
+		freePools.pop_back();
+		return pool;
+	}
+
+	//descriptors per set, sized for the layouts VulkanUtils hands out
+	VkDescriptorPoolSize poolSizes[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SETS_PER_POOL },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, SETS_PER_POOL },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SETS_PER_POOL * 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SETS_PER_POOL * 2 }
+	};
+
+	VkDescriptorPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	createInfo.flags = freeDescriptorSets ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+	createInfo.maxSets = SETS_PER_POOL;
+	createInfo.poolSizeCount = static_cast<uint32_t>(std::size(poolSizes));
+	createInfo.pPoolSizes = poolSizes;
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &createInfo, nullptr, &pool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create descriptor pool!");
+	return pool;
+}
+
+VkDescriptorPool my_vulkan::VulkanDescriptorAllocator::allocate(const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets)
+{
+	if (currentPool == VK_NULL_HANDLE)
+	{
+		currentPool = grabPool();
+		usedPools.push_back(currentPool);
+	}
+
+	sets.resize(layouts.size());
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = currentPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+	allocInfo.pSetLayouts = layouts.data();
+
+	VkResult result = vkAllocateDescriptorSets(device, &allocInfo, sets.data());
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		//the current pool is full, move on to a fresh one and try once more
+		currentPool = grabPool();
+		usedPools.push_back(currentPool);
+		allocInfo.descriptorPool = currentPool;
+		result = vkAllocateDescriptorSets(device, &allocInfo, sets.data());
+	}
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	return currentPool;
+}
+
+VkDescriptorSet my_vulkan::VulkanDescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+	std::vector<VkDescriptorSet> sets;
+	allocate({ layout }, sets);
+	return sets[0];
+}
+
+void my_vulkan::VulkanDescriptorAllocator::free(VkDescriptorPool pool, const std::vector<VkDescriptorSet>& sets)
+{
+	if (!freeDescriptorSets)
+		throw std::runtime_error("descriptor allocator does not free individual sets!");
+	vkFreeDescriptorSets(device, pool, static_cast<uint32_t>(sets.size()), sets.data());
+}
+
+void my_vulkan::VulkanDescriptorAllocator::resetPools()
+{
+	for (auto pool : usedPools)
+	{
+		vkResetDescriptorPool(device, pool, 0);
+		freePools.push_back(pool);
+	}
+	usedPools.clear();
+	currentPool = VK_NULL_HANDLE;
+}
+
+void my_vulkan::VulkanDescriptorAllocator::destroyAllocator()
+{
+	for (auto pool : usedPools)
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	for (auto pool : freePools)
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	usedPools.clear();
+	freePools.clear();
+	currentPool = VK_NULL_HANDLE;
+}
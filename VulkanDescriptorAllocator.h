@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	//Allocates descriptor sets out of a growing list of shared pools, a new pool is only created once the current
+	//one runs out. Per-frame allocators hand out sets that live for one frame and get reset wholesale, the
+	//persistent one is created with freeDescriptorSets so long lived sets can be returned individually
+	class VulkanDescriptorAllocator
+	{
+	public:
+		static constexpr uint32_t SETS_PER_POOL = 256;
+
+		VulkanDescriptorAllocator(VkDevice device, bool freeDescriptorSets);
+
+		//Returns the pool the sets came from, pass it back to free them
+		VkDescriptorPool allocate(const std::vector<VkDescriptorSetLayout>& layouts, std::vector<VkDescriptorSet>& sets);
+		VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+		void free(VkDescriptorPool pool, const std::vector<VkDescriptorSet>& sets);
+
+		//Recycles every pool, all sets handed out so far become invalid
+		void resetPools();
+
+		uint32_t getPoolCount() const { return static_cast<uint32_t>(usedPools.size() + freePools.size()); }
+
+		void destroyAllocator();
+
+	private:
+		VkDescriptorPool grabPool();
+
+		VkDevice device;
+		bool freeDescriptorSets;
+		VkDescriptorPool currentPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool> usedPools;
+		std::vector<VkDescriptorPool> freePools;
+	};
+}
@@ -0,0 +1,91 @@
+#include "VulkanDescriptorLayoutCache.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+my_vulkan::VulkanDescriptorLayoutCache::VulkanDescriptorLayoutCache(VkDevice device) : device(device)
+{
+
+}
+
+bool my_vulkan::VulkanDescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& rhs) const
+{
+	if (bindings.size() != rhs.bindings.size() || bindingFlags != rhs.bindingFlags || flags != rhs.flags)
+		return false;
+	for (size_t i = 0; i != bindings.size(); ++i)
+	{
+		const auto& a = bindings[i];
+		const auto& b = rhs.bindings[i];
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+			a.stageFlags != b.stageFlags || a.pImmutableSamplers != b.pImmutableSamplers)
+			return false;
+	}
+	return true;
+}
+
+size_t my_vulkan::VulkanDescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+{
+	size_t hash = std::hash<size_t>()(key.bindings.size()) ^ std::hash<uint32_t>()(key.flags);
+	for (auto bindingFlags : key.bindingFlags)
+		hash ^= std::hash<uint32_t>()(bindingFlags) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	for (const auto& binding : key.bindings)
+	{
+		uint64_t value = static_cast<uint64_t>(binding.binding) | static_cast<uint64_t>(binding.descriptorType) << 8 |
+			static_cast<uint64_t>(binding.descriptorCount) << 16 | static_cast<uint64_t>(binding.stageFlags) << 40;
+		hash ^= std::hash<uint64_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+VkDescriptorSetLayout my_vulkan::VulkanDescriptorLayoutCache::getLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+	const std::vector<VkDescriptorBindingFlags>& bindingFlags, VkDescriptorSetLayoutCreateFlags flags)
+{
+	//binding order does not change the layout, sort so {0, 1} and {1, 0} share an entry
+	std::vector<size_t> order(bindings.size());
+	for (size_t i = 0; i != order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+	LayoutKey key{ {}, {}, flags };
+	for (auto i : order)
+	{
+		key.bindings.push_back(bindings[i]);
+		if (!bindingFlags.empty())
+			key.bindingFlags.push_back(bindingFlags[i]);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = layouts.find(key);
+	if (it != layouts.end())
+		return it->second;
+
+	VkDescriptorSetLayoutCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	createInfo.bindingCount = static_cast<uint32_t>(key.bindings.size());
+	createInfo.pBindings = key.bindings.data();
+	createInfo.flags = flags;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	if (!key.bindingFlags.empty())
+	{
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(key.bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = key.bindingFlags.data();
+		createInfo.pNext = &bindingFlagsInfo;
+	}
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &layout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create descriptor set layout!");
+
+	layouts.emplace(std::move(key), layout);
+	return layout;
+}
+
+void my_vulkan::VulkanDescriptorLayoutCache::destroyLayoutCache()
+{
+	for (auto& layout : layouts)
+		vkDestroyDescriptorSetLayout(device, layout.second, nullptr);
+	layouts.clear();
+}
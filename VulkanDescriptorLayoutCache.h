@@ -0,0 +1,43 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	//Creates each distinct descriptor set layout once and hands the same handle to every caller asking for
+	//identical bindings. The cache owns the layouts, callers never destroy them
+	class VulkanDescriptorLayoutCache
+	{
+	public:
+		VulkanDescriptorLayoutCache(VkDevice device);
+
+		//bindingFlags is either empty or holds one entry per binding, in the same order
+		VkDescriptorSetLayout getLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+			const std::vector<VkDescriptorBindingFlags>& bindingFlags = {}, VkDescriptorSetLayoutCreateFlags flags = 0);
+
+		size_t getLayoutCount() const { return layouts.size(); }
+
+		void destroyLayoutCache();
+
+	private:
+		struct LayoutKey
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<VkDescriptorBindingFlags> bindingFlags;
+			VkDescriptorSetLayoutCreateFlags flags;
+
+			bool operator==(const LayoutKey& rhs) const;
+		};
+
+		struct LayoutKeyHash
+		{
+			size_t operator()(const LayoutKey& key) const;
+		};
+
+		VkDevice device;
+		std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+		std::mutex mutex;
+	};
+}
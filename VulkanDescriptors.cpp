@@ -6,73 +6,30 @@
 #include "Texture.h"
 #include "VulkanUniformBuffers.h"
 #include "VulkanDevice.h"
+#include "VulkanDescriptorAllocator.h"
 #include "VulkanUtils.h"
-#include "Vertex.h""
+#include "Vertex.h"
 #include "VulkanBuffer.h"
 
 
 
 my_vulkan::VulkanDescriptors::VulkanDescriptors(const std::shared_ptr<VulkanDevice>& device,
 	VulkanUniformBuffers* uniformBuffers, VkImageView imageView, VkSampler sampler,
-	VulkanDescriptorFor layout_type)
+	VulkanDescriptorFor layout_type) : allocator(device->getDescriptorAllocator().get())
 {
-	descriptorSetLayout = VulkanUtils::createDescriptorSetLayout(device->getLogicalDevice(), layout_type);
-	createDescriptorPool(device->getLogicalDevice(), layout_type);
+	descriptorSetLayout = VulkanUtils::getDescriptorSetLayout(device, layout_type);
 	createDescriptorSets(device->getLogicalDevice(), uniformBuffers, imageView, sampler, layout_type);
 }
 
-void my_vulkan::VulkanDescriptors::createDescriptorPool(const VkDevice& device, VulkanDescriptorFor layout_type)
-{
-
-	VkDescriptorPoolSize poolSize{};
-	switch (layout_type)
-	{
-		case VulkanDescriptorFor::FRAGMENT_SHADER_UNIFORM_BUFFER:
-		case VulkanDescriptorFor::VERTEX_SHADER_UNIFORM_BUFFER:
-		{
-			poolSize.descriptorCount = MAX_RENDER_IMAGES;
-			poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			break;
-		}
-		case VulkanDescriptorFor::COMBINED_IMAGE_SAMPLER:
-		{
-			poolSize.descriptorCount = MAX_RENDER_IMAGES;
-			poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			break;
-		}
-		case VulkanDescriptorFor::COMPUTE_SHADER_UNIFORM_BUFFER:
-		{
-			poolSize.descriptorCount = MAX_RENDER_IMAGES * 2;
-			poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-			break;
-		}
-	}
-
-	VkDescriptorPoolCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	createInfo.maxSets = MAX_RENDER_IMAGES;
-	createInfo.poolSizeCount = 1;
-	createInfo.pPoolSizes = &poolSize;
-
-	if (vkCreateDescriptorPool(device, &createInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-		throw std::runtime_error("failed to create descriptor pool!");
-}
-
 void my_vulkan::VulkanDescriptors::createDescriptorSets(const VkDevice& device,
 	VulkanUniformBuffers* uniformBuffers, const VkImageView& imageView, const VkSampler& sampler,
 	VulkanDescriptorFor layout_type)
 {
-	std::vector descriptorSetLayouts(MAX_RENDER_IMAGES, descriptorSetLayout);
-	descriptorSets.resize(MAX_RENDER_IMAGES);
+	if (layout_type == VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER || layout_type == VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER)
+		throw std::runtime_error("dynamic uniform buffers are allocated by VulkanUniformArena!");
 
-	VkDescriptorSetAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = descriptorPool;
-	allocInfo.descriptorSetCount = MAX_RENDER_IMAGES;
-	allocInfo.pSetLayouts = descriptorSetLayouts.data();
-
-	if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
-		throw std::runtime_error("failed to allocate descriptor sets!");
+	std::vector descriptorSetLayouts(MAX_RENDER_IMAGES, descriptorSetLayout);
+	descriptorPool = allocator->allocate(descriptorSetLayouts, descriptorSets);
 
 	switch (layout_type)
 	{
@@ -84,7 +41,7 @@ void my_vulkan::VulkanDescriptors::createDescriptorSets(const VkDevice& device,
 				VkDescriptorBufferInfo bufferInfo{};
 				bufferInfo.buffer = uniformBuffers->getUniformBuffers()[i];
 				bufferInfo.offset = 0;
-				bufferInfo.range = sizeof VertexUniformBufferObject;
+				bufferInfo.range = sizeof(VertexUniformBufferObject);
 
 				writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 				writeInfo.descriptorCount = 1;
@@ -105,7 +62,7 @@ void my_vulkan::VulkanDescriptors::createDescriptorSets(const VkDevice& device,
 				VkDescriptorBufferInfo bufferInfo{};
 				bufferInfo.buffer = uniformBuffers->getUniformBuffers()[i];
 				bufferInfo.offset = 0;
-				bufferInfo.range = sizeof FragmentUniformBufferObject;
+				bufferInfo.range = sizeof(FragmentUniformBufferObject);
 
 				writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 				writeInfo.descriptorCount = 1;
@@ -160,12 +117,14 @@ void my_vulkan::VulkanDescriptors::createDescriptorSets(const VkDevice& device,
 			}
 			break;
 		}
+		default:
+			break;
 	}
 }
 
 void my_vulkan::VulkanDescriptors::DestroyVulkanDescriptor(const VkDevice& device)
 {
-	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	//the layout belongs to the device's layout cache
+	allocator->free(descriptorPool, descriptorSets);
+	descriptorSets.clear();
 }
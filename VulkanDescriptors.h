@@ -11,6 +11,7 @@ namespace my_vulkan
 	class VulkanUniformBuffers;
 	class Texture;
 	class VulkanDevice;
+	class VulkanDescriptorAllocator;
 
 	class VulkanDescriptors
 	{
@@ -21,8 +22,6 @@ namespace my_vulkan
 
 		void DestroyVulkanDescriptor(const VkDevice& device);
 
-		void createDescriptorPool(const VkDevice& device, VulkanDescriptorFor layout_type);
-
 		void createDescriptorSets(const VkDevice& device,
 			VulkanUniformBuffers* uniformBuffers, const VkImageView& imageView, const VkSampler& sampler,
 			VulkanDescriptorFor layout_type);
@@ -32,6 +31,7 @@ namespace my_vulkan
 		std::vector<VkDescriptorSet>& getDescriptorSets() { return descriptorSets; }
 
 	private:
+		VulkanDescriptorAllocator* allocator;
 		VkDescriptorSetLayout descriptorSetLayout;
 
 		VkDescriptorPool descriptorPool;
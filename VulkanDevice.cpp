@@ -6,12 +6,20 @@
 #include <vector>
 
 #include "VulkanUtils.h"
+#include "VulkanAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanPipelineCache.h"
 
 my_vulkan::VulkanDevice::VulkanDevice(bool enableValidationLayer, const VkInstance& instance, VkSurfaceKHR surface, 
                                       const std::vector<const char*>& deviceExtensions, const std::vector<const char*>& validationLayers)
 {
 	pickPhysicalDevice(instance, surface, deviceExtensions);
-	createLogicalDevice(enableValidationLayer, validationLayers, deviceExtensions);
+	createLogicalDevice(enableValidationLayer, validationLayers, deviceExtensions, surface);
+	allocator = std::make_shared<VulkanAllocator>(physicalDevice, device);
+	descriptorLayoutCache = std::make_shared<VulkanDescriptorLayoutCache>(device);
+	descriptorAllocator = std::make_shared<VulkanDescriptorAllocator>(device, true);
+	pipelineCache = std::make_shared<VulkanPipelineCache>(physicalDevice, device);
 }
 
 VkSampleCountFlagBits my_vulkan::VulkanDevice::getMaxUsableSampleCount()
@@ -52,14 +60,19 @@ void my_vulkan::VulkanDevice::pickPhysicalDevice(const VkInstance& instance, VkS
 
 bool my_vulkan::VulkanDevice::physicalDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface, const std::vector<const char*>& deviceExtensions)
 {
-	auto indices = queryQueueFamilyIndices(device);
-	auto details = querySwapChainCreateDetails(device, surface);
-	bool detailAdequate = !details.presentModes.empty() && !details.formats.empty();
+	bool headless = surface == VK_NULL_HANDLE;
+	auto indices = queryQueueFamilyIndices(device, surface);
+	bool detailAdequate = headless;
+	if (!headless)
+	{
+		auto details = querySwapChainCreateDetails(device, surface);
+		detailAdequate = !details.presentModes.empty() && !details.formats.empty();
+	}
 
 	VkPhysicalDeviceFeatures supprotedFreatures{};
 	vkGetPhysicalDeviceFeatures(device, &supprotedFreatures);
 
-	return physicalDeviceExtensionsCheck(device, deviceExtensions) && indices.isComplete() && detailAdequate && supprotedFreatures.samplerAnisotropy;
+	return physicalDeviceExtensionsCheck(device, deviceExtensions) && indices.isComplete(!headless) && detailAdequate && supprotedFreatures.samplerAnisotropy;
 }
 
 bool my_vulkan::VulkanDevice::physicalDeviceExtensionsCheck(VkPhysicalDevice device, const std::vector<const char*>& deviceExtensions)
@@ -81,22 +94,30 @@ bool my_vulkan::VulkanDevice::physicalDeviceExtensionsCheck(VkPhysicalDevice dev
 	return extentionTemp.empty();
 }
 
-my_vulkan::QueueFamilyIndices my_vulkan::VulkanDevice::queryQueueFamilyIndices(VkPhysicalDevice device)
+my_vulkan::QueueFamilyIndices my_vulkan::VulkanDevice::queryQueueFamilyIndices(VkPhysicalDevice device, VkSurfaceKHR surface)
 {
 	QueueFamilyIndices indices{};
 	uint32_t QueueFamilyPropertyCount;
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &QueueFamilyPropertyCount, nullptr);
 	std::vector<VkQueueFamilyProperties> QueueFamiliesProperties(QueueFamilyPropertyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &QueueFamilyPropertyCount, QueueFamiliesProperties.data());
-	int i = 0;
+	uint32_t i = 0;
 	for (auto prop : QueueFamiliesProperties)
 	{
-		if ((prop.queueFlags & VkQueueFlagBits::VK_QUEUE_GRAPHICS_BIT) && (prop.queueFlags & VK_QUEUE_COMPUTE_BIT))
+		bool graphicsAndCompute = (prop.queueFlags & VkQueueFlagBits::VK_QUEUE_GRAPHICS_BIT) && (prop.queueFlags & VK_QUEUE_COMPUTE_BIT);
+		if (graphicsAndCompute && !indices.graphicsAndComputeQueue.has_value())
 			indices.graphicsAndComputeQueue = i;
-		if (vkGetPhysicalDeviceWin32PresentationSupportKHR(device, i) == VK_TRUE)
+		VkBool32 presentSupport = VK_FALSE;
+		if (surface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		if (presentSupport == VK_TRUE && !indices.presentQueue.has_value())
 			indices.presentQueue = i;
-		if (indices.isComplete())
-			break;
+		if ((prop.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(prop.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+			!indices.transferQueue.has_value())
+			indices.transferQueue = i;
+		if ((prop.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(prop.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeQueue.has_value())
+			indices.computeQueue = i;
+		++i;
 	}
 	return indices;
 }
@@ -124,13 +145,20 @@ my_vulkan::SwapChainCreateDetails my_vulkan::VulkanDevice::querySwapChainCreateD
 	return details;
 }
 
-void my_vulkan::VulkanDevice::createLogicalDevice(bool enableValidationLayer, const std::vector<const char*>& validationLayers, const std::vector<const char*>& deviceExtensions)
+void my_vulkan::VulkanDevice::createLogicalDevice(bool enableValidationLayer, const std::vector<const char*>& validationLayers, const std::vector<const char*>& deviceExtensions,
+	VkSurfaceKHR surface)
 {
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
-	auto indices = queryQueueFamilyIndices(physicalDevice);
+	auto indices = queryQueueFamilyIndices(physicalDevice, surface);
+	if (!indices.presentQueue.has_value())
+		indices.presentQueue = indices.graphicsAndComputeQueue;
 	std::set<uint32_t> queueIndices = { indices.graphicsAndComputeQueue.value(), indices.presentQueue.value() };
+	if (indices.transferQueue.has_value())
+		queueIndices.insert(indices.transferQueue.value());
+	if (indices.computeQueue.has_value())
+		queueIndices.insert(indices.computeQueue.value());
 	std::vector<VkDeviceQueueCreateInfo> QueueCreateInfos;
 	float priority = 1.0f;
 	for (const auto index : queueIndices)
@@ -156,19 +184,72 @@ void my_vulkan::VulkanDevice::createLogicalDevice(bool enableValidationLayer, co
 	createInfo.enabledExtensionCount = deviceExtensions.size();
 	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
+	VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+	supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceFeatures2 supportedFeatures{};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &supportedFeatures12;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	//frame pacing and uploads are tracked with timeline semaphores, core and mandatory since 1.2
+	if (!supportedFeatures12.timelineSemaphore)
+		throw std::runtime_error("device does not support timeline semaphores!");
+	features12.timelineSemaphore = VK_TRUE;
+	bindlessTextures = supportedFeatures12.descriptorIndexing && supportedFeatures12.runtimeDescriptorArray &&
+		supportedFeatures12.descriptorBindingPartiallyBound && supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind;
+	if (bindlessTextures)
+	{
+		features12.descriptorIndexing = VK_TRUE;
+		features12.runtimeDescriptorArray = VK_TRUE;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	}
+	//the profiler resets its timestamp queries from the host, outside any command buffer
+	hostQueryReset = supportedFeatures12.hostQueryReset;
+	features12.hostQueryReset = hostQueryReset;
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.sampleRateShading = VK_TRUE;
+	largePoints = supportedFeatures.features.largePoints;
+	deviceFeatures.largePoints = largePoints;
+	textureCompressionBC = supportedFeatures.features.textureCompressionBC;
+	deviceFeatures.textureCompressionBC = textureCompressionBC;
+	//gpu driven draws pick their per-draw data through firstInstance, the texture through the bindless table
+	indirectDrawCount = bindlessTextures && supportedFeatures12.drawIndirectCount && supportedFeatures.features.multiDrawIndirect &&
+		supportedFeatures.features.drawIndirectFirstInstance;
+	if (indirectDrawCount)
+	{
+		features12.drawIndirectCount = VK_TRUE;
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+	}
 	createInfo.pEnabledFeatures = &deviceFeatures;
+	createInfo.pNext = &features12;
 
 	if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
 		throw std::runtime_error("failed to create logical device!");
 	vkGetDeviceQueue(device, indices.graphicsAndComputeQueue.value(), 0, &graphicsQueue);
 	vkGetDeviceQueue(device, indices.presentQueue.value(), 0, &presentQueue);
+
+	graphicsQueueFamily = indices.graphicsAndComputeQueue.value();
+	dedicatedTransferQueue = indices.transferQueue.has_value();
+	transferQueueFamily = dedicatedTransferQueue ? indices.transferQueue.value() : graphicsQueueFamily;
+	vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+
+	dedicatedComputeQueue = indices.computeQueue.has_value();
+	computeQueueFamily = dedicatedComputeQueue ? indices.computeQueue.value() : graphicsQueueFamily;
+	vkGetDeviceQueue(device, computeQueueFamily, 0, &computeQueue);
 }
 
 void my_vulkan::VulkanDevice::destroyDevice()
 {
+	descriptorAllocator->destroyAllocator();
+	descriptorLayoutCache->destroyLayoutCache();
+	pipelineCache->destroyPipelineCache();
+	allocator->destroyAllocator();
 	vkDestroyDevice(device, nullptr);
 }
 
@@ -1,18 +1,26 @@
 #pragma once
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
+#include <memory>
 #include <vector>
 #include <vulkan/vulkan.h>
 
 namespace my_vulkan
 {
+	class VulkanAllocator;
+	class VulkanDescriptorLayoutCache;
+	class VulkanDescriptorAllocator;
+	class VulkanPipelineCache;
 	struct QueueFamilyIndices;
 	struct SwapChainCreateDetails;
 
 	class VulkanDevice
 	{
 	public:
+		//A null surface creates a headless device, the present queue is then the graphics queue and never presented to
 		VulkanDevice(bool enableValidationLayer, const VkInstance& instance, VkSurfaceKHR surface,
 			const std::vector<const char*>& deviceExtensions, const std::vector<const char*>& validationLayers);
 
@@ -21,16 +29,43 @@ namespace my_vulkan
 		bool physicalDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface, const std::vector<const char*>& deviceExtensions);
 		bool physicalDeviceExtensionsCheck(VkPhysicalDevice device, const std::vector<const char*>& deviceExtensions);
 
-		static QueueFamilyIndices queryQueueFamilyIndices(VkPhysicalDevice device);
+		//presentQueue is only looked up when a surface is given
+		static QueueFamilyIndices queryQueueFamilyIndices(VkPhysicalDevice device, VkSurfaceKHR surface = VK_NULL_HANDLE);
 		static SwapChainCreateDetails querySwapChainCreateDetails(VkPhysicalDevice device, VkSurfaceKHR surface);
 
-		void createLogicalDevice(bool enableValidationLayer, const std::vector<const char*>& validationLayers, const std::vector<const char*>& deviceExtensions);
+		void createLogicalDevice(bool enableValidationLayer, const std::vector<const char*>& validationLayers, const std::vector<const char*>& deviceExtensions,
+			VkSurfaceKHR surface);
 
 		const VkPhysicalDevice& getPhysicalDevice() const { return physicalDevice; }
 		const VkDevice& getLogicalDevice() const { return device; }
 		const VkQueue& getGraphicsQueue() { return graphicsQueue; }
 		const VkQueue& getPresentQueue() { return presentQueue; }
+		//The dedicated transfer queue, or the graphics queue when the device has none
+		const VkQueue& getTransferQueue() { return transferQueue; }
+		bool hasDedicatedTransferQueue() const { return dedicatedTransferQueue; }
+		//The async compute queue, or the graphics queue when the device has no compute-only family
+		const VkQueue& getComputeQueue() { return computeQueue; }
+		bool hasDedicatedComputeQueue() const { return dedicatedComputeQueue; }
+		uint32_t getComputeQueueFamily() const { return computeQueueFamily; }
+		//gl_PointSize above 1
+		bool supportsLargePoints() const { return largePoints; }
+		//vkResetQueryPool
+		bool supportsHostQueryReset() const { return hostQueryReset; }
+		uint32_t getGraphicsQueueFamily() const { return graphicsQueueFamily; }
+		uint32_t getTransferQueueFamily() const { return transferQueueFamily; }
 		const VkSampleCountFlagBits& getMsaaSamples() { return msaaSamples; }
+		const std::shared_ptr<VulkanAllocator>& getAllocator() const { return allocator; }
+		//runtime sized, partially bound, update-after-bind sampled image arrays
+		bool supportsBindlessTextures() const { return bindlessTextures; }
+		//vkCmdDrawIndexedIndirectCount with multi draw and firstInstance, on top of bindless textures
+		bool supportsIndirectDrawCount() const { return indirectDrawCount; }
+		//BC1-BC7 sampled images, cooked textures are decoded on the cpu without it
+		bool supportsTextureCompressionBC() const { return textureCompressionBC; }
+		const std::shared_ptr<VulkanDescriptorLayoutCache>& getDescriptorLayoutCache() const { return descriptorLayoutCache; }
+		//Every pipeline is created through it, it is saved to disk when the device is destroyed
+		const std::shared_ptr<VulkanPipelineCache>& getPipelineCache() const { return pipelineCache; }
+		//For descriptor sets that live longer than a frame
+		const std::shared_ptr<VulkanDescriptorAllocator>& getDescriptorAllocator() const { return descriptorAllocator; }
 
 		void destroyDevice();
 		~VulkanDevice();
@@ -42,6 +77,22 @@ namespace my_vulkan
 		VkDevice device;
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue transferQueue;
+		VkQueue computeQueue;
+		bool dedicatedTransferQueue = false;
+		bool dedicatedComputeQueue = false;
+		uint32_t graphicsQueueFamily;
+		uint32_t transferQueueFamily;
+		uint32_t computeQueueFamily;
+		bool largePoints = false;
+		bool hostQueryReset = false;
+		bool bindlessTextures = false;
+		bool indirectDrawCount = false;
+		bool textureCompressionBC = false;
+		std::shared_ptr<VulkanAllocator> allocator;
+		std::shared_ptr<VulkanDescriptorLayoutCache> descriptorLayoutCache;
+		std::shared_ptr<VulkanPipelineCache> pipelineCache;
+		std::shared_ptr<VulkanDescriptorAllocator> descriptorAllocator;
 	};
 }
 
@@ -0,0 +1,51 @@
+#include "VulkanFrameContext.h"
+
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+my_vulkan::VulkanFrameContext::VulkanFrameContext(const std::shared_ptr<VulkanDevice>& device)
+	: device(device->getLogicalDevice())
+{
+	createCommandPool(device);
+	createCommandBuffer();
+}
+
+void my_vulkan::VulkanFrameContext::createCommandPool(const std::shared_ptr<VulkanDevice>& device)
+{
+	VkCommandPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.queueFamilyIndex = VulkanDevice::queryQueueFamilyIndices(device->getPhysicalDevice()).graphicsAndComputeQueue.value();
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	if (vkCreateCommandPool(this->device, &createInfo, nullptr, &commandPool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create frame command pool!");
+}
+
+void my_vulkan::VulkanFrameContext::createCommandBuffer()
+{
+	VkCommandBufferAllocateInfo allocateInfo{};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandBufferCount = 1;
+	allocateInfo.commandPool = commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	if (vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to allocate command buffer!");
+}
+
+void my_vulkan::VulkanFrameContext::reset()
+{
+	//puts the primary buffer back into the initial state along with everything else allocated from the pool
+	if (vkResetCommandPool(device, commandPool, 0) != VK_SUCCESS)
+		throw std::runtime_error("failed to reset frame command pool!");
+}
+
+void my_vulkan::VulkanFrameContext::destroyFrameContext(const VkDevice& device)
+{
+	vkDestroyCommandPool(device, commandPool, nullptr);
+}
+
+my_vulkan::VulkanFrameContext::~VulkanFrameContext()
+{
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <memory>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+
+	//The command pool and primary buffer one frame in flight records with. The pool is transient and reset as a whole
+	//once the frame's previous submission has completed, so its buffers are never reset or freed one by one and uploads never touch it
+	class VulkanFrameContext
+	{
+	public:
+		VulkanFrameContext(const std::shared_ptr<VulkanDevice>& device);
+
+		//Only call once the frame's previous submission has completed
+		void reset();
+
+		VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+		const VkCommandBuffer* getCommandBufferPointer() const { return &commandBuffer; }
+
+		//The frame timeline value the frame's last submission signals, 0 before the first one
+		uint64_t getSubmitValue() const { return submitValue; }
+		void setSubmitValue(uint64_t value) { submitValue = value; }
+
+		void destroyFrameContext(const VkDevice& device);
+
+		~VulkanFrameContext();
+
+	private:
+		void createCommandPool(const std::shared_ptr<VulkanDevice>& device);
+		void createCommandBuffer();
+
+		VkDevice device;
+		VkCommandPool commandPool;
+		VkCommandBuffer commandBuffer;
+		uint64_t submitValue = 0;
+	};
+}
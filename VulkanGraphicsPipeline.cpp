@@ -1,5 +1,6 @@
 #include "VulkanGraphicsPipeline.h"
 
+#include <chrono>
 #include <stdexcept>
 
 #include "Vertex.h"
@@ -8,12 +9,62 @@
 #include "VulkanDepthResources.h"
 #include "VulkanSwapChain.h"
 #include "VulkanUtils.h"
+#include "VulkanBindlessTextures.h"
+#include "VulkanDevice.h"
+#include "VulkanPipelineCache.h"
 
 my_vulkan::VulkanGraphicsPipeline::VulkanGraphicsPipeline(const std::shared_ptr<VulkanDevice>& device, 
-	const std::shared_ptr<VulkanSwapChain>& swapChain, VkCommandPool& commandPool)
+	const std::shared_ptr<VulkanSwapChain>& swapChain, VkCommandPool& commandPool, VulkanBindlessTextures* bindlessTextures,
+	VkDescriptorSetLayout indirectDrawSetLayout)
+	: pipelineCache(device->getPipelineCache().get()), bindless(bindlessTextures != nullptr)
 {
+	auto start = std::chrono::high_resolution_clock::now();
 	createRenderPass(device, swapChain, commandPool);
-	createGraphicsPipeline(device->getLogicalDevice(), swapChain->getSwapChainExtent(), device->getMsaaSamples());
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	setLayouts.push_back(VulkanUtils::getDescriptorSetLayout(device, VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER));
+	setLayouts.push_back(bindless ? bindlessTextures->getDescriptorSetLayout() :
+		VulkanUtils::getDescriptorSetLayout(device, VulkanDescriptorFor::COMBINED_IMAGE_SAMPLER));
+	setLayouts.push_back(VulkanUtils::getDescriptorSetLayout(device, VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER));
+
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	if (bindless)
+	{
+		VkPushConstantRange range{};
+		range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		range.offset = 0;
+		range.size = sizeof(MeshPushConstants);
+		pushConstantRanges.push_back(range);
+	}
+
+	graphicsPipelineLayout = createPipelineLayout(device->getLogicalDevice(), setLayouts, pushConstantRanges);
+
+	meshPipelineDesc.vertShaderPath = bindless ? "shaders/vert_bindless.spv" : "shaders/vert.spv";
+	meshPipelineDesc.fragShaderPath = bindless ? "shaders/frag_bindless.spv" : "shaders/frag.spv";
+	meshPipelineDesc.samples = device->getMsaaSamples();
+	meshPipelineDesc.layout = graphicsPipelineLayout;
+	graphicsPipeline = createGraphicsPipeline(device->getLogicalDevice(), meshPipelineDesc);
+
+	instancedPipelineDesc = meshPipelineDesc;
+	instancedPipelineDesc.vertShaderPath = bindless ? "shaders/vert_bindless_instanced.spv" : "shaders/vert_instanced.spv";
+	instancedPipelineDesc.vertexInput = VertexInput::MESH_INSTANCED;
+	instancedPipeline = createGraphicsPipeline(device->getLogicalDevice(), instancedPipelineDesc);
+
+	if (bindless)
+	{
+		compressedPipelineDesc = meshPipelineDesc;
+		compressedPipelineDesc.vertShaderPath = "shaders/vert_bindless_compressed.spv";
+		compressedPipelineDesc.vertexInput = VertexInput::MESH_COMPRESSED;
+		compressedPipeline = createGraphicsPipeline(device->getLogicalDevice(), compressedPipelineDesc);
+	}
+
+	if (bindless && indirectDrawSetLayout != VK_NULL_HANDLE)
+	{
+		setLayouts.push_back(indirectDrawSetLayout);
+		indirectPipelineLayout = createPipelineLayout(device->getLogicalDevice(), setLayouts, pushConstantRanges);
+		indirectPipeline = createGraphicsPipeline(device->getLogicalDevice(), swapChain->getSwapChainExtent(), device->getMsaaSamples(),
+			"shaders/vert_indirect.spv", "shaders/frag_indirect.spv", VertexInput::MESH, indirectPipelineLayout);
+	}
+	createTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 }
 
 void my_vulkan::VulkanGraphicsPipeline::createRenderPass(const std::shared_ptr<VulkanDevice>& device, 
@@ -50,7 +101,8 @@ void my_vulkan::VulkanGraphicsPipeline::createRenderPass(const std::shared_ptr<V
 	colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	//headless targets are never presented, only copied out
+	colorAttachmentResolve.finalLayout = swapChain->isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	std::array<VkAttachmentDescription, 3> attachments{ colorAttachmentDescription, depthAttachmentDescription, colorAttachmentResolve };
 
@@ -92,25 +144,104 @@ void my_vulkan::VulkanGraphicsPipeline::createRenderPass(const std::shared_ptr<V
 		throw std::runtime_error("failed to create render pass!");
 }
 
-void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& device, const VkExtent2D& swapChainExtent, VkSampleCountFlagBits msaaCount)
+VkPipelineLayout my_vulkan::VulkanGraphicsPipeline::createPipelineLayout(const VkDevice& device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+	const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+	VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo{};
+	PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	PipelineLayoutCreateInfo.setLayoutCount = setLayouts.size();
+	PipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+	PipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	PipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	VkPipelineLayout layout;
+	if (vkCreatePipelineLayout(device, &PipelineLayoutCreateInfo, nullptr, &layout) != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline layout");
+	return layout;
+}
+
+bool my_vulkan::PipelineDesc::operator==(const PipelineDesc& rhs) const
+{
+	return vertShaderPath == rhs.vertShaderPath && fragShaderPath == rhs.fragShaderPath && vertexInput == rhs.vertexInput &&
+		blendMode == rhs.blendMode && cullMode == rhs.cullMode && depthWrite == rhs.depthWrite && samples == rhs.samples &&
+		specializationConstants == rhs.specializationConstants && layout == rhs.layout;
+}
+
+uint64_t my_vulkan::PipelineDesc::getKey() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const void* data, size_t size)
+	{
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= static_cast<const uint8_t*>(data)[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	//the lengths keep "ab" + "c" apart from "a" + "bc"
+	size_t vertLength = vertShaderPath.size();
+	size_t fragLength = fragShaderPath.size();
+	add(&vertLength, sizeof(vertLength));
+	add(vertShaderPath.data(), vertLength);
+	add(&fragLength, sizeof(fragLength));
+	add(fragShaderPath.data(), fragLength);
+	uint32_t state[] = { static_cast<uint32_t>(vertexInput), static_cast<uint32_t>(blendMode), cullMode, depthWrite ? 1u : 0u,
+		static_cast<uint32_t>(samples), static_cast<uint32_t>(specializationConstants.size()) };
+	add(state, sizeof(state));
+	add(specializationConstants.data(), specializationConstants.size() * sizeof(uint32_t));
+	add(&layout, sizeof(layout));
+	//0 stands for an object's default pipeline
+	return hash != 0 ? hash : 1;
+}
+
+VkPipeline my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& device, const VkExtent2D& swapChainExtent,
+	VkSampleCountFlagBits msaaCount, const std::string& vertShaderPath, const std::string& fragShaderPath, VertexInput vertexInput, VkPipelineLayout layout)
 {
-	auto vertShader = VulkanUtils::readFile("shaders/vert.spv");
-	auto fragShader = VulkanUtils::readFile("shaders/frag.spv");
+	PipelineDesc desc;
+	desc.vertShaderPath = vertShaderPath;
+	desc.fragShaderPath = fragShaderPath;
+	desc.vertexInput = vertexInput;
+	desc.samples = msaaCount;
+	desc.layout = layout;
+	if (vertexInput == VertexInput::PARTICLE)
+	{
+		//particles glow additively, so they never need sorting
+		desc.blendMode = BlendMode::ADDITIVE;
+		desc.cullMode = VK_CULL_MODE_NONE;
+		desc.depthWrite = false;
+	}
+	return createGraphicsPipeline(device, desc);
+}
 
-	auto vertShaderModule = VulkanUtils::createShaderModule(vertShader, device);
-	auto fragShaderModule = VulkanUtils::createShaderModule(fragShader, device);
+VkPipeline my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& device, const PipelineDesc& desc)
+{
+	auto vertShaderModule = pipelineCache->getShaderModule(desc.vertShaderPath);
+	auto fragShaderModule = pipelineCache->getShaderModule(desc.fragShaderPath);
+
+	std::vector<VkSpecializationMapEntry> specializationEntries(desc.specializationConstants.size());
+	for (uint32_t i = 0; i != specializationEntries.size(); ++i)
+		specializationEntries[i] = { i, i * static_cast<uint32_t>(sizeof(uint32_t)), sizeof(uint32_t) };
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+	specializationInfo.pMapEntries = specializationEntries.data();
+	specializationInfo.dataSize = desc.specializationConstants.size() * sizeof(uint32_t);
+	specializationInfo.pData = desc.specializationConstants.data();
+	const VkSpecializationInfo* specialization = specializationEntries.empty() ? nullptr : &specializationInfo;
+	VertexInput vertexInput = desc.vertexInput;
 
 	VkPipelineShaderStageCreateInfo vertShaderStageCreateInfo{};
 	vertShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertShaderStageCreateInfo.module = vertShaderModule;
 	vertShaderStageCreateInfo.pName = "main";
 	vertShaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageCreateInfo.pSpecializationInfo = specialization;
 
 	VkPipelineShaderStageCreateInfo fragShaderStageCreateInfo{};
 	fragShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	fragShaderStageCreateInfo.module = fragShaderModule;
 	fragShaderStageCreateInfo.pName = "main";
 	fragShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageCreateInfo.pSpecializationInfo = specialization;
 
 	VkPipelineShaderStageCreateInfo shaderStagesCreateInfo[] = { vertShaderStageCreateInfo, fragShaderStageCreateInfo };
 
@@ -120,21 +251,45 @@ void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& d
 	dynamicStates.dynamicStateCount = 2;
 	dynamicStates.pDynamicStates = states.data();
 
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+	if (vertexInput == VertexInput::PARTICLE)
+	{
+		bindingDescriptions.push_back(Particle::getBindingDescription());
+		auto particleAttributeDescriptions = Particle::getAttributeDescriptions();
+		attributeDescriptions.assign(particleAttributeDescriptions.begin(), particleAttributeDescriptions.end());
+	}
+	else if (vertexInput == VertexInput::MESH_COMPRESSED)
+	{
+		bindingDescriptions.push_back(CompressedVertex::getBindingDescription());
+		auto vertexAttributeDescriptions = CompressedVertex::getAttributeDescriptions();
+		attributeDescriptions.assign(vertexAttributeDescriptions.begin(), vertexAttributeDescriptions.end());
+	}
+	else
+	{
+		bindingDescriptions.push_back(Vertex::getBindingDescription());
+		auto vertexAttributeDescriptions = Vertex::getAttributeDescriptions();
+		attributeDescriptions.assign(vertexAttributeDescriptions.begin(), vertexAttributeDescriptions.end());
+	}
+	if (vertexInput == VertexInput::MESH_INSTANCED)
+	{
+		bindingDescriptions.push_back(InstanceData::getBindingDescription());
+		auto instanceAttributeDescriptions = InstanceData::getAttributeDescriptions();
+		attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributeDescriptions.begin(), instanceAttributeDescriptions.end());
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo{};
 	vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
+	vertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 	vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputStateCreateInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputStateCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo{};
 	inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 	inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
-	inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssemblyStateCreateInfo.topology = vertexInput == VertexInput::PARTICLE ? VK_PRIMITIVE_TOPOLOGY_POINT_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
 	VkPipelineTessellationStateCreateInfo tessellationStateCreateInfo{};
 	tessellationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
@@ -142,28 +297,15 @@ void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& d
 	VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
 	viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 
-	VkViewport viewport{};
-	viewport.width = static_cast<float>(swapChainExtent.width);
-	viewport.height = static_cast<float>(swapChainExtent.height);
-	viewport.maxDepth = 1.0f;
-	viewport.minDepth = 0.0f;
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-
-	VkRect2D scissor{};
-	scissor.extent = swapChainExtent;
-	scissor.offset = VkOffset2D{ 0, 0 };
-
+	//viewport and scissor are dynamic, so variants do not depend on the swap chain extent
 	viewportStateCreateInfo.scissorCount = 1;
 	viewportStateCreateInfo.viewportCount = 1;
-	viewportStateCreateInfo.pScissors = &scissor;
-	viewportStateCreateInfo.pViewports = &viewport;
 
 	VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{};
 	rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
 	rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-	rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizationStateCreateInfo.cullMode = desc.cullMode;
 	rasterizationStateCreateInfo.depthClampEnable = VK_FALSE;
 	rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
 	rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;
@@ -171,13 +313,20 @@ void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& d
 
 	VkPipelineColorBlendAttachmentState colorBlendAttachmentState{};
 	colorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_A_BIT | VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT;
-	colorBlendAttachmentState.blendEnable = VK_FALSE;
+	colorBlendAttachmentState.blendEnable = desc.blendMode == BlendMode::DISABLED ? VK_FALSE : VK_TRUE;
+	colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	colorBlendAttachmentState.dstColorBlendFactor = desc.blendMode == BlendMode::ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+	//the target's alpha is never read, keep it as cleared
+	colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
 
 	VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo{};
 	multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampleStateCreateInfo.sampleShadingEnable = VK_TRUE;
 	multisampleStateCreateInfo.minSampleShading = .2f;
-	multisampleStateCreateInfo.rasterizationSamples = msaaCount;
+	multisampleStateCreateInfo.rasterizationSamples = desc.samples;
 
 	VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo{};
 	colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -185,24 +334,11 @@ void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& d
 	colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
 	colorBlendStateCreateInfo.logicOpEnable = VK_FALSE;
 
-	std::vector<VkDescriptorSetLayout> layouts;
-	layouts.push_back(VulkanUtils::createDescriptorSetLayout(device, VulkanDescriptorFor::VERTEX_SHADER_UNIFORM_BUFFER));
-	layouts.push_back(VulkanUtils::createDescriptorSetLayout(device, VulkanDescriptorFor::COMBINED_IMAGE_SAMPLER));
-	layouts.push_back(VulkanUtils::createDescriptorSetLayout(device, VulkanDescriptorFor::FRAGMENT_SHADER_UNIFORM_BUFFER));
-
-	VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo{};
-	PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	PipelineLayoutCreateInfo.setLayoutCount = layouts.size();
-	PipelineLayoutCreateInfo.pSetLayouts = layouts.data();
-
-	if (vkCreatePipelineLayout(device, &PipelineLayoutCreateInfo, nullptr, &graphicsPipelineLayout) != VK_SUCCESS)
-		throw std::runtime_error("failed to create pipeline layout");
-
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineCreateInfo.basePipelineIndex = -1;
-	pipelineCreateInfo.layout = graphicsPipelineLayout;
+	pipelineCreateInfo.layout = desc.layout;
 	pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
 	pipelineCreateInfo.pDynamicState = &dynamicStates;
 	pipelineCreateInfo.pInputAssemblyState = &inputAssemblyStateCreateInfo;
@@ -218,25 +354,30 @@ void my_vulkan::VulkanGraphicsPipeline::createGraphicsPipeline(const VkDevice& d
 	VkPipelineDepthStencilStateCreateInfo depthStencil{};
 	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
 	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
 	depthStencil.stencilTestEnable = VK_FALSE;
 
 	pipelineCreateInfo.pDepthStencilState = &depthStencil;
 
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(device, pipelineCache->getPipelineCache(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
 		throw std::runtime_error("failed to create graphics pipeline");
-
-	VkComputePipelineCreateInfo pipelineInfo{};
-
-	vkDestroyShaderModule(device, vertShaderModule, nullptr);
-	vkDestroyShaderModule(device, fragShaderModule, nullptr);
+	return pipeline;
 }
 
 void my_vulkan::VulkanGraphicsPipeline::destroyGraphicsPipeline(const VkDevice& device)
 {
 	vkDestroyPipelineLayout(device, graphicsPipelineLayout, nullptr);
 	vkDestroyPipeline(device, graphicsPipeline, nullptr);
+	vkDestroyPipeline(device, instancedPipeline, nullptr);
+	if (compressedPipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(device, compressedPipeline, nullptr);
+	if (indirectPipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, indirectPipeline, nullptr);
+		vkDestroyPipelineLayout(device, indirectPipelineLayout, nullptr);
+	}
 	vkDestroyRenderPass(device, renderPass, nullptr);
 }
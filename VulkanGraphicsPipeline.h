@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -9,29 +10,105 @@ namespace my_vulkan
 	class VulkanDevice;
 	class VulkanSwapChain;
 	class VulkanDescriptors;
+	class VulkanBindlessTextures;
+	class VulkanPipelineCache;
 
+	//MESH_INSTANCED reads InstanceData from vertex binding 1 on top of the per-vertex binding 0,
+	//MESH_COMPRESSED reads CompressedVertex instead of Vertex,
+	//PARTICLE draws a point list straight out of a Particle storage buffer
+	enum class VertexInput
+	{
+		MESH,
+		MESH_INSTANCED,
+		PARTICLE,
+		MESH_COMPRESSED
+	};
+
+	//DISABLED rather than OPAQUE, which wingdi.h defines as a macro
+	enum class BlendMode
+	{
+		DISABLED,
+		ALPHA,
+		ADDITIVE
+	};
+
+	//Everything a graphics pipeline variant is built from apart from the render pass, equal descriptions share one pipeline.
+	//samples has to match the render pass
+	struct PipelineDesc
+	{
+		std::string vertShaderPath;
+		std::string fragShaderPath;
+		VertexInput vertexInput = VertexInput::MESH;
+		BlendMode blendMode = BlendMode::DISABLED;
+		VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+		bool depthWrite = true;
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+		//constant_id i of both stages is specialized to specializationConstants[i]
+		std::vector<uint32_t> specializationConstants;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+
+		bool operator==(const PipelineDesc& rhs) const;
+		//FNV-1a of every field, never 0
+		uint64_t getKey() const;
+	};
 
 	class VulkanGraphicsPipeline
 	{
 	public:
-		VulkanGraphicsPipeline(const std::shared_ptr<VulkanDevice>& device, const std::shared_ptr<VulkanSwapChain>& swapChain, VkCommandPool& commandPool);
+		//With a bindless texture table set 1 is its sampler2D[] and meshes pass MeshPushConstants instead of binding per-object sets.
+		//An indirect draw set layout adds the gpu driven variant, which reads its draws from set 3
+		VulkanGraphicsPipeline(const std::shared_ptr<VulkanDevice>& device, const std::shared_ptr<VulkanSwapChain>& swapChain, VkCommandPool& commandPool,
+			VulkanBindlessTextures* bindlessTextures = nullptr, VkDescriptorSetLayout indirectDrawSetLayout = VK_NULL_HANDLE);
 
 		void createRenderPass(const std::shared_ptr<VulkanDevice>& device, const std::shared_ptr<VulkanSwapChain>& swapChain, VkCommandPool& commandPool);
 
 
-		void createGraphicsPipeline(const VkDevice& device, const VkExtent2D& swapChainExtent, VkSampleCountFlagBits msaaCount);
+		VkPipelineLayout createPipelineLayout(const VkDevice& device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+			const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+		//Blending, culling and depth writes follow vertexInput: particles blend additively and write no depth, meshes are opaque
+		VkPipeline createGraphicsPipeline(const VkDevice& device, const VkExtent2D& swapChainExtent, VkSampleCountFlagBits msaaCount,
+			const std::string& vertShaderPath, const std::string& fragShaderPath, VertexInput vertexInput, VkPipelineLayout layout);
+		//Thread safe, so variants can be built on the thread pool
+		VkPipeline createGraphicsPipeline(const VkDevice& device, const PipelineDesc& desc);
 
 		const VkRenderPass& getRenderPass() const { return renderPass; }
 		const VkPipelineLayout& getPipelineLayout() const { return graphicsPipelineLayout; }
 		const VkPipeline& getGraphicsPipeline() const { return graphicsPipeline; }
+		//Same layout as the graphics pipeline, so descriptor sets stay bound when switching between the two
+		const VkPipeline& getInstancedPipeline() const { return instancedPipeline; }
+		//Bindless only, VK_NULL_HANDLE otherwise. The quantization is folded into the model push constant
+		const VkPipeline& getCompressedPipeline() const { return compressedPipeline; }
+		//Sets 0 to 2 are compatible with the graphics pipeline layout, set 3 holds the indirect draw objects
+		const VkPipelineLayout& getIndirectPipelineLayout() const { return indirectPipelineLayout; }
+		const VkPipeline& getIndirectPipeline() const { return indirectPipeline; }
+		bool hasIndirectPipeline() const { return indirectPipeline != VK_NULL_HANDLE; }
+		bool isBindless() const { return bindless; }
+		//The descriptions of the graphics and instanced pipelines, starting points for material variants sharing their layout
+		const PipelineDesc& getMeshPipelineDesc() const { return meshPipelineDesc; }
+		const PipelineDesc& getInstancedPipelineDesc() const { return instancedPipelineDesc; }
+		const PipelineDesc& getCompressedPipelineDesc() const { return compressedPipelineDesc; }
+		//in ms, every variant the constructor built
+		float getCreateTime() const { return createTime; }
 
 		void destroyGraphicsPipeline(const VkDevice& device);
 
 	private:
 
+		//owned by the device, shares shader modules across the variants and keeps the compiled pipelines between runs
+		VulkanPipelineCache* pipelineCache;
 		VkRenderPass renderPass;
 		VkPipelineLayout graphicsPipelineLayout;
 		VkPipeline graphicsPipeline;
+		VkPipeline instancedPipeline;
+		VkPipeline compressedPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;
+		VkPipeline indirectPipeline = VK_NULL_HANDLE;
+		bool bindless;
+		float createTime;
+		PipelineDesc meshPipelineDesc;
+		PipelineDesc instancedPipelineDesc;
+		PipelineDesc compressedPipelineDesc;
 	
 	};
 }
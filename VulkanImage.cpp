@@ -38,19 +38,7 @@ void my_vulkan::VulkanImage::createImage(const std::shared_ptr<my_vulkan::Vulkan
 	if (vkCreateImage(device->getLogicalDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS)
 		throw std::runtime_error("failed to create texture image!");
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(device->getLogicalDevice(), image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = VulkanUtils::findMemoryType(device->getPhysicalDevice(), memoryProperties, memRequirements.memoryTypeBits);
-
-	if (vkAllocateMemory(device->getLogicalDevice(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate image memory!");
-	}
-
-	vkBindImageMemory(device->getLogicalDevice(), image, imageMemory, 0);
+	allocation = device->getAllocator()->allocateImageMemory(image, memoryProperties, tilingMode);
 }
 
 void my_vulkan::VulkanImage::createImageView(const VkDevice& device, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
@@ -74,7 +62,12 @@ void my_vulkan::VulkanImage::createImageView(const VkDevice& device, VkImageAspe
 void my_vulkan::VulkanImage::transitionImageLayout(const std::shared_ptr<my_vulkan::VulkanDevice>& device, VkCommandPool& commandPool, VkImageLayout newLayout, uint32_t mipLevels)
 {
 	VkCommandBuffer commandBuffer = VulkanUtils::beginSingleTimeCommand(device->getLogicalDevice(), commandPool);
+	transitionImageLayout(commandBuffer, newLayout, mipLevels);
+	VulkanUtils::endSingleTimeCommands(device->getLogicalDevice(), commandBuffer, commandPool, device->getGraphicsQueue());
+}
 
+void my_vulkan::VulkanImage::transitionImageLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout, uint32_t mipLevels)
+{
 	VkImageMemoryBarrier barrier{};
 	barrier.image = image;
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -136,15 +129,19 @@ void my_vulkan::VulkanImage::transitionImageLayout(const std::shared_ptr<my_vulk
 		nullptr, 0,
 		nullptr, 
 		1, &barrier);
-
-	VulkanUtils::endSingleTimeCommands(device->getLogicalDevice(), commandBuffer, commandPool, device->getGraphicsQueue());
 }
 
 void my_vulkan::VulkanImage::copyBufferToImage(const std::shared_ptr<my_vulkan::VulkanDevice>& device, VkCommandPool& commandPool, VkBuffer& buffer, uint32_t width, uint32_t height)
 {
 	VkCommandBuffer commandBuffer = VulkanUtils::beginSingleTimeCommand(device->getLogicalDevice(), commandPool);
+	copyBufferToImage(commandBuffer, buffer, 0, width, height);
+	VulkanUtils::endSingleTimeCommands(device->getLogicalDevice(), commandBuffer, commandPool, device->getGraphicsQueue());
+}
+
+void my_vulkan::VulkanImage::copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, uint32_t width, uint32_t height, uint32_t mipLevel)
+{
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 	region.bufferImageHeight = 0;
 	region.bufferRowLength = 0;
 	region.imageExtent = { width, height, 1 };
@@ -152,15 +149,13 @@ void my_vulkan::VulkanImage::copyBufferToImage(const std::shared_ptr<my_vulkan::
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.baseArrayLayer = 0;
 	region.imageSubresource.layerCount = 1;
-	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.mipLevel = mipLevel;
 	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	VulkanUtils::endSingleTimeCommands(device->getLogicalDevice(), commandBuffer, commandPool, device->getGraphicsQueue());
 }
 
 void my_vulkan::VulkanImage::destroyImage(const VkDevice& device)
 {
-	vkDestroyImage(device, image, nullptr);
-	vkFreeMemory(device, imageMemory, nullptr);
 	vkDestroyImageView(device, imageView, nullptr);
+	vkDestroyImage(device, image, nullptr);
+	allocation.allocator->free(allocation);
 }
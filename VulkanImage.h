@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "vulkan/vulkan.h"
+#include "VulkanAllocator.h"
 
 namespace my_vulkan
 {
@@ -22,20 +23,22 @@ namespace my_vulkan
 		void createImageView(const VkDevice& device, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 
 		void transitionImageLayout(const std::shared_ptr<my_vulkan::VulkanDevice>& device, VkCommandPool& commandPool, VkImageLayout newLayout, uint32_t mipLevels);
+		void transitionImageLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout, uint32_t mipLevels);
 
 		void copyBufferToImage(const std::shared_ptr<my_vulkan::VulkanDevice>& device, VkCommandPool& commandPool, VkBuffer& buffer, uint32_t width, uint32_t height);
+		void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, uint32_t width, uint32_t height, uint32_t mipLevel = 0);
 
 		void destroyImage(const VkDevice& device);
 
 		VkImage& getImage() { return image; }
-		VkDeviceMemory& getImageMemory() { return imageMemory; }
+		VulkanAllocation& getAllocation() { return allocation; }
 		VkFormat& getImageFormat() { return format; }
 		VkImageLayout& getImageCurrentLayout() { return layout; }
 		VkImageView& getImageView() { return imageView; }
 
 	private:
 		VkImage image;
-		VkDeviceMemory imageMemory;
+		VulkanAllocation allocation;
 		VkImageView imageView;
 		VkFormat format;
 		VkImageLayout layout;
@@ -0,0 +1,191 @@
+#include "VulkanIndirectDraws.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanComputePipeline.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanUtils.h"
+#include "MeshRegistry.h"
+#include "Model.h"
+#include "Object.h"
+#include "BlinnPhongTexture.h"
+
+my_vulkan::VulkanIndirectDraws::VulkanIndirectDraws(const std::shared_ptr<VulkanDevice>& device, const MeshRegistry* meshRegistry)
+	: meshRegistry(meshRegistry)
+{
+	createBuffers(device);
+	createDescriptorSets(device);
+
+	VkPushConstantRange range{};
+	range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	range.offset = 0;
+	range.size = sizeof(CullingPushConstants);
+	cullingPipeline = std::make_shared<VulkanComputePipeline>(device, "shaders/cull.spv", std::vector<VkDescriptorSetLayout>{ descriptorSetLayout },
+		std::vector<VkPushConstantRange>{ range });
+}
+
+void my_vulkan::VulkanIndirectDraws::createBuffers(const std::shared_ptr<VulkanDevice>& device)
+{
+	drawObjectBuffers.resize(MAX_RENDER_IMAGES);
+	drawObjectBuffersAllocations.resize(MAX_RENDER_IMAGES);
+	commandBuffers.resize(MAX_RENDER_IMAGES);
+	commandBuffersAllocations.resize(MAX_RENDER_IMAGES);
+	countBuffers.resize(MAX_RENDER_IMAGES);
+	countBuffersAllocations.resize(MAX_RENDER_IMAGES);
+
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		VulkanUtils::createBuffer(device, drawObjectBuffers[i], drawObjectBuffersAllocations[i], sizeof(IndirectDrawObject) * MAX_INDIRECT_DRAWS,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		if (drawObjectBuffersAllocations[i].mapped == nullptr)
+			throw std::runtime_error("failed to map indirect draw objects!");
+
+		VulkanUtils::createBuffer(device, commandBuffers[i], commandBuffersAllocations[i],
+			sizeof(VkDrawIndexedIndirectCommand) * MAX_INDIRECT_DRAWS * MAX_GEOMETRY_PAGES,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		VulkanUtils::createBuffer(device, countBuffers[i], countBuffersAllocations[i], sizeof(uint32_t) * MAX_GEOMETRY_PAGES,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	}
+}
+
+void my_vulkan::VulkanIndirectDraws::createDescriptorSets(const std::shared_ptr<VulkanDevice>& device)
+{
+	//draw objects, commands, counts. The culling pass uses all three, the vertex shader only reads the draw objects
+	std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+	for (uint32_t i = 0; i != 3; ++i)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].pImmutableSamplers = nullptr;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+	}
+	descriptorSetLayout = device->getDescriptorLayoutCache()->getLayout(bindings);
+
+	std::vector<VkDescriptorSetLayout> layouts(MAX_RENDER_IMAGES, descriptorSetLayout);
+	descriptorAllocator = device->getDescriptorAllocator().get();
+	descriptorPool = descriptorAllocator->allocate(layouts, descriptorSets);
+
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		VkDescriptorBufferInfo bufferInfos[3]{};
+		bufferInfos[0].buffer = drawObjectBuffers[i];
+		bufferInfos[0].range = VK_WHOLE_SIZE;
+		bufferInfos[1].buffer = commandBuffers[i];
+		bufferInfos[1].range = VK_WHOLE_SIZE;
+		bufferInfos[2].buffer = countBuffers[i];
+		bufferInfos[2].range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet writeInfos[3]{};
+		for (uint32_t j = 0; j != 3; ++j)
+		{
+			writeInfos[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeInfos[j].descriptorCount = 1;
+			writeInfos[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writeInfos[j].dstSet = descriptorSets[i];
+			writeInfos[j].dstBinding = j;
+			writeInfos[j].dstArrayElement = 0;
+			writeInfos[j].pBufferInfo = &bufferInfos[j];
+		}
+		vkUpdateDescriptorSets(device->getLogicalDevice(), 3, writeInfos, 0, nullptr);
+	}
+}
+
+void my_vulkan::VulkanIndirectDraws::update(uint32_t frame, const std::vector<std::shared_ptr<Object>>& objects, const glm::mat4& viewProjection)
+{
+	IndirectDrawObject* drawObjects = static_cast<IndirectDrawObject*>(drawObjectBuffersAllocations[frame].mapped);
+	uint32_t drawCount = 0;
+	drawnObjects.assign(objects.size(), 0);
+	for (size_t i = 0; i != objects.size(); ++i)
+	{
+		const auto& object = objects[i];
+		//instanced objects, pipeline variants and compressed vertices keep their own draw path
+		if (object->isInstanced() || object->pipelineKey != 0 || object->vertexFormat != VertexFormat::FULL)
+			continue;
+		//an object is drawn here whole or not at all, past the buffer limits it falls back to the render queue
+		if (object->parts.size() > MAX_INDIRECT_DRAWS - drawCount)
+			continue;
+		if (std::any_of(object->parts.begin(), object->parts.end(), [](const ObjectPart& part) { return part.mesh->geometryPage >= MAX_GEOMETRY_PAGES; }))
+			continue;
+		drawnObjects[i] = 1;
+		for (const auto& part : object->parts)
+		{
+			IndirectDrawObject& drawObject = drawObjects[drawCount++];
+			drawObject.model = object->ubo->model;
+			drawObject.boundingSphere = part.boundingSphere;
+			drawObject.indexCount = part.indexCount;
+			drawObject.firstIndex = part.firstIndex;
+			drawObject.vertexOffset = part.mesh->vertexOffset;
+			drawObject.textureIndex = object->textures[part.texture]->bindlessIndex;
+			drawObject.geometryPage = part.mesh->geometryPage;
+		}
+	}
+
+	auto planes = VulkanUtils::extractFrustumPlanes(viewProjection);
+	for (size_t i = 0; i != planes.size(); ++i)
+		cullingConstants.frustumPlanes[i] = planes[i];
+	cullingConstants.drawCount = drawCount;
+}
+
+void my_vulkan::VulkanIndirectDraws::recordCulling(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+	vkCmdFillBuffer(commandBuffer, countBuffers[frame], 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline->getComputePipeline());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline->getComputePipelineLayout(), 0, 1,
+		&descriptorSets[frame], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, cullingPipeline->getComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+		sizeof(CullingPushConstants), &cullingConstants);
+	//local_size_x of cull.comp
+	vkCmdDispatch(commandBuffer, (cullingConstants.drawCount + 63) / 64, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void my_vulkan::VulkanIndirectDraws::recordDraws(VkCommandBuffer commandBuffer, uint32_t frame, VkPipelineLayout layout)
+{
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, DRAW_OBJECTS_SET, 1, &descriptorSets[frame], 0, nullptr);
+
+	VkDeviceSize offset = 0;
+	uint32_t pageCount = std::min(meshRegistry->getGeometryPageCount(), MAX_GEOMETRY_PAGES);
+	for (uint32_t page = 0; page != pageCount; ++page)
+	{
+		const auto& geometryPage = meshRegistry->getGeometryPage(page);
+		//nothing in a compressed page is drawn here, its count stays 0
+		if (geometryPage.format != VertexFormat::FULL)
+			continue;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometryPage.vertexBuffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, geometryPage.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexedIndirectCount(commandBuffer, commandBuffers[frame], sizeof(VkDrawIndexedIndirectCommand) * MAX_INDIRECT_DRAWS * page,
+			countBuffers[frame], sizeof(uint32_t) * page, MAX_INDIRECT_DRAWS, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
+void my_vulkan::VulkanIndirectDraws::destroyIndirectDraws(const VkDevice& device)
+{
+	cullingPipeline->destroyComputePipeline(device);
+	descriptorAllocator->free(descriptorPool, descriptorSets);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		VulkanUtils::destroyBuffer(device, drawObjectBuffers[i], drawObjectBuffersAllocations[i]);
+		VulkanUtils::destroyBuffer(device, commandBuffers[i], commandBuffersAllocations[i]);
+		VulkanUtils::destroyBuffer(device, countBuffers[i], countBuffersAllocations[i]);
+	}
+}
+
+my_vulkan::VulkanIndirectDraws::~VulkanIndirectDraws()
+{
+
+}
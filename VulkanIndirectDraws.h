@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include "VulkanAllocator.h"
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+	class VulkanComputePipeline;
+	class VulkanDescriptorAllocator;
+	class MeshRegistry;
+	class Object;
+
+	//One mesh draw as read by shaders/cull.comp and, through gl_InstanceIndex, by the indirect vertex shader (std430)
+	struct IndirectDrawObject
+	{
+		glm::mat4 model;
+		glm::vec4 boundingSphere; //mesh space center and radius
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t textureIndex;
+		uint32_t geometryPage;
+		uint32_t padding[3];
+	};
+
+	struct CullingPushConstants
+	{
+		glm::vec4 frustumPlanes[6];
+		uint32_t drawCount;
+	};
+
+	//GPU driven submission of every non-instanced mesh. The CPU only writes one IndirectDrawObject per mesh each frame,
+	//a compute pass frustum culls them and compacts the survivors into VkDrawIndexedIndirectCommands, one range per
+	//MeshRegistry geometry page, which the frame draws with one vkCmdDrawIndexedIndirectCount per page
+	class VulkanIndirectDraws
+	{
+	public:
+		static constexpr uint32_t MAX_INDIRECT_DRAWS = 16384;
+		static constexpr uint32_t MAX_GEOMETRY_PAGES = 8;
+		//set index of the draw objects in the indirect graphics pipeline, after the three sets it shares with the others
+		static constexpr uint32_t DRAW_OBJECTS_SET = 3;
+
+		VulkanIndirectDraws(const std::shared_ptr<VulkanDevice>& device, const MeshRegistry* meshRegistry);
+
+		//Writes the frame's draw list, only call once the frame's previous submission has completed. Objects whose parts
+		//lie past MAX_GEOMETRY_PAGES or no longer fit in MAX_INDIRECT_DRAWS are left out and reported by drawsObject
+		void update(uint32_t frame, const std::vector<std::shared_ptr<Object>>& objects, const glm::mat4& viewProjection);
+		//Whether the last update put objects[index] in the draw list, the others go through the render queue
+		bool drawsObject(size_t index) const { return drawnObjects[index] != 0; }
+		//Outside of the render pass: clears the counts, culls, and makes the commands visible to the indirect stage
+		void recordCulling(VkCommandBuffer commandBuffer, uint32_t frame);
+		//Inside the render pass with the indirect graphics pipeline bound
+		void recordDraws(VkCommandBuffer commandBuffer, uint32_t frame, VkPipelineLayout layout);
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+		uint32_t getDrawCount() const { return cullingConstants.drawCount; }
+
+		void destroyIndirectDraws(const VkDevice& device);
+
+		~VulkanIndirectDraws();
+
+	private:
+		void createBuffers(const std::shared_ptr<VulkanDevice>& device);
+		void createDescriptorSets(const std::shared_ptr<VulkanDevice>& device);
+
+		const MeshRegistry* meshRegistry;
+		std::shared_ptr<VulkanComputePipeline> cullingPipeline;
+
+		//per frame in flight, the cpu writes drawObjectBuffers while the gpu may still draw the other frame
+		std::vector<VkBuffer> drawObjectBuffers;
+		std::vector<VulkanAllocation> drawObjectBuffersAllocations;
+		std::vector<VkBuffer> commandBuffers;
+		std::vector<VulkanAllocation> commandBuffersAllocations;
+		std::vector<VkBuffer> countBuffers;
+		std::vector<VulkanAllocation> countBuffersAllocations;
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		VulkanDescriptorAllocator* descriptorAllocator;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> descriptorSets;
+
+		CullingPushConstants cullingConstants{};
+		std::vector<uint8_t> drawnObjects;
+	};
+}
@@ -1,15 +1,18 @@
 #include "VulkanInstance.h"
 
+#include <cstring>
 #include <stdexcept>
+#ifndef MY_VULKAN_HEADLESS_ONLY
 #include <GLFW/glfw3.h>
+#endif
 
 
-my_vulkan::VulkanInstance::VulkanInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers)
+my_vulkan::VulkanInstance::VulkanInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers, bool headless)
 {
-	createInstance(enableValidationLayer, validationLayers);
+	createInstance(enableValidationLayer, validationLayers, headless);
 }
 
-void my_vulkan::VulkanInstance::createInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers)
+void my_vulkan::VulkanInstance::createInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers, bool headless)
 {
 	if (enableValidationLayer && !checkValidationLayerAvailability(validationLayers))
 		throw std::runtime_error("validation layer enabled, but not available!");
@@ -21,8 +24,13 @@ void my_vulkan::VulkanInstance::createInstance(bool enableValidationLayer, const
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 3, 0);
 	appInfo.pEngineName = "NONE";
 
-	uint32_t extentionCount;
-	const char** extentions = glfwGetRequiredInstanceExtensions(&extentionCount);
+	uint32_t extentionCount = 0;
+	const char** extentions = nullptr;
+	//headless instances need no surface extensions, and builds without glfw only have headless contexts
+#ifndef MY_VULKAN_HEADLESS_ONLY
+	if (!headless)
+		extentions = glfwGetRequiredInstanceExtensions(&extentionCount);
+#endif
 
 	VkInstanceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
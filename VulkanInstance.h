@@ -7,8 +7,9 @@ namespace my_vulkan
 	class VulkanInstance
 	{
 	public:
-		VulkanInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers);
-		void createInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers);
+		//A headless instance enables no surface extensions, so it also runs where no display or window system exists
+		VulkanInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers, bool headless = false);
+		void createInstance(bool enableValidationLayer, const std::vector<const char*>& validationLayers, bool headless);
 		bool checkValidationLayerAvailability(const std::vector<const char*>& validationLayers);
 
 		const VkInstance& getInstance() const { return instance; }
@@ -0,0 +1,143 @@
+#include "VulkanParallelRecorder.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <stdexcept>
+
+#include "ThreadPool.h"
+#include "VulkanDevice.h"
+#include "VulkanUtils.h"
+
+my_vulkan::VulkanParallelRecorder::VulkanParallelRecorder(const std::shared_ptr<VulkanDevice>& device, uint32_t threadCount)
+	: device(device->getLogicalDevice())
+{
+	threadPool = std::make_unique<ThreadPool>(std::min(std::max(threadCount, 2u), MAX_RECORDING_THREADS) - 1);
+	createCommandPools(device);
+}
+
+uint32_t my_vulkan::VulkanParallelRecorder::getMaxThreads() const
+{
+	return threadPool->getThreadCount() + 1;
+}
+
+void my_vulkan::VulkanParallelRecorder::createCommandPools(const std::shared_ptr<VulkanDevice>& device)
+{
+	VkCommandPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.queueFamilyIndex = VulkanDevice::queryQueueFamilyIndices(device->getPhysicalDevice()).graphicsAndComputeQueue.value();
+	//the buffers are rerecorded every frame and only ever reset through their pool
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	slotPools.resize(MAX_RENDER_IMAGES);
+	for (auto& framePools : slotPools)
+	{
+		framePools.resize(MAX_RECORDING_THREADS + 1);
+		for (auto& slot : framePools)
+			if (vkCreateCommandPool(this->device, &createInfo, nullptr, &slot.commandPool) != VK_SUCCESS)
+				throw std::runtime_error("failed to create recording command pool!");
+	}
+}
+
+void my_vulkan::VulkanParallelRecorder::beginFrame(uint32_t frame)
+{
+	for (auto& slot : slotPools[frame])
+	{
+		if (slot.usedCount == 0)
+			continue;
+		vkResetCommandPool(device, slot.commandPool, 0);
+		slot.usedCount = 0;
+	}
+}
+
+VkCommandBuffer my_vulkan::VulkanParallelRecorder::beginSecondary(SlotPool& slot, const VkCommandBufferInheritanceInfo& inheritance)
+{
+	if (slot.usedCount == slot.commandBuffers.size())
+	{
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandBufferCount = 1;
+		allocateInfo.commandPool = slot.commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate secondary command buffer!");
+		slot.commandBuffers.push_back(commandBuffer);
+	}
+	VkCommandBuffer commandBuffer = slot.commandBuffers[slot.usedCount++];
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		throw std::runtime_error("failed to begin secondary command buffer!");
+	return commandBuffer;
+}
+
+VkCommandBuffer my_vulkan::VulkanParallelRecorder::beginSecondary(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance)
+{
+	return beginSecondary(slotPools[frame][MAX_RECORDING_THREADS], inheritance);
+}
+
+std::vector<VkCommandBuffer> my_vulkan::VulkanParallelRecorder::record(uint32_t frame, uint32_t count, uint32_t threadCount,
+	const VkCommandBufferInheritanceInfo& inheritance, const std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)>& recordRange)
+{
+	uint32_t rangeCount = std::min({ threadCount, count, getMaxThreads() });
+	std::vector<VkCommandBuffer> commandBuffers(rangeCount);
+	if (rangeCount == 0)
+		return commandBuffers;
+
+	auto recordSlot = [&, this](uint32_t slot)
+	{
+		uint32_t begin = count * slot / rangeCount;
+		uint32_t end = count * (slot + 1) / rangeCount;
+		VkCommandBuffer commandBuffer = beginSecondary(slotPools[frame][slot], inheritance);
+		recordRange(commandBuffer, begin, end);
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to record secondary command buffer!");
+		commandBuffers[slot] = commandBuffer;
+	};
+
+	std::vector<std::future<void>> jobs;
+	std::exception_ptr error;
+	try
+	{
+		for (uint32_t slot = 1; slot < rangeCount; ++slot)
+			jobs.push_back(threadPool->submit([&recordSlot, slot]() { recordSlot(slot); }));
+		recordSlot(0);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	//the jobs reference the locals above, so every one has to finish before the first error is rethrown
+	for (auto& job : jobs)
+	{
+		try
+		{
+			job.get();
+		}
+		catch (...)
+		{
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+	return commandBuffers;
+}
+
+void my_vulkan::VulkanParallelRecorder::destroyRecorder(const VkDevice& device)
+{
+	for (auto& framePools : slotPools)
+		for (auto& slot : framePools)
+			vkDestroyCommandPool(device, slot.commandPool, nullptr);
+	slotPools.clear();
+}
+
+my_vulkan::VulkanParallelRecorder::~VulkanParallelRecorder()
+{
+
+}
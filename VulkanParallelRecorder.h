@@ -0,0 +1,59 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+	class ThreadPool;
+
+	//Records secondary command buffers on its own workers, so recording never queues behind asset loads or pipeline
+	//builds on the shared pool. Every recording slot owns one VkCommandPool per frame in flight,
+	//a slot is only used by one job at a time so the pools need no locking, and a frame's pools are reset as a whole
+	//in beginFrame instead of freeing buffers one by one
+	class VulkanParallelRecorder
+	{
+	public:
+		static constexpr uint32_t MAX_RECORDING_THREADS = 8;
+
+		//Starts up to MAX_RECORDING_THREADS - 1 workers, the calling thread records the first range itself
+		VulkanParallelRecorder(const std::shared_ptr<VulkanDevice>& device, uint32_t threadCount = std::thread::hardware_concurrency());
+
+		//Only call once the frame's previous submission has completed
+		void beginFrame(uint32_t frame);
+
+		//The calling thread and the workers, record never splits into more ranges than this
+		uint32_t getMaxThreads() const;
+
+		//Splits [0, count) into up to threadCount contiguous ranges. The first range is recorded on the calling thread, the
+		//others on the pool, each into its own begun secondary buffer that is ended here. The buffers come back in range order
+		std::vector<VkCommandBuffer> record(uint32_t frame, uint32_t count, uint32_t threadCount, const VkCommandBufferInheritanceInfo& inheritance,
+			const std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)>& recordRange);
+
+		//A begun secondary buffer from the calling thread's slot, for work that has to stay on the main thread (e.g. imgui)
+		VkCommandBuffer beginSecondary(uint32_t frame, const VkCommandBufferInheritanceInfo& inheritance);
+
+		void destroyRecorder(const VkDevice& device);
+
+		~VulkanParallelRecorder();
+
+	private:
+		struct SlotPool
+		{
+			VkCommandPool commandPool;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t usedCount = 0;
+		};
+
+		void createCommandPools(const std::shared_ptr<VulkanDevice>& device);
+		VkCommandBuffer beginSecondary(SlotPool& slot, const VkCommandBufferInheritanceInfo& inheritance);
+
+		VkDevice device;
+		std::unique_ptr<ThreadPool> threadPool;
+		//[frame][slot], the last slot of each frame belongs to the main thread
+		std::vector<std::vector<SlotPool>> slotPools;
+	};
+}
@@ -0,0 +1,178 @@
+#include "VulkanPipelineCache.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanUtils.h"
+
+namespace
+{
+	uint64_t hashData(const char* data, size_t size)
+	{
+		//FNV-1a, catches a truncated or corrupted file before the driver sees it
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+my_vulkan::VulkanPipelineCache::VulkanPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path)
+	: device(device), path(path)
+{
+	VkPhysicalDeviceIDProperties idProperties{};
+	idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &idProperties;
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	deviceHeader.magic = MAGIC;
+	deviceHeader.version = VERSION;
+	deviceHeader.vendorID = properties.properties.vendorID;
+	deviceHeader.deviceID = properties.properties.deviceID;
+	deviceHeader.driverVersion = properties.properties.driverVersion;
+	memcpy(deviceHeader.driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+	memcpy(deviceHeader.pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	createPipelineCache(true);
+}
+
+bool my_vulkan::VulkanPipelineCache::loadData(std::vector<char>& data)
+{
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in.is_open())
+		return false;
+
+	size_t fileSize = static_cast<size_t>(in.tellg());
+	Header header{};
+	if (fileSize < sizeof(Header) + sizeof(VkPipelineCacheHeaderVersionOne))
+		return false;
+	in.seekg(0);
+	in.read(reinterpret_cast<char*>(&header), sizeof(Header));
+
+	//a cache from another gpu or driver is at best useless and at worst crashes the driver, so it is dropped
+	bool valid = header.magic == MAGIC && header.version == VERSION && header.vendorID == deviceHeader.vendorID &&
+		header.deviceID == deviceHeader.deviceID && header.driverVersion == deviceHeader.driverVersion &&
+		memcmp(header.driverUUID, deviceHeader.driverUUID, VK_UUID_SIZE) == 0 &&
+		memcmp(header.pipelineCacheUUID, deviceHeader.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+		header.dataSize == fileSize - sizeof(Header);
+	if (!valid)
+		return false;
+
+	data.resize(static_cast<size_t>(header.dataSize));
+	in.read(data.data(), static_cast<std::streamsize>(data.size()));
+	if (!in || hashData(data.data(), data.size()) != header.dataHash)
+		return false;
+
+	//the driver's own header has to agree as well
+	VkPipelineCacheHeaderVersionOne driverHeader;
+	memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+	return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && driverHeader.vendorID == deviceHeader.vendorID &&
+		driverHeader.deviceID == deviceHeader.deviceID && memcmp(driverHeader.pipelineCacheUUID, deviceHeader.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void my_vulkan::VulkanPipelineCache::createPipelineCache(bool loadFromDisk)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<char> data;
+	loadedFromDisk = loadFromDisk && loadData(data);
+	if (!loadedFromDisk)
+		data.clear();
+	loadedSize = data.size();
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	VkResult result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+	if (result != VK_SUCCESS && loadedFromDisk)
+	{
+		//data the driver rejects after all is no reason not to start
+		std::cout << "pipeline cache " << path << " rejected by the driver" << std::endl;
+		loadedFromDisk = false;
+		loadedSize = 0;
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+	}
+	if (result != VK_SUCCESS)
+		throw std::runtime_error("failed to create pipeline cache!");
+	loadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+VkShaderModule my_vulkan::VulkanPipelineCache::getShaderModule(const std::string& shaderPath)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = shaderModules.find(shaderPath);
+	if (it != shaderModules.end())
+		return it->second;
+
+	VkShaderModule module = VulkanUtils::createShaderModule(VulkanUtils::readFile(shaderPath), device);
+	shaderModules.emplace(shaderPath, module);
+	return module;
+}
+
+void my_vulkan::VulkanPipelineCache::save()
+{
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+		return;
+	std::vector<char> data(dataSize);
+	if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+		return;
+	data.resize(dataSize);
+
+	Header header = deviceHeader;
+	header.dataSize = data.size();
+	header.dataHash = hashData(data.data(), data.size());
+
+	//Written to a temporary first so an interrupted run never leaves a half written cache behind
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+		{
+			std::cout << "cannot write pipeline cache : " << path << std::endl;
+			return;
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		out.write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error)
+		std::filesystem::remove(tempPath, error);
+}
+
+void my_vulkan::VulkanPipelineCache::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	destroyShaderModules();
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	createPipelineCache(false);
+}
+
+void my_vulkan::VulkanPipelineCache::destroyShaderModules()
+{
+	for (auto& [shaderPath, module] : shaderModules)
+		vkDestroyShaderModule(device, module, nullptr);
+	shaderModules.clear();
+}
+
+void my_vulkan::VulkanPipelineCache::destroyPipelineCache()
+{
+	save();
+	destroyShaderModules();
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace my_vulkan
+{
+	//A VkPipelineCache every pipeline is created through, persisted to disk between runs, and the shader modules built from
+	//the .spv files so each one is read and created once however many pipelines share it.
+	//Layout on disk: Header | vkGetPipelineCacheData blob. The blob is only handed back to the driver when the header
+	//matches the device's vendor, device, driver version, driver UUID and pipeline cache UUID
+	class VulkanPipelineCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x4C50504D; //"MPPL"
+		static constexpr uint32_t VERSION = 1;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint32_t reserved;
+			uint64_t dataSize;
+			uint64_t dataHash;
+			uint8_t driverUUID[VK_UUID_SIZE];
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		};
+
+		VulkanPipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path = "pipeline_cache.bin");
+
+		VkPipelineCache getPipelineCache() const { return pipelineCache; }
+		//The module of the .spv at shaderPath, owned by the cache
+		VkShaderModule getShaderModule(const std::string& shaderPath);
+
+		bool isLoadedFromDisk() const { return loadedFromDisk; }
+		size_t getLoadedSize() const { return loadedSize; }
+		float getLoadTime() const { return loadTime; }
+
+		//Starts over with an empty cache and no shader modules, for measuring cold pipeline creation
+		void reset();
+		//Writes every pipeline created so far to path
+		void save();
+
+		//Saves before destroying
+		void destroyPipelineCache();
+
+	private:
+		void createPipelineCache(bool loadFromDisk);
+		bool loadData(std::vector<char>& data);
+		void destroyShaderModules();
+
+		VkDevice device;
+		std::string path;
+		Header deviceHeader{};
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		bool loadedFromDisk = false;
+		size_t loadedSize = 0;
+		//in ms, reading and validating the file and creating the cache from it
+		float loadTime = 0.0f;
+
+		std::unordered_map<std::string, VkShaderModule> shaderModules;
+		std::mutex mutex;
+	};
+}
@@ -0,0 +1,112 @@
+#include "VulkanPipelineManager.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "ThreadPool.h"
+
+my_vulkan::VulkanPipelineManager::VulkanPipelineManager(VkDevice device, VulkanGraphicsPipeline* graphicsPipeline, ThreadPool* threadPool)
+	: device(device), graphicsPipeline(graphicsPipeline), threadPool(threadPool)
+{
+
+}
+
+uint64_t my_vulkan::VulkanPipelineManager::request(const PipelineDesc& desc)
+{
+	if (desc.layout == VK_NULL_HANDLE)
+		throw std::runtime_error("pipeline variant has no layout!");
+
+	uint64_t key = desc.getKey();
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = variants.find(key);
+	if (it != variants.end())
+	{
+		if (!(it->second.desc == desc))
+			throw std::runtime_error("pipeline variant key collision!");
+		return key;
+	}
+
+	Variant& variant = variants[key];
+	variant.desc = desc;
+	//the job owns its copy, the map may rehash while it runs
+	VkDevice device = this->device;
+	VulkanGraphicsPipeline* graphicsPipeline = this->graphicsPipeline;
+	variant.build = threadPool->submit([device, graphicsPipeline, desc]() { return graphicsPipeline->createGraphicsPipeline(device, desc); }).share();
+	return key;
+}
+
+my_vulkan::VulkanPipelineManager::Variant& my_vulkan::VulkanPipelineManager::findVariant(uint64_t key)
+{
+	auto it = variants.find(key);
+	if (it == variants.end())
+		throw std::runtime_error("unknown pipeline variant!");
+	return it->second;
+}
+
+VkPipeline my_vulkan::VulkanPipelineManager::getPipeline(uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Variant& variant = findVariant(key);
+	if (variant.pipeline == VK_NULL_HANDLE && variant.build.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		variant.pipeline = variant.build.get();
+	return variant.pipeline;
+}
+
+VkPipeline my_vulkan::VulkanPipelineManager::waitPipeline(uint64_t key)
+{
+	std::shared_future<VkPipeline> build;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		build = findVariant(key).build;
+	}
+	//not under the lock, other variants stay available while this one finishes
+	VkPipeline pipeline = build.get();
+	std::lock_guard<std::mutex> lock(mutex);
+	findVariant(key).pipeline = pipeline;
+	return pipeline;
+}
+
+void my_vulkan::VulkanPipelineManager::waitIdle()
+{
+	std::vector<uint64_t> keys;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& [key, variant] : variants)
+			keys.push_back(key);
+	}
+	for (uint64_t key : keys)
+		waitPipeline(key);
+}
+
+uint32_t my_vulkan::VulkanPipelineManager::getVariantCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<uint32_t>(variants.size());
+}
+
+uint32_t my_vulkan::VulkanPipelineManager::getPendingCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	uint32_t pending = 0;
+	for (const auto& [key, variant] : variants)
+		if (variant.build.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			++pending;
+	return pending;
+}
+
+void my_vulkan::VulkanPipelineManager::destroyPipelineManager(const VkDevice& device)
+{
+	//a variant that failed to build has nothing to destroy
+	for (auto& [key, variant] : variants)
+	{
+		try
+		{
+			vkDestroyPipeline(device, variant.build.get(), nullptr);
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+	variants.clear();
+}
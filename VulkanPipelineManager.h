@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+#include "VulkanGraphicsPipeline.h"
+
+namespace my_vulkan
+{
+	class ThreadPool;
+
+	//Graphics pipeline variants keyed by PipelineDesc::getKey. The first request of a description builds it on the thread
+	//pool through the device's pipeline cache, later requests return the same key. Variants live as long as the manager,
+	//objects hold their key and the renderer looks the pipeline up once per frame
+	class VulkanPipelineManager
+	{
+	public:
+		VulkanPipelineManager(VkDevice device, VulkanGraphicsPipeline* graphicsPipeline, ThreadPool* threadPool);
+
+		//Schedules the build unless the description is already known
+		uint64_t request(const PipelineDesc& desc);
+		//VK_NULL_HANDLE while the variant is still building, rethrows when its build failed
+		VkPipeline getPipeline(uint64_t key);
+		//Blocks until the variant is built
+		VkPipeline waitPipeline(uint64_t key);
+		void waitIdle();
+
+		uint32_t getVariantCount();
+		uint32_t getPendingCount();
+
+		void destroyPipelineManager(const VkDevice& device);
+
+	private:
+		struct Variant
+		{
+			PipelineDesc desc;
+			std::shared_future<VkPipeline> build;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+		};
+
+		//callers hold mutex
+		Variant& findVariant(uint64_t key);
+
+		VkDevice device;
+		VulkanGraphicsPipeline* graphicsPipeline;
+		ThreadPool* threadPool;
+		std::unordered_map<uint64_t, Variant> variants;
+		std::mutex mutex;
+	};
+}
@@ -1,5 +1,8 @@
 #include "VulkanRenderer.h"
 #define IMGUI_DEFINE_MATH_OPERATORS
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <stdexcept>
 #include "Vertex.h"
 #include "VulkanContext.h"
@@ -15,8 +18,23 @@
 #include "Model.h"
 #include "VulkanImage.h"
 #include "VulkanUtils.h"
+#include "VulkanUploader.h"
+#include "VulkanUniformArena.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanBindlessTextures.h"
+#include "VulkanIndirectDraws.h"
+#include "VulkanParallelRecorder.h"
+#include "VulkanFrameContext.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "VulkanPipelineManager.h"
+#include "ThreadPool.h"
+#include "Camera.h"
+#include "PointLight.h"
+#ifndef MY_VULKAN_HEADLESS_ONLY
 #include <imconfig.h>
 #include "ImguiAPI.h"
+#endif
 
 my_vulkan::VulkanRenderer::VulkanRenderer(my_vulkan::VulkanContext* context) : maxRenderImages(MAX_RENDER_IMAGES), currentFrame(0)
 {
@@ -25,10 +43,16 @@ my_vulkan::VulkanRenderer::VulkanRenderer(my_vulkan::VulkanContext* context) : m
 		colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE,
 		context->device->getMsaaSamples(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
 
-	depthResources = std::make_shared<VulkanDepthResources>(context->device, context->swapChain->getSwapChainExtent(), context->commandPool);
+	depthResources = std::make_shared<VulkanDepthResources>(context->device, context->swapChain->getSwapChainExtent(), context->uploadCommandPool);
 	createFramebuffers(context->device->getLogicalDevice(), context->swapChain, context->graphicsPipeline->getRenderPass());
-	createCommandBuffer(context->device->getLogicalDevice(), context->commandPool);
+	createFrameContexts(context->device);
 	createSynchronizationObjects(context->device->getLogicalDevice());
+	if (context->swapChain->isHeadless())
+		createReadbackBuffers(context->device, context->swapChain->getSwapChainExtent());
+	recorder = std::make_shared<VulkanParallelRecorder>(context->device);
+	setRecordingThreads(recorder->getMaxThreads());
+	profiler = context->profiler.get();
+	lastFrameTime = std::chrono::high_resolution_clock::now();
 	
 	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
 	clearValues[1].depthStencil = { 1.0f, 0 };
@@ -55,29 +79,10 @@ void my_vulkan::VulkanRenderer::createFramebuffers(const VkDevice& device, const
 	}
 }
 
-void my_vulkan::VulkanRenderer::createCommandBuffer(const VkDevice& device, VkCommandPool& commandPool)
+void my_vulkan::VulkanRenderer::createFrameContexts(const std::shared_ptr<VulkanDevice>& device)
 {
-	commandBuffers.resize(maxRenderImages);
-	for(auto& commandBuffer : commandBuffers)
-	{
-		VkCommandBufferAllocateInfo allocateInfo{};
-		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocateInfo.commandBufferCount = 1;
-		allocateInfo.commandPool = commandPool;
-		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		if (vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate command buffer!");
-	}
-	for (auto& commandBuffer : computeCommandBuffers)
-	{
-		VkCommandBufferAllocateInfo allocateInfo{};
-		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocateInfo.commandBufferCount = 1;
-		allocateInfo.commandPool = commandPool;
-		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		if (vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate command buffer!");
-	}
+	for (uint32_t i = 0; i != maxRenderImages; ++i)
+		frameContexts.push_back(std::make_shared<VulkanFrameContext>(device));
 }
 
 void my_vulkan::VulkanRenderer::createSynchronizationObjects(const VkDevice& device)
@@ -86,13 +91,8 @@ void my_vulkan::VulkanRenderer::createSynchronizationObjects(const VkDevice& dev
 	VkSemaphoreCreateInfo semaphoreCreateInfo{};
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VkFenceCreateFlagBits::VK_FENCE_CREATE_SIGNALED_BIT;
-
 	imageAvailableSemaphores.resize(maxRenderImages);
 	renderFinishedSemaphores.resize(maxRenderImages);
-	inFlightFences.resize(maxRenderImages);
 
 	for(auto& imageAvailableSemaphore : imageAvailableSemaphores)
 		if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS)
@@ -102,13 +102,27 @@ void my_vulkan::VulkanRenderer::createSynchronizationObjects(const VkDevice& dev
 		if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphore) != VK_SUCCESS)
 			throw std::runtime_error("failed to create renderFinishedSemaphores");
 
-	for (auto& inFlightFence : inFlightFences)
-		if (vkCreateFence(device, &fenceCreateInfo, nullptr, &inFlightFence) != VK_SUCCESS)
-			throw std::runtime_error("failed to create inFlightFences");
+	//swap chain acquire and present only take binary semaphores, everything else is paced on the timeline
+	frameTimeline = VulkanUtils::createTimelineSemaphore(device);
+}
+
+void my_vulkan::VulkanRenderer::createReadbackBuffers(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent)
+{
+	readbackExtent = extent;
+	readbackBuffers.resize(maxRenderImages);
+	readbackBuffersAllocations.resize(maxRenderImages);
+	for (uint32_t i = 0; i != maxRenderImages; ++i)
+	{
+		VulkanUtils::createBuffer(device, readbackBuffers[i], readbackBuffersAllocations[i], static_cast<VkDeviceSize>(extent.width) * extent.height * 4,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		if (readbackBuffersAllocations[i].mapped == nullptr)
+			throw std::runtime_error("failed to map readback buffer!");
+	}
 }
 
 void my_vulkan::VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline,
-	const VkExtent2D& swapChainExtent, ImguiAPI* imgui, const std::vector<std::shared_ptr<Object>>& objects)
+	const VkExtent2D& swapChainExtent, ImguiAPI* imgui, const std::vector<std::shared_ptr<Object>>& objects, VulkanIndirectDraws* indirectDraws,
+	ParticleSystem* particleSystem, VkImage readbackImage)
 {
 
 	VkCommandBufferBeginInfo commandBufferBeginInfo{};
@@ -116,6 +130,13 @@ void my_vulkan::VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffe
 	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 
+	if (indirectDraws)
+	{
+		uint32_t cullingScope = profiler->beginGpuScope(commandBuffer, "culling");
+		indirectDraws->recordCulling(commandBuffer, currentFrame);
+		profiler->endGpuScope(commandBuffer, cullingScope);
+	}
+
 	VkFramebuffer frameBuffer = frameBuffers[imageIndex];
 
 	VkRenderPassBeginInfo beginInfo{};
@@ -127,9 +148,143 @@ void my_vulkan::VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffe
 	beginInfo.renderArea.extent = swapChainExtent;
 	beginInfo.renderArea.offset = VkOffset2D{ 0, 0 };
 
-	vkCmdBeginRenderPass(commandBuffer, &beginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+	using clock = std::chrono::high_resolution_clock;
+	//timestamps may not be written inside a subpass that only executes secondary buffers, so the scope wraps the whole pass
+	uint32_t renderPassScope = profiler->beginGpuScope(commandBuffer, "render pass");
+	if (recordingThreads == 1)
+	{
+		vkCmdBeginRenderPass(commandBuffer, &beginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+		recordDrawState(commandBuffer, pipeline, swapChainExtent);
+		if (indirectDraws)
+		{
+			//every plain mesh of the frame in one indirect count draw per geometry page
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getIndirectPipeline());
+			indirectDraws->recordDraws(commandBuffer, currentFrame, pipeline->getIndirectPipelineLayout());
+		}
+
+		auto start = clock::now();
+		frameStats.queueStats = recordPackets(commandBuffer, pipeline, 0, renderQueue.getPacketCount());
+		frameStats.recordTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		if (particleSystem)
+			particleSystem->recordDraw(commandBuffer, frameViewProjection);
+		//builds without imgui always pass null
+#ifndef MY_VULKAN_HEADLESS_ONLY
+		if (imgui)
+		{
+			uint32_t imguiScope = profiler->beginGpuScope(commandBuffer, "imgui");
+			imgui->updateImgui(commandBuffer, objects, frameStats);
+			profiler->endGpuScope(commandBuffer, imguiScope);
+		}
+#endif
+	}
+	else
+	{
+		//the subpass may then only execute secondary buffers, so the indirect draws and imgui get one of their own as well
+		vkCmdBeginRenderPass(commandBuffer, &beginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.renderPass = pipeline->getRenderPass();
+		inheritance.subpass = 0;
+		inheritance.framebuffer = frameBuffer;
+
+		std::vector<VkCommandBuffer> secondaryBuffers;
+		if (indirectDraws)
+		{
+			VkCommandBuffer indirectBuffer = recorder->beginSecondary(currentFrame, inheritance);
+			recordDrawState(indirectBuffer, pipeline, swapChainExtent);
+			vkCmdBindPipeline(indirectBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getIndirectPipeline());
+			indirectDraws->recordDraws(indirectBuffer, currentFrame, pipeline->getIndirectPipelineLayout());
+			if (vkEndCommandBuffer(indirectBuffer) != VK_SUCCESS)
+				throw std::runtime_error("failed to record command buffer");
+			secondaryBuffers.push_back(indirectBuffer);
+		}
+
+		auto start = clock::now();
+		//each thread records a contiguous run of the sorted packets, so state stays grouped within every buffer
+		frameStats.queueStats = RenderQueueStats{};
+		std::mutex statsMutex;
+		auto objectBuffers = recorder->record(currentFrame, static_cast<uint32_t>(renderQueue.getPacketCount()), recordingThreads, inheritance,
+			[&](VkCommandBuffer secondaryBuffer, uint32_t begin, uint32_t end)
+			{
+				recordDrawState(secondaryBuffer, pipeline, swapChainExtent);
+				RenderQueueStats stats = recordPackets(secondaryBuffer, pipeline, begin, end);
+				std::lock_guard<std::mutex> lock(statsMutex);
+				frameStats.queueStats += stats;
+			});
+		frameStats.recordTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		secondaryBuffers.insert(secondaryBuffers.end(), objectBuffers.begin(), objectBuffers.end());
+
+		if (particleSystem)
+		{
+			VkCommandBuffer particleBuffer = recorder->beginSecondary(currentFrame, inheritance);
+			recordDrawState(particleBuffer, pipeline, swapChainExtent);
+			particleSystem->recordDraw(particleBuffer, frameViewProjection);
+			if (vkEndCommandBuffer(particleBuffer) != VK_SUCCESS)
+				throw std::runtime_error("failed to record command buffer");
+			secondaryBuffers.push_back(particleBuffer);
+		}
+
+#ifndef MY_VULKAN_HEADLESS_ONLY
+		if (imgui)
+		{
+			VkCommandBuffer imguiBuffer = recorder->beginSecondary(currentFrame, inheritance);
+			uint32_t imguiScope = profiler->beginGpuScope(imguiBuffer, "imgui");
+			imgui->updateImgui(imguiBuffer, objects, frameStats);
+			profiler->endGpuScope(imguiBuffer, imguiScope);
+			if (vkEndCommandBuffer(imguiBuffer) != VK_SUCCESS)
+				throw std::runtime_error("failed to record command buffer");
+			secondaryBuffers.push_back(imguiBuffer);
+		}
+#endif
+
+		if (!secondaryBuffers.empty())
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	profiler->endGpuScope(commandBuffer, renderPassScope);
+
+	if (readbackImage != VK_NULL_HANDLE)
+	{
+		//the render pass left the target in TRANSFER_SRC_OPTIMAL, this only orders the resolve before the copy
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = readbackImage;
+		imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageBarrier.subresourceRange.levelCount = 1;
+		imageBarrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, readbackImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffers[currentFrame], 1, &region);
+
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+			1, &hostBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		throw std::runtime_error("failed to record command buffer");
+}
 
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getGraphicsPipeline());
+void my_vulkan::VulkanRenderer::recordDrawState(VkCommandBuffer commandBuffer, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline,
+	const VkExtent2D& swapChainExtent)
+{
 	VkViewport viewport{};
 	viewport.width = swapChainExtent.width;
 	viewport.height = swapChainExtent.height;
@@ -145,37 +300,124 @@ void my_vulkan::VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffe
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	for (const auto & object : objects)
+	if (pipeline->isBindless())
 	{
-		object->Render(currentFrame, commandBuffer, pipeline->getPipelineLayout());
+		//one bind for the whole frame, meshes only push constants
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getPipelineLayout(), 0,
+			static_cast<uint32_t>(bindlessFrameSets.size()), bindlessFrameSets.data(),
+			static_cast<uint32_t>(bindlessFrameOffsets.size()), bindlessFrameOffsets.data());
 	}
+}
 
-	imgui->updateImgui(commandBuffer, objects);
-
-	vkCmdEndRenderPass(commandBuffer);
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-		throw std::runtime_error("failed to record command buffer");
+my_vulkan::RenderQueueStats my_vulkan::VulkanRenderer::recordPackets(VkCommandBuffer commandBuffer,
+	const std::shared_ptr<VulkanGraphicsPipeline>& pipeline, size_t begin, size_t end)
+{
+	//called from several workers at once, so only reads renderer state
+	return renderQueue.submit(commandBuffer, pipeline->getPipelineLayout(), pipeline->isBindless(), objectUniformSets[0], objectUniformSets[1],
+		begin, end);
 }
 
-void my_vulkan::VulkanRenderer::recordComputeCommandBuffer(VkCommandBuffer commandBuffer, const std::shared_ptr<VulkanComputePipeline>& computePipeline, 
-	const std::shared_ptr<VulkanDescriptors>& descriptors)
+void my_vulkan::VulkanRenderer::setRecordingThreads(uint32_t threadCount)
 {
-	VkCommandBufferBeginInfo beginInfo;
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	recordingThreads = std::max(1u, std::min(threadCount, recorder->getMaxThreads()));
+	frameStats.recordingThreads = recordingThreads;
+}
 
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-		throw std::runtime_error("failed to begin recording command buffer!");
+void my_vulkan::VulkanRenderer::buildRenderQueue(VulkanPipelineManager* pipelineManager, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline,
+	const std::vector<std::shared_ptr<Object>>& objects, const VulkanIndirectDraws* indirectDraws)
+{
+	renderQueue.clear();
+	for (size_t i = 0; i != objects.size(); ++i)
+	{
+		const auto& object = objects[i];
+		//the indirect draws cover plain objects on the default pipeline that fit in their buffers
+		if (indirectDraws && indirectDraws->drawsObject(i))
+			continue;
+		VkPipeline variant = object->pipelineKey != 0 ? pipelineManager->getPipeline(object->pipelineKey) : VK_NULL_HANDLE;
+		if (variant == VK_NULL_HANDLE && object->isInstanced())
+			variant = pipeline->getInstancedPipeline();
+		else if (variant == VK_NULL_HANDLE)
+			variant = object->vertexFormat == VertexFormat::COMPRESSED ? pipeline->getCompressedPipeline() : pipeline->getGraphicsPipeline();
+		//instanced objects are never culled as a whole, and the cpu culling does not run next to the gpu one
+		const uint8_t* meshVisibility = object->isInstanced() || indirectDraws ? nullptr : culler.getVisibility(objectFirstSpheres[i]);
+		object->enqueueDraws(renderQueue, currentFrame, variant, frameViewProjection, meshVisibility);
 	}
 
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline->getComputePipeline());
+	if (frameStats.sortedDraws)
+		renderQueue.sort();
+	frameStats.sortTime = frameStats.sortedDraws ? renderQueue.getSortTime() : 0.0f;
+}
 
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline->getComputePipelineLayout(),
-		0, 1, &descriptors->getDescriptorSets()[currentFrame], 0, 0);
+void my_vulkan::VulkanRenderer::cullObjects(const std::vector<std::shared_ptr<Object>>& objects)
+{
+	culler.clear();
+	objectFirstSpheres.resize(objects.size());
+	for (size_t i = 0; i != objects.size(); ++i)
+	{
+		objectFirstSpheres[i] = culler.getCount();
+		if (objects[i]->isInstanced())
+			continue;
+		for (const auto& part : objects[i]->parts)
+			culler.add(objects[i]->ubo->model, glm::vec3(part.boundingSphere), part.boundingSphere.w);
+	}
+	culler.cull(VulkanUtils::extractFrustumPlanes(frameViewProjection));
 
-	vkCmdDispatch(commandBuffer, PARTICLE_COUNT / 256, 1, 1);
+	frameStats.meshCount = culler.getCount();
+	frameStats.culledMeshCount = culler.getCount() - culler.getVisibleCount();
+	frameStats.culledObjectCount = 0;
+	for (size_t i = 0; i != objects.size(); ++i)
+	{
+		if (objects[i]->isInstanced() || objects[i]->parts.empty())
+			continue;
+		const uint8_t* meshVisibility = culler.getVisibility(objectFirstSpheres[i]);
+		if (std::none_of(meshVisibility, meshVisibility + objects[i]->parts.size(), [](uint8_t visible) { return visible != 0; }))
+			++frameStats.culledObjectCount;
+	}
+}
 
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("failed to record command buffer!");
+void my_vulkan::VulkanRenderer::beginFrame(my_vulkan::VulkanContext* context, Camera* camera, PointLight* light)
+{
+	//assets created after the scene load still need their copies executed before they are drawn
+	if (context->uploader->hasPendingUploads())
+		context->uploader->flush();
+
+	{
+		ProfileScope scope(profiler, "wait");
+		VulkanUtils::waitTimelineSemaphore(context->device->getLogicalDevice(), frameTimeline, frameContexts[currentFrame]->getSubmitValue());
+	}
+	profiler->beginFrame(currentFrame);
+	context->uniformArena->beginFrame(currentFrame);
+	context->frameDescriptorAllocators[currentFrame]->resetPools();
+	frameContexts[currentFrame]->reset();
+	recorder->beginFrame(currentFrame);
+
+	auto now = std::chrono::high_resolution_clock::now();
+	frameDeltaTime = std::chrono::duration<float>(now - lastFrameTime).count();
+	lastFrameTime = now;
+
+	glm::mat4 projection = camera->matrices.perspective;
+	projection[1][1] *= -1;
+	frameViewProjection = projection * camera->matrices.view;
+	objectUniformSets[0] = context->uniformArena->getDescriptorSet(VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER, currentFrame);
+	objectUniformSets[1] = context->uniformArena->getDescriptorSet(VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER, currentFrame);
+
+	if (context->bindlessTextures)
+	{
+		VertexUniformBufferObject vertexUbo{};
+		vertexUbo.view = camera->matrices.view;
+		vertexUbo.proj = projection;
+
+		FragmentUniformBufferObject fragmentUbo{};
+		fragmentUbo.ks = { 0.8f, 0.8f, 0.8f };
+		fragmentUbo.cameraPos = camera->position;
+		fragmentUbo.lightPos = light->transformation.position;
+		fragmentUbo.lightIntensity = light->intensity;
+
+		bindlessFrameOffsets[0] = context->uniformArena->push(vertexUbo);
+		bindlessFrameOffsets[1] = context->uniformArena->push(fragmentUbo);
+		bindlessFrameSets[0] = context->uniformArena->getDescriptorSet(VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER, currentFrame);
+		bindlessFrameSets[1] = context->bindlessTextures->getDescriptorSet();
+		bindlessFrameSets[2] = context->uniformArena->getDescriptorSet(VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER, currentFrame);
 	}
 }
 
@@ -183,14 +425,16 @@ void my_vulkan::VulkanRenderer::draw(my_vulkan::VulkanContext* context, ImguiAPI
 {
 	VkSubmitInfo submitInfo{};
 
-	vkWaitForFences(context->device->getLogicalDevice(), 1, &inFlightFences[currentFrame], VK_FALSE, UINT64_MAX);
-
-	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(context->device->getLogicalDevice(), context->swapChain->getSwapChain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+	//each frame in flight owns one offscreen target, which the frame timeline already protects
+	bool headless = context->swapChain->isHeadless();
+	uint32_t imageIndex = currentFrame;
+	VkResult result = VK_SUCCESS;
+	if (!headless)
+		result = vkAcquireNextImageKHR(context->device->getLogicalDevice(), context->swapChain->getSwapChain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		recreateSwapChain(context->swapChain, context->wind.window, context->device, context->surface, context->graphicsPipeline->getRenderPass(), context->commandPool);
+		recreateSwapChain(context->swapChain, context->wind.window, context->device, context->surface, context->graphicsPipeline->getRenderPass(), context->uploadCommandPool);
 		return;
 	}
 	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
@@ -198,24 +442,91 @@ void my_vulkan::VulkanRenderer::draw(my_vulkan::VulkanContext* context, ImguiAPI
 		throw std::runtime_error("failed to acquire next image");
 	
 	}
-	recordCommandBuffer(commandBuffers[currentFrame], imageIndex, context->graphicsPipeline, context->swapChain->getSwapChainExtent(), imgui, objects);
+	VulkanIndirectDraws* indirectDraws = indirectDrawsEnabled && context->graphicsPipeline->hasIndirectPipeline() ? context->indirectDraws.get() : nullptr;
+	if (indirectDraws)
+		indirectDraws->update(currentFrame, objects, frameViewProjection);
+	else
+		cullObjects(objects);
+	frameStats.gpuCulling = indirectDraws != nullptr;
+	buildRenderQueue(context->pipelineManager.get(), context->graphicsPipeline, objects, indirectDraws);
+
+	//the step runs on the compute queue while the cpu records the frame that draws it
+	ParticleSystem* particleSystem = context->particleSystem.get();
+	if (particleSystem)
+		particleSystem->simulate(currentFrame, frameDeltaTime, frameTimeline, profiler);
+	frameStats.particleCount = particleSystem ? particleSystem->getParticleCount() : 0;
+
+	VkImage readbackImage = headless && captureRequested ? context->swapChain->getSwapChainImages()[imageIndex] : VK_NULL_HANDLE;
+	{
+		ProfileScope scope(profiler, "record");
+		recordCommandBuffer(frameContexts[currentFrame]->getCommandBuffer(), imageIndex, context->graphicsPipeline, context->swapChain->getSwapChainExtent(), imgui, objects,
+			indirectDraws, particleSystem, readbackImage);
+	}
 
-	vkResetFences(context->device->getLogicalDevice(), 1, &inFlightFences[currentFrame]);
+	//the frame only waits for the uploads and the particle step it may read on the gpu, the cpu never blocks on them
+	std::vector<VkPipelineStageFlags> waitDstStageMasks;
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<uint64_t> waitValues;
+	std::vector<VkSemaphore> signalSemaphores{ frameTimeline };
+	std::vector<uint64_t> signalValues{ ++frameTimelineValue };
+	if (!headless)
+	{
+		waitDstStageMasks.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+		waitValues.push_back(0);
+		signalSemaphores.push_back(renderFinishedSemaphores[currentFrame]);
+		signalValues.push_back(0);
+	}
+	waitDstStageMasks.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	waitSemaphores.push_back(context->uploader->getTimelineSemaphore());
+	waitValues.push_back(context->uploader->getTimelineValue());
+	if (particleSystem)
+	{
+		waitDstStageMasks.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		waitSemaphores.push_back(particleSystem->getTimelineSemaphore());
+		waitValues.push_back(particleSystem->getTimelineValue());
+	}
 
-	VkPipelineStageFlags waitDstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineInfo.pSignalSemaphoreValues = signalValues.data();
 
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame];
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = &waitDstStageMask;
+	submitInfo.pCommandBuffers = frameContexts[currentFrame]->getCommandBufferPointer();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitDstStageMasks.data();
 
+	{
+		ProfileScope scope(profiler, "submit");
+		profiler->markSubmit();
+		if (vkQueueSubmit(context->device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit frame!");
+	}
+	frameContexts[currentFrame]->setSubmitValue(frameTimelineValue);
+	//the step after next overwrites the buffer this frame draws, it waits for this value first
+	if (particleSystem)
+		particleSystem->setDrawValue(frameTimelineValue);
+	if (readbackImage != VK_NULL_HANDLE)
+	{
+		captureRequested = false;
+		captureFrame = currentFrame;
+		captureValue = frameTimelineValue;
+	}
 
-	vkQueueSubmit(context->device->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
+	if (headless)
+	{
+		currentFrame = (currentFrame + 1) % maxRenderImages;
+		return;
+	}
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -225,12 +536,15 @@ void my_vulkan::VulkanRenderer::draw(my_vulkan::VulkanContext* context, ImguiAPI
 	presentInfo.waitSemaphoreCount = 1;
 	presentInfo.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
 
-	result = vkQueuePresentKHR(context->device->getPresentQueue(), & presentInfo);
+	{
+		ProfileScope scope(profiler, "present");
+		result = vkQueuePresentKHR(context->device->getPresentQueue(), & presentInfo);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || context->wind.framebufferResized)
 	{
 		context->wind.framebufferResized = false;
-		recreateSwapChain(context->swapChain, context->wind.window, context->device, context->surface, context->graphicsPipeline->getRenderPass(), context->commandPool);
+		recreateSwapChain(context->swapChain, context->wind.window, context->device, context->surface, context->graphicsPipeline->getRenderPass(), context->uploadCommandPool);
 	}
 	else if(result != VK_SUCCESS)
 		throw std::runtime_error("failed to present image!");
@@ -238,6 +552,18 @@ void my_vulkan::VulkanRenderer::draw(my_vulkan::VulkanContext* context, ImguiAPI
 	currentFrame = (currentFrame + 1) % maxRenderImages;
 }
 
+VkExtent2D my_vulkan::VulkanRenderer::readCapture(const VkDevice& device, std::vector<uint8_t>& pixels)
+{
+	if (captureValue == 0)
+		throw std::runtime_error("no frame has been captured!");
+
+	VulkanUtils::waitTimelineSemaphore(device, frameTimeline, captureValue);
+	size_t size = static_cast<size_t>(readbackExtent.width) * readbackExtent.height * 4;
+	const uint8_t* mapped = static_cast<const uint8_t*>(readbackBuffersAllocations[captureFrame].mapped);
+	pixels.assign(mapped, mapped + size);
+	return readbackExtent;
+}
+
 void my_vulkan::VulkanRenderer::recreateSwapChain(std::shared_ptr<VulkanSwapChain> swapChain, GLFWwindow* window,
 	const std::shared_ptr<VulkanDevice>& device, const VkSurfaceKHR& surface, const VkRenderPass& renderPass, VkCommandPool& commandPool)
 {
@@ -245,6 +571,9 @@ void my_vulkan::VulkanRenderer::recreateSwapChain(std::shared_ptr<VulkanSwapChai
 	for (size_t i = 0; i < frameBuffers.size(); i++) {
 		vkDestroyFramebuffer(device->getLogicalDevice(), frameBuffers[i], nullptr);
 	}
+	//the attachments are sized to the swap chain, hand their memory back before allocating the new ones
+	colorRecources->destroyImage(device->getLogicalDevice());
+	depthResources->destroyDepthResources(device->getLogicalDevice());
 	swapChain->recreateSwapChain(window, device->getLogicalDevice(), device->getPhysicalDevice(), surface);
 	colorRecources = std::make_shared<VulkanImage>(device, swapChain->getSwapChainExtent().width, swapChain->getSwapChainExtent().height, 1, 1, 1, VK_IMAGE_TYPE_2D, VkFormat::VK_FORMAT_R8G8B8A8_SRGB,
 		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE, device->getMsaaSamples(),
@@ -260,10 +589,17 @@ void my_vulkan::VulkanRenderer::destroyRenderer(const VkDevice& device)
 	{
 		vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
 		vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-		vkDestroyFence(device, inFlightFences[i], nullptr);
 	}
+	vkDestroySemaphore(device, frameTimeline, nullptr);
 	for (auto& framebuffer : frameBuffers)
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
+	colorRecources->destroyImage(device);
+	depthResources->destroyDepthResources(device);
+	recorder->destroyRecorder(device);
+	for (size_t i = 0; i != readbackBuffers.size(); ++i)
+		VulkanUtils::destroyBuffer(device, readbackBuffers[i], readbackBuffersAllocations[i]);
+	for (auto& frameContext : frameContexts)
+		frameContext->destroyFrameContext(device);
 }
 
 my_vulkan::VulkanRenderer::~VulkanRenderer()
@@ -3,9 +3,14 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <chrono>
+#include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
 #include "VulkanWindow.h"
+#include "VulkanAllocator.h"
+#include "FrustumCuller.h"
+#include "RenderQueue.h"
 
 namespace my_vulkan
 {
@@ -22,6 +27,33 @@ namespace my_vulkan
 	class VulkanUniformBuffers;
 	class VulkanSwapChain;
 	class VulkanGraphicsPipeline;
+	class Camera;
+	class PointLight;
+	class VulkanIndirectDraws;
+	class VulkanParallelRecorder;
+	class VulkanFrameContext;
+	class ParticleSystem;
+	class Profiler;
+	class VulkanPipelineManager;
+
+	struct RendererFrameStats
+	{
+		uint32_t meshCount = 0;
+		uint32_t culledMeshCount = 0;
+		uint32_t culledObjectCount = 0;
+		//culling ran in the indirect draw compute pass, the counts stay on the gpu
+		bool gpuCulling = false;
+		//cpu time spent recording the objects' draws, in ms
+		float recordTime = 0.0f;
+		uint32_t recordingThreads = 1;
+		//0 without a particle system
+		uint32_t particleCount = 0;
+		//binds and draws issued by the render queue, summed over every recording thread
+		RenderQueueStats queueStats;
+		bool sortedDraws = true;
+		//cpu time of the render queue's radix sort, in ms
+		float sortTime = 0.0f;
+	};
 
 	class VulkanRenderer
 	{
@@ -29,40 +61,103 @@ namespace my_vulkan
 		VulkanRenderer(my_vulkan::VulkanContext* context);
 
 		void createFramebuffers(const VkDevice& device, const std::shared_ptr<VulkanSwapChain> swapChain, const VkRenderPass& renderPass);
-		void createCommandBuffer(const VkDevice& device, VkCommandPool& commandPool);
+		void createFrameContexts(const std::shared_ptr<VulkanDevice>& device);
 		void createSynchronizationObjects(const VkDevice& device);
+		//One host visible buffer per frame in flight the size of a headless target
+		void createReadbackBuffers(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent);
 
+		//With indirectDraws every non-instanced mesh is culled and drawn on the gpu, otherwise each object records its own draws.
+		//Particles are drawn after the objects. imgui may be null to leave out the overlay.
+		//The culling, the render pass and imgui are timed as gpu scopes of the context's profiler.
+		//A readbackImage is copied into the current frame's readback buffer once the render pass has resolved into it
 		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline,
-			const VkExtent2D& swapChainExtent, ImguiAPI* imgui, const std::vector<std::shared_ptr<Object>>& objects);
+			const VkExtent2D& swapChainExtent, ImguiAPI* imgui, const std::vector<std::shared_ptr<Object>>& objects,
+			VulkanIndirectDraws* indirectDraws = nullptr, ParticleSystem* particleSystem = nullptr, VkImage readbackImage = VK_NULL_HANDLE);
 
-		void recordComputeCommandBuffer(VkCommandBuffer commandBuffer, const std::shared_ptr<VulkanComputePipeline>& computePipeline,
-			const std::shared_ptr<VulkanDescriptors>& descriptors);
+		//Frustum culls every mesh of the non-instanced objects on the cpu, the render queue then skips the invisible ones
+		void cullObjects(const std::vector<std::shared_ptr<Object>>& objects);
+		//Collects the draw packets of every object the indirect draws do not cover and sorts them unless sorting is off.
+		//Pipeline variants still building draw with the default pipeline
+		void buildRenderQueue(VulkanPipelineManager* pipelineManager, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline,
+			const std::vector<std::shared_ptr<Object>>& objects, const VulkanIndirectDraws* indirectDraws);
 
+		//Waits on the frame timeline until the current frame's previous submission is done and resets its uniform arena and
+		//command pools, call before objects tick.
+		//The bindless path also pushes the frame-wide camera and lighting uniforms here
+		void beginFrame(my_vulkan::VulkanContext* context, Camera* camera, PointLight* light);
+		//Headless contexts render into the frame's offscreen target and skip acquire and present
 		void draw(my_vulkan::VulkanContext* context, ImguiAPI* imgui, const std::vector<std::shared_ptr<Object>>& objects);
 
+		//Headless only, the next draw copies its target into a readback buffer
+		void requestCapture() { captureRequested = true; }
+		//Waits for the last captured frame and returns its tightly packed rgba8 pixels, top row first
+		VkExtent2D readCapture(const VkDevice& device, std::vector<uint8_t>& pixels);
+
 		void recreateSwapChain(std::shared_ptr<VulkanSwapChain> swapChain, GLFWwindow* window, const std::shared_ptr<VulkanDevice>& device, 
 			const VkSurfaceKHR& surface, const VkRenderPass& renderPass, VkCommandPool& commandPool);
 
 		uint32_t getCurrentFrame() const { return currentFrame; }
+		//Only has an effect when the context created indirect draws
+		void setIndirectDraws(bool enabled) { indirectDrawsEnabled = enabled; }
+		//1 records every draw inline into the primary buffer, more splits the objects across secondary buffers recorded on the recorder's workers, up to its getMaxThreads()
+		void setRecordingThreads(uint32_t threadCount);
+		//Off submits the draw packets in the order of the objects, for comparing bind counts
+		void setDrawSorting(bool enabled) { frameStats.sortedDraws = enabled; }
+		const RendererFrameStats& getFrameStats() const { return frameStats; }
 
 		void destroyRenderer(const VkDevice& device);
 		~VulkanRenderer();
 
 	private:
+		//binds the viewport, scissor and the bindless frame sets, none of which secondary buffers inherit. Every draw binds its own pipeline
+		void recordDrawState(VkCommandBuffer commandBuffer, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline, const VkExtent2D& swapChainExtent);
+		RenderQueueStats recordPackets(VkCommandBuffer commandBuffer, const std::shared_ptr<VulkanGraphicsPipeline>& pipeline, size_t begin, size_t end);
+
 		const uint32_t maxRenderImages;
 		std::vector<VkFramebuffer> frameBuffers;
-		std::vector<VkCommandBuffer> commandBuffers;
-		std::vector<VkCommandBuffer> computeCommandBuffers;
+		std::vector<std::shared_ptr<VulkanFrameContext>> frameContexts;
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
-		std::vector<VkFence> inFlightFences;
+		//signaled with an increasing value by every frame submission, replaces one fence per frame in flight
+		VkSemaphore frameTimeline;
+		uint64_t frameTimelineValue = 0;
 		uint32_t currentFrame;
+		std::chrono::high_resolution_clock::time_point lastFrameTime;
+		//seconds since the previous beginFrame, steps the particle simulation
+		float frameDeltaTime = 0.0f;
 
 		std::shared_ptr<VulkanImage> colorRecources;
 		std::shared_ptr<VulkanDepthResources> depthResources;
 		std::array<VkClearValue, 2> clearValues;
 
-	
+		//sets 0 to 2 of the bindless pipeline and the dynamic offsets of sets 0 and 2
+		std::array<VkDescriptorSet, 3> bindlessFrameSets;
+		std::array<uint32_t, 2> bindlessFrameOffsets;
+		glm::mat4 frameViewProjection{ 1.0f };
+		bool indirectDrawsEnabled = true;
+
+		FrustumCuller culler;
+		//index of each object's first mesh sphere in culler, in the order of the objects passed to draw
+		std::vector<uint32_t> objectFirstSpheres;
+		RenderQueue renderQueue;
+		//the uniform arena sets 0 and 2 of the current frame, which non-bindless draws bind with their own offsets
+		std::array<VkDescriptorSet, 2> objectUniformSets;
+		RendererFrameStats frameStats;
+
+		//empty unless headless
+		std::vector<VkBuffer> readbackBuffers;
+		std::vector<VulkanAllocation> readbackBuffersAllocations;
+		VkExtent2D readbackExtent{};
+		bool captureRequested = false;
+		uint32_t captureFrame = 0;
+		//frame timeline value of the captured frame, 0 before the first capture
+		uint64_t captureValue = 0;
+
+		std::shared_ptr<VulkanParallelRecorder> recorder;
+		uint32_t recordingThreads;
+		//owned by the context
+		Profiler* profiler;
+
 	};
 }
 
@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "VulkanDevice.h"
+#include "VulkanImage.h"
 #include <stdexcept>
 
 
@@ -12,14 +13,22 @@ my_vulkan::VulkanSwapChain::VulkanSwapChain(const VkPhysicalDevice& physicalDevi
 	createImageViews(device);
 }
 
+my_vulkan::VulkanSwapChain::VulkanSwapChain(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent, uint32_t imageCount)
+{
+	createOffscreenImages(device, extent, imageCount);
+}
+
 VkExtent2D my_vulkan::VulkanSwapChain::chooseSwapChainExtent(VkSurfaceCapabilitiesKHR capabilities, GLFWwindow* window)
 {
 	if (capabilities.currentExtent.width != (std::numeric_limits<uint64_t>::max)())
 		return capabilities.currentExtent;
 
 	VkExtent2D actualExtent;
-	int width, height;
+	int width = 0, height = 0;
+	//the windowed paths are unreachable without glfw, only headless contexts can be created then
+#ifndef MY_VULKAN_HEADLESS_ONLY
 	glfwGetFramebufferSize(window, &width, &height);
+#endif
 	actualExtent.width = std::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
 	actualExtent.height = std::clamp(static_cast<uint32_t>(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
 
@@ -46,6 +55,29 @@ VkPresentModeKHR my_vulkan::VulkanSwapChain::choosePresentMode(const std::vector
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+void my_vulkan::VulkanSwapChain::recreateSwapChain(GLFWwindow* window, const VkDevice& device, const VkPhysicalDevice& physicalDevice,
+	const VkSurfaceKHR& surface)
+{
+#ifndef MY_VULKAN_HEADLESS_ONLY
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+	while (width == 0 || height == 0)
+	{
+		glfwGetFramebufferSize(window, &width, &height);
+		glfwWaitEvents();
+	}
+#endif
+
+	for (size_t i = 0; i < imageViews.size(); i++) {
+		vkDestroyImageView(device, imageViews[i], nullptr);
+	}
+	vkDestroySwapchainKHR(device, swapChain, nullptr);
+
+	vkDeviceWaitIdle(device);
+	createSwapChain(physicalDevice, device, surface, window);
+	createImageViews(device);
+}
+
 void my_vulkan::VulkanSwapChain::createSwapChain(const VkPhysicalDevice& physicalDevice, const VkDevice& device, const VkSurfaceKHR& surface, GLFWwindow* window)
 {
 	VkSwapchainCreateInfoKHR createInfo{};
@@ -69,7 +101,7 @@ void my_vulkan::VulkanSwapChain::createSwapChain(const VkPhysicalDevice& physica
 	createInfo.oldSwapchain = VK_NULL_HANDLE;
 	createInfo.surface = surface;
 
-	auto indices = VulkanDevice::queryQueueFamilyIndices(physicalDevice);
+	auto indices = VulkanDevice::queryQueueFamilyIndices(physicalDevice, surface);
 	uint32_t queueIndices[] = { indices.graphicsAndComputeQueue.value(), indices.presentQueue.value() };
 	if (indices.graphicsAndComputeQueue.value() != indices.presentQueue.value())
 	{
@@ -127,8 +159,32 @@ void my_vulkan::VulkanSwapChain::createImageViews(const VkDevice& device)
 	}
 }
 
+void my_vulkan::VulkanSwapChain::createOffscreenImages(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent, uint32_t imageCount)
+{
+	//rgba8 so readbacks can be written out as png without swizzling
+	swapChainExtent = extent;
+	swapChainFormat = { VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+	swapChainPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	for (uint32_t i = 0; i != imageCount; ++i)
+	{
+		auto image = std::make_shared<VulkanImage>(device, extent.width, extent.height, 1, 1, 1, VK_IMAGE_TYPE_2D, swapChainFormat.format,
+			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_SHARING_MODE_EXCLUSIVE, VK_SAMPLE_COUNT_1_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+		swapChainImages.push_back(image->getImage());
+		imageViews.push_back(image->getImageView());
+		offscreenImages.push_back(image);
+	}
+}
+
 void my_vulkan::VulkanSwapChain::DestroySwapChain(const VkDevice& device)
 {
+	if (isHeadless())
+	{
+		for (auto& image : offscreenImages)
+			image->destroyImage(device);
+		return;
+	}
+
 	vkDestroySwapchainKHR(device, swapChain, nullptr);
 	for (auto& imageView : imageViews)
 		vkDestroyImageView(device, imageView, nullptr);
@@ -1,14 +1,20 @@
 #pragma once
+#include <memory>
 #include <vector>
-#include <GLFW/glfw3.h>
 #include <vulkan/vulkan.h>
+#include "VulkanWindow.h"
 
 namespace my_vulkan
 {
+	class VulkanDevice;
+	class VulkanImage;
+
 	class VulkanSwapChain
 	{
 	public:
 		VulkanSwapChain(const VkPhysicalDevice& physicalDevice, const VkDevice& device, const VkSurfaceKHR& surface, GLFWwindow* window);
+		//Headless, renders into imageCount offscreen images that are never presented but can be copied out for readback
+		VulkanSwapChain(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent, uint32_t imageCount);
 
 		VkExtent2D chooseSwapChainExtent(VkSurfaceCapabilitiesKHR capabilities, GLFWwindow* window);
 		VkSurfaceFormatKHR chooseSwapChainFormat(const std::vector<VkSurfaceFormatKHR>& formats);
@@ -16,6 +22,7 @@ namespace my_vulkan
 		void createSwapChain(const VkPhysicalDevice& physicalDevice, const VkDevice& device, const VkSurfaceKHR& surface, GLFWwindow* window);
 
 		void createImageViews(const VkDevice& device);
+		void createOffscreenImages(const std::shared_ptr<VulkanDevice>& device, const VkExtent2D& extent, uint32_t imageCount);
 
 		const VkSwapchainKHR& getSwapChain() const { return swapChain; }
 		const VkExtent2D& getSwapChainExtent() const { return swapChainExtent; }
@@ -23,36 +30,20 @@ namespace my_vulkan
 		const VkPresentModeKHR& getSwapChainPresentMode() const { return swapChainPresentMode; }
 		const std::vector<VkImage>& getSwapChainImages() const { return swapChainImages; }
 		const std::vector<VkImageView>& getImageViews() const { return imageViews; }
+		bool isHeadless() const { return !offscreenImages.empty(); }
 
-		void recreateSwapChain(GLFWwindow* window, const VkDevice& device, const VkPhysicalDevice& physicalDevice, const VkSurfaceKHR& surface)
-		{
-			int width = 0, height = 0;
-			glfwGetFramebufferSize(window, &width, &height);
-			while (width == 0 || height == 0)
-			{
-				glfwGetFramebufferSize(window, &width, &height);
-				glfwWaitEvents();
-			}
-
-			for (size_t i = 0; i < imageViews.size(); i++) {
-				vkDestroyImageView(device, imageViews[i], nullptr);
-			}
-			vkDestroySwapchainKHR(device, swapChain, nullptr);
-
-			vkDeviceWaitIdle(device);
-			createSwapChain(physicalDevice, device, surface, window);
-			createImageViews(device);
-		}
+		void recreateSwapChain(GLFWwindow* window, const VkDevice& device, const VkPhysicalDevice& physicalDevice, const VkSurfaceKHR& surface);
 
 		void DestroySwapChain(const VkDevice& device);
 		~VulkanSwapChain();
 
 	private:
-		VkSwapchainKHR swapChain;
+		VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 		VkExtent2D swapChainExtent;
 		VkSurfaceFormatKHR swapChainFormat;
 		VkPresentModeKHR swapChainPresentMode;
 		std::vector<VkImage> swapChainImages;
 		std::vector<VkImageView> imageViews;
+		std::vector<std::shared_ptr<VulkanImage>> offscreenImages;
 	};
 }
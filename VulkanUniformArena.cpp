@@ -0,0 +1,113 @@
+#include "VulkanUniformArena.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanUtils.h"
+
+my_vulkan::VulkanUniformArena::VulkanUniformArena(const std::shared_ptr<VulkanDevice>& device)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+	alignment = properties.limits.minUniformBufferOffsetAlignment;
+
+	createBuffers(device);
+	createDescriptorSets(device);
+}
+
+void my_vulkan::VulkanUniformArena::createBuffers(const std::shared_ptr<VulkanDevice>& device)
+{
+	buffers.resize(MAX_RENDER_IMAGES);
+	allocations.resize(MAX_RENDER_IMAGES);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		VulkanUtils::createBuffer(device, buffers[i], allocations[i], ARENA_SIZE,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		if (allocations[i].mapped == nullptr)
+			throw std::runtime_error("failed to map uniform arena!");
+	}
+}
+
+void my_vulkan::VulkanUniformArena::createDescriptorSets(const std::shared_ptr<VulkanDevice>& device)
+{
+	VkDescriptorSetLayout vertexSetLayout = VulkanUtils::getDescriptorSetLayout(device, VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER);
+	VkDescriptorSetLayout fragmentSetLayout = VulkanUtils::getDescriptorSetLayout(device, VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER);
+
+	std::vector<VkDescriptorSetLayout> layouts(MAX_RENDER_IMAGES, vertexSetLayout);
+	layouts.insert(layouts.end(), MAX_RENDER_IMAGES, fragmentSetLayout);
+	descriptorAllocator = device->getDescriptorAllocator().get();
+	descriptorPool = descriptorAllocator->allocate(layouts, sets);
+
+	vertexSets.assign(sets.begin(), sets.begin() + MAX_RENDER_IMAGES);
+	fragmentSets.assign(sets.begin() + MAX_RENDER_IMAGES, sets.end());
+
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+	{
+		//the range is one object's worth of data, the dynamic offset picks which object
+		VkDescriptorBufferInfo bufferInfos[2]{};
+		bufferInfos[0].buffer = buffers[i];
+		bufferInfos[0].offset = 0;
+		bufferInfos[0].range = sizeof(VertexUniformBufferObject);
+		bufferInfos[1].buffer = buffers[i];
+		bufferInfos[1].offset = 0;
+		bufferInfos[1].range = sizeof(FragmentUniformBufferObject);
+
+		VkWriteDescriptorSet writeInfos[2]{};
+		for (int j = 0; j != 2; ++j)
+		{
+			writeInfos[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeInfos[j].descriptorCount = 1;
+			writeInfos[j].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			writeInfos[j].dstBinding = 0;
+			writeInfos[j].dstArrayElement = 0;
+			writeInfos[j].pBufferInfo = &bufferInfos[j];
+		}
+		writeInfos[0].dstSet = vertexSets[i];
+		writeInfos[1].dstSet = fragmentSets[i];
+		vkUpdateDescriptorSets(device->getLogicalDevice(), 2, writeInfos, 0, nullptr);
+	}
+}
+
+void my_vulkan::VulkanUniformArena::beginFrame(uint32_t frame)
+{
+	currentFrame = frame;
+	head = 0;
+}
+
+uint32_t my_vulkan::VulkanUniformArena::push(const void* data, VkDeviceSize size)
+{
+	VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+	if (offset + size > ARENA_SIZE)
+		throw std::runtime_error("uniform arena is out of space!");
+
+	memcpy(static_cast<uint8_t*>(allocations[currentFrame].mapped) + offset, data, static_cast<size_t>(size));
+	head = offset + size;
+	return static_cast<uint32_t>(offset);
+}
+
+VkDescriptorSet my_vulkan::VulkanUniformArena::getDescriptorSet(VulkanDescriptorFor type, uint32_t frame) const
+{
+	switch (type)
+	{
+	case VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER:
+		return vertexSets[frame];
+	case VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER:
+		return fragmentSets[frame];
+	default:
+		throw std::runtime_error("uniform arena has no descriptor set of this type!");
+	}
+}
+
+void my_vulkan::VulkanUniformArena::destroyArena(const VkDevice& device)
+{
+	descriptorAllocator->free(descriptorPool, sets);
+	for (uint32_t i = 0; i != MAX_RENDER_IMAGES; ++i)
+		VulkanUtils::destroyBuffer(device, buffers[i], allocations[i]);
+}
+
+my_vulkan::VulkanUniformArena::~VulkanUniformArena()
+{
+
+}
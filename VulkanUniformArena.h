@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "VulkanAllocator.h"
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+	class VulkanDescriptorAllocator;
+	enum class VulkanDescriptorFor;
+
+	//Per-frame linear allocator for uniform data. Each frame in flight owns one persistently mapped buffer that is
+	//reset in beginFrame, objects push their uniforms every frame and bind the shared dynamic uniform buffer
+	//descriptor set with the returned offset, so adding objects adds no buffers, pools or descriptor sets
+	class VulkanUniformArena
+	{
+	public:
+		static constexpr VkDeviceSize ARENA_SIZE = 16 * 1024 * 1024;
+
+		VulkanUniformArena(const std::shared_ptr<VulkanDevice>& device);
+
+		//Only call once the frame's previous submission has completed
+		void beginFrame(uint32_t frame);
+
+		//Copies data into the current frame's buffer and returns the dynamic offset to bind it with
+		uint32_t push(const void* data, VkDeviceSize size);
+		template<typename T>
+		uint32_t push(const T& data) { return push(&data, sizeof(T)); }
+
+		//The dynamic uniform buffer set for VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER or FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER
+		VkDescriptorSet getDescriptorSet(VulkanDescriptorFor type, uint32_t frame) const;
+
+		VkDeviceSize getBytesUsed() const { return head; }
+		VkDeviceSize getAlignment() const { return alignment; }
+
+		void destroyArena(const VkDevice& device);
+
+		~VulkanUniformArena();
+
+	private:
+		void createBuffers(const std::shared_ptr<VulkanDevice>& device);
+		void createDescriptorSets(const std::shared_ptr<VulkanDevice>& device);
+
+		std::vector<VkBuffer> buffers;
+		std::vector<VulkanAllocation> allocations;
+
+		VulkanDescriptorAllocator* descriptorAllocator;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> sets;
+		std::vector<VkDescriptorSet> vertexSets;
+		std::vector<VkDescriptorSet> fragmentSets;
+
+		VkDeviceSize alignment;
+		uint32_t currentFrame = 0;
+		VkDeviceSize head = 0;
+	};
+}
@@ -8,7 +8,6 @@
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
-#include "imgui.h"
 #include "Vertex.h"
 #include "VulkanUtils.h"
 
@@ -34,18 +33,18 @@ void my_vulkan::VulkanUniformBuffers::createUniformBuffers(const std::shared_ptr
 	}
 
 	uniformBuffers.resize(MAX_RENDER_IMAGES);
-	uniformBuffersMemory.resize(MAX_RENDER_IMAGES);
+	uniformBuffersAllocations.resize(MAX_RENDER_IMAGES);
 	uniformBuffersMapped.resize(MAX_RENDER_IMAGES);
 
 	for (size_t i = 0; i < MAX_RENDER_IMAGES; ++i)
 	{
-		VulkanUtils::createBuffer(device, uniformBuffers[i], uniformBuffersMemory[i], bufferSize, 
+		VulkanUtils::createBuffer(device, uniformBuffers[i], uniformBuffersAllocations[i], bufferSize, 
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
 			, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
-		vkMapMemory(device->getLogicalDevice(), uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+		uniformBuffersMapped[i] = uniformBuffersAllocations[i].mapped;
 	}
-	//The buffer stays mapped to this pointer for the application's whole lifetime, this technique is called "persistent mapping"
+	//The allocator keeps host visible blocks mapped, so the buffer stays mapped to this pointer for the application's whole lifetime, this technique is called "persistent mapping"
 	//Not having to map the buffer every time we need to update it increases performances
 }
 
@@ -57,8 +56,7 @@ void my_vulkan::VulkanUniformBuffers::updateUniformBuffer(uint32_t currentImage,
 void my_vulkan::VulkanUniformBuffers::DestroyVulkanUniformBuffers(const VkDevice& device)
 {
 	for (size_t i = 0; i < MAX_RENDER_IMAGES; i++) {
-		vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-		vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
+		VulkanUtils::destroyBuffer(device, uniformBuffers[i], uniformBuffersAllocations[i]);
 	}
 }
 
@@ -3,6 +3,7 @@
 #include <vector>
 #include "vulkan/vulkan.h"
 #include "VulkanDevice.h"
+#include "VulkanAllocator.h"
 #include "glm/glm.hpp"
 
 namespace my_vulkan
@@ -23,7 +24,7 @@ namespace my_vulkan
 		void updateUniformBuffer(uint32_t currentImage, UniformBufferObject* ubo);
 	
 		std::vector<VkBuffer>& getUniformBuffers() { return uniformBuffers; }
-		std::vector<VkDeviceMemory>& getUniformBuffersMemory() { return uniformBuffersMemory; }
+		std::vector<VulkanAllocation>& getUniformBuffersAllocations() { return uniformBuffersAllocations; }
 		std::vector<void*>& getUniformBuffersMapped() { return uniformBuffersMapped; }
 
 		void DestroyVulkanUniformBuffers(const VkDevice& device);
@@ -33,7 +34,7 @@ namespace my_vulkan
 	private:
 		VulkanUBOFor type;
 		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VkDeviceMemory> uniformBuffersMemory;
+		std::vector<VulkanAllocation> uniformBuffersAllocations;
 		std::vector<void*> uniformBuffersMapped;
 		VkDeviceSize bufferSize;
 	};
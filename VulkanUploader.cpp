@@ -0,0 +1,337 @@
+#include "VulkanUploader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanDevice.h"
+#include "VulkanImage.h"
+#include "VulkanUtils.h"
+
+my_vulkan::VulkanUploader::VulkanUploader(const std::shared_ptr<VulkanDevice>& device, VkCommandPool commandPool)
+	: device(device), commandPool(commandPool), dedicatedTransfer(device->hasDedicatedTransferQueue())
+{
+	createStagingRing();
+	createTransferCommandPool();
+	timeline = VulkanUtils::createTimelineSemaphore(device->getLogicalDevice());
+}
+
+void my_vulkan::VulkanUploader::createStagingRing()
+{
+	VulkanUtils::createBuffer(device, ringBuffer, ringBufferAllocation, STAGING_RING_SIZE,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+	if (ringBufferAllocation.mapped == nullptr)
+		throw std::runtime_error("failed to map staging ring!");
+	ringMapped = static_cast<uint8_t*>(ringBufferAllocation.mapped);
+}
+
+void my_vulkan::VulkanUploader::createTransferCommandPool()
+{
+	if (!dedicatedTransfer)
+		return;
+
+	VkCommandPoolCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.queueFamilyIndex = device->getTransferQueueFamily();
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	if (vkCreateCommandPool(device->getLogicalDevice(), &createInfo, nullptr, &transferCommandPool) != VK_SUCCESS)
+		throw std::runtime_error("failed to create transfer command pool!");
+}
+
+VkCommandBuffer my_vulkan::VulkanUploader::getCommandBuffer()
+{
+	if (current.commandBuffer == VK_NULL_HANDLE)
+	{
+		current.commandBuffer = VulkanUtils::beginSingleTimeCommand(device->getLogicalDevice(), dedicatedTransfer ? transferCommandPool : commandPool);
+		if (dedicatedTransfer)
+			current.graphicsCommandBuffer = VulkanUtils::beginSingleTimeCommand(device->getLogicalDevice(), commandPool);
+	}
+	return current.commandBuffer;
+}
+
+VkCommandBuffer my_vulkan::VulkanUploader::getGraphicsCommandBuffer()
+{
+	getCommandBuffer();
+	return dedicatedTransfer ? current.graphicsCommandBuffer : current.commandBuffer;
+}
+
+bool my_vulkan::VulkanUploader::allocateFromRing(VkDeviceSize size, VkDeviceSize& offset)
+{
+	if (ringUsed == 0)
+		ringHead = ringTail = 0;
+	else if (ringHead == ringTail)
+		return false;
+
+	VkDeviceSize aligned = (ringHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+	VkDeviceSize consumed;
+	if (ringHead >= ringTail)
+	{
+		//free space is [head, end) followed by [0, tail)
+		if (aligned + size <= STAGING_RING_SIZE)
+		{
+			offset = aligned;
+			consumed = aligned - ringHead + size;
+		}
+		else if (size <= ringTail)
+		{
+			offset = 0;
+			consumed = STAGING_RING_SIZE - ringHead + size;
+		}
+		else
+			return false;
+	}
+	else
+	{
+		if (aligned + size > ringTail)
+			return false;
+		offset = aligned;
+		consumed = aligned - ringHead + size;
+	}
+
+	ringHead = offset + size;
+	ringUsed += consumed;
+	current.ringBytes += consumed;
+	current.ringEnd = ringHead;
+	return true;
+}
+
+VkBuffer my_vulkan::VulkanUploader::stage(const void* data, VkDeviceSize size, VkDeviceSize& offset)
+{
+	getCommandBuffer();
+	++stats.uploadCount;
+	stats.uploadBytes += size;
+
+	//anything larger than the ring gets a buffer of its own that lives until its batch completes
+	if (size > STAGING_RING_SIZE)
+	{
+		VkBuffer stagingBuffer;
+		VulkanAllocation stagingBufferAllocation;
+		VulkanUtils::createBuffer(device, stagingBuffer, stagingBufferAllocation, size,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		memcpy(stagingBufferAllocation.mapped, data, static_cast<size_t>(size));
+
+		current.dedicatedBuffers.push_back(stagingBuffer);
+		current.dedicatedBuffersAllocations.push_back(stagingBufferAllocation);
+		offset = 0;
+		return stagingBuffer;
+	}
+
+	retireCompletedBatches();
+	while (!allocateFromRing(size, offset))
+	{
+		//the space is held by the batch we are recording, hand it to the gpu before waiting
+		if (inFlight.empty())
+			flush();
+		waitOldestBatch();
+	}
+
+	memcpy(ringMapped + offset, data, static_cast<size_t>(size));
+	return ringBuffer;
+}
+
+void my_vulkan::VulkanUploader::uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+{
+	VkDeviceSize srcOffset;
+	VkBuffer srcBuffer = stage(data, size, srcOffset);
+
+	VkBufferCopy region{};
+	region.srcOffset = srcOffset;
+	region.dstOffset = dstOffset;
+	region.size = size;
+	vkCmdCopyBuffer(getCommandBuffer(), srcBuffer, dstBuffer, 1, &region);
+	releaseBuffer(dstBuffer, dstOffset, size);
+}
+
+void my_vulkan::VulkanUploader::uploadImage(VulkanImage* image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+	VkDeviceSize srcOffset;
+	VkBuffer srcBuffer = stage(data, size, srcOffset);
+	image->copyBufferToImage(getCommandBuffer(), srcBuffer, srcOffset, width, height);
+	releaseImage(image, mipLevels);
+}
+
+void my_vulkan::VulkanUploader::uploadImageLevels(VulkanImage* image, const void* data, const std::vector<VkDeviceSize>& levelSizes,
+	uint32_t width, uint32_t height)
+{
+	VkDeviceSize size = 0;
+	for (auto levelSize : levelSizes)
+		size += levelSize;
+
+	VkDeviceSize srcOffset;
+	VkBuffer srcBuffer = stage(data, size, srcOffset);
+	//block compressed levels are whole blocks, so every offset stays a multiple of the 16 byte block
+	for (uint32_t level = 0; level != levelSizes.size(); ++level)
+	{
+		image->copyBufferToImage(getCommandBuffer(), srcBuffer, srcOffset, std::max(width >> level, 1u), std::max(height >> level, 1u), level);
+		srcOffset += levelSizes[level];
+	}
+	releaseImage(image, static_cast<uint32_t>(levelSizes.size()));
+}
+
+void my_vulkan::VulkanUploader::releaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	if (!dedicatedTransfer)
+		return;
+
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = device->getTransferQueueFamily();
+	barrier.dstQueueFamilyIndex = device->getGraphicsQueueFamily();
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+
+	//the release half only needs the source scope, the acquire half only the destination scope
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(current.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(current.graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void my_vulkan::VulkanUploader::releaseImage(VulkanImage* image, uint32_t mipLevels)
+{
+	if (!dedicatedTransfer)
+		return;
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = device->getTransferQueueFamily();
+	barrier.dstQueueFamilyIndex = device->getGraphicsQueueFamily();
+	barrier.image = image->getImage();
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(current.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	//mipmap generation reads and writes the levels with blits next
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(current.graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void my_vulkan::VulkanUploader::flush()
+{
+	if (current.commandBuffer == VK_NULL_HANDLE)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//make the copies visible to whatever the following submissions read them with
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	VkCommandBuffer graphicsCommandBuffer = getGraphicsCommandBuffer();
+	vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &timeline;
+	timelineInfo.signalSemaphoreValueCount = 1;
+
+	if (dedicatedTransfer)
+	{
+		//the copies signal one value, the graphics half waits for it and signals the next
+		vkEndCommandBuffer(current.commandBuffer);
+		uint64_t copiesValue = ++timelineValue;
+		submitInfo.pCommandBuffers = &current.commandBuffer;
+		timelineInfo.pSignalSemaphoreValues = &copiesValue;
+		if (vkQueueSubmit(device->getTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit upload batch!");
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &timeline;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues = &copiesValue;
+	}
+
+	vkEndCommandBuffer(graphicsCommandBuffer);
+	current.timelineValue = ++timelineValue;
+	submitInfo.pCommandBuffers = &graphicsCommandBuffer;
+	timelineInfo.pSignalSemaphoreValues = &current.timelineValue;
+	if (vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		throw std::runtime_error("failed to submit upload batch!");
+
+	inFlight.push_back(std::move(current));
+	current = Batch{};
+
+	++stats.batchCount;
+	stats.submitTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	stats.peakRingUsed = std::max(stats.peakRingUsed, ringUsed);
+}
+
+void my_vulkan::VulkanUploader::retireBatch(Batch& batch)
+{
+	ringUsed -= batch.ringBytes;
+	if (batch.ringBytes != 0)
+		ringTail = batch.ringEnd;
+
+	if (dedicatedTransfer)
+	{
+		vkFreeCommandBuffers(device->getLogicalDevice(), transferCommandPool, 1, &batch.commandBuffer);
+		vkFreeCommandBuffers(device->getLogicalDevice(), commandPool, 1, &batch.graphicsCommandBuffer);
+	}
+	else
+		vkFreeCommandBuffers(device->getLogicalDevice(), commandPool, 1, &batch.commandBuffer);
+	for (size_t i = 0; i != batch.dedicatedBuffers.size(); ++i)
+		VulkanUtils::destroyBuffer(device->getLogicalDevice(), batch.dedicatedBuffers[i], batch.dedicatedBuffersAllocations[i]);
+}
+
+void my_vulkan::VulkanUploader::retireCompletedBatches()
+{
+	uint64_t completedValue;
+	vkGetSemaphoreCounterValue(device->getLogicalDevice(), timeline, &completedValue);
+	while (!inFlight.empty() && inFlight.front().timelineValue <= completedValue)
+	{
+		retireBatch(inFlight.front());
+		inFlight.pop_front();
+	}
+}
+
+void my_vulkan::VulkanUploader::waitOldestBatch()
+{
+	VulkanUtils::waitTimelineSemaphore(device->getLogicalDevice(), timeline, inFlight.front().timelineValue);
+	retireBatch(inFlight.front());
+	inFlight.pop_front();
+}
+
+void my_vulkan::VulkanUploader::waitIdle()
+{
+	flush();
+	while (!inFlight.empty())
+		waitOldestBatch();
+}
+
+void my_vulkan::VulkanUploader::destroyUploader(const VkDevice& device)
+{
+	waitIdle();
+	vkDestroySemaphore(device, timeline, nullptr);
+	if (transferCommandPool != VK_NULL_HANDLE)
+		vkDestroyCommandPool(device, transferCommandPool, nullptr);
+
+	VulkanUtils::destroyBuffer(device, ringBuffer, ringBufferAllocation);
+}
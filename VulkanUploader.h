@@ -0,0 +1,112 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "VulkanAllocator.h"
+
+namespace my_vulkan
+{
+	class VulkanDevice;
+	class VulkanImage;
+
+	//Totals since the uploader was created, nothing is printed while streaming
+	struct VulkanUploaderStats
+	{
+		uint32_t batchCount = 0;
+		uint32_t uploadCount = 0;
+		VkDeviceSize uploadBytes = 0;
+		//cpu time spent ending and submitting batches, in ms
+		float submitTime = 0.0f;
+		//the most staging ring memory in flight after a submit
+		VkDeviceSize peakRingUsed = 0;
+	};
+
+	//Stages uploads through one persistently mapped ring buffer and records the copies into a shared command buffer.
+	//A batch is submitted on flush (or when the ring runs out of space) and signals the next value of the upload timeline
+	//semaphore, its ring region is reused once that value is reached, so loading a scene costs a handful of submits and
+	//no per-resource allocations. With a dedicated transfer queue the copies run there and hand their resources over to
+	//a second command buffer on the graphics queue, which waits for them on the timeline
+	class VulkanUploader
+	{
+	public:
+		static constexpr VkDeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+		//covers texel alignment for every format we upload and the usual optimalBufferCopyOffsetAlignment
+		static constexpr VkDeviceSize STAGING_ALIGNMENT = 256;
+
+		VulkanUploader(const std::shared_ptr<VulkanDevice>& device, VkCommandPool commandPool);
+
+		//The command buffer of the batch being recorded, on the transfer queue. Staging may submit the batch when the ring
+		//is full, so fetch it again after every upload call instead of holding on to it
+		VkCommandBuffer getCommandBuffer();
+		//For work that needs the graphics queue (blits), it executes after the batch's copies. Same as getCommandBuffer
+		//without a dedicated transfer queue
+		VkCommandBuffer getGraphicsCommandBuffer();
+
+		//Copies data into staging memory and returns the buffer and offset to copy from
+		VkBuffer stage(const void* data, VkDeviceSize size, VkDeviceSize& offset);
+
+		void uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+		//The image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL by the time the copy executes, and stays in it.
+		//mipLevels is how many levels the graphics command buffer goes on to use
+		void uploadImage(VulkanImage* image, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
+		//A whole precomputed mip chain in one staging allocation, the levels packed back to back in data. Same layout
+		//requirements as uploadImage
+		void uploadImageLevels(VulkanImage* image, const void* data, const std::vector<VkDeviceSize>& levelSizes, uint32_t width, uint32_t height);
+
+		bool hasPendingUploads() const { return current.commandBuffer != VK_NULL_HANDLE; }
+		//Submits the recorded batch without waiting. Graphics submissions that wait for getTimelineValue() see its writes
+		void flush();
+		const VulkanUploaderStats& getStats() const { return stats; }
+		//Submits whatever is being recorded and blocks until every batch has finished, releasing their staging memory
+		void waitIdle();
+
+		VkSemaphore getTimelineSemaphore() const { return timeline; }
+		//The value the last submitted batch signals once all of its work, graphics half included, has executed
+		uint64_t getTimelineValue() const { return timelineValue; }
+
+		void destroyUploader(const VkDevice& device);
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			//only with a dedicated transfer queue, otherwise commandBuffer takes the graphics work as well
+			VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+			uint64_t timelineValue = 0;
+			VkDeviceSize ringBytes = 0;
+			VkDeviceSize ringEnd = 0;
+			std::vector<VkBuffer> dedicatedBuffers;
+			std::vector<VulkanAllocation> dedicatedBuffersAllocations;
+		};
+
+		void createStagingRing();
+		void createTransferCommandPool();
+		//queue family ownership transfer from the transfer to the graphics queue, a no-op without a dedicated transfer queue
+		void releaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+		void releaseImage(VulkanImage* image, uint32_t mipLevels);
+		bool allocateFromRing(VkDeviceSize size, VkDeviceSize& offset);
+		void retireBatch(Batch& batch);
+		void retireCompletedBatches();
+		void waitOldestBatch();
+
+		std::shared_ptr<VulkanDevice> device;
+		VkCommandPool commandPool;
+		VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+		bool dedicatedTransfer;
+
+		VkBuffer ringBuffer;
+		VulkanAllocation ringBufferAllocation;
+		uint8_t* ringMapped;
+		VkDeviceSize ringHead = 0;
+		VkDeviceSize ringTail = 0;
+		VkDeviceSize ringUsed = 0;
+
+		Batch current;
+		std::deque<Batch> inFlight;
+		VkSemaphore timeline;
+		uint64_t timelineValue = 0;
+
+		VulkanUploaderStats stats;
+	};
+}
@@ -1,8 +1,15 @@
-﻿#include "VulkanUtils.h"
+﻿#define STB_IMAGE_WRITE_IMPLEMENTATION
 
+#include "VulkanUtils.h"
+
+#include <algorithm>
 #include <stdexcept>
 #include <fstream>
+#include <stb_image_write.h>
 #include "VulkanDevice.h"
+#include "VulkanAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "VulkanUploader.h"
 #include "Vertex.h"
 
 uint32_t my_vulkan::VulkanUtils::findMemoryType(const VkPhysicalDevice& physicalDevice,
@@ -23,29 +30,35 @@ uint32_t my_vulkan::VulkanUtils::findMemoryType(const VkPhysicalDevice& physical
 }
 
 void my_vulkan::VulkanUtils::createBuffer(const std::shared_ptr<VulkanDevice>& device, VkBuffer& buffer,
-	VkDeviceMemory& memory, VkDeviceSize size, VkMemoryPropertyFlags requiredProperties, VkBufferUsageFlags usage)
+	VulkanAllocation& allocation, VkDeviceSize size, VkMemoryPropertyFlags requiredProperties, VkBufferUsageFlags usage,
+	const std::vector<uint32_t>& queueFamilies)
 {
+	std::vector<uint32_t> distinctFamilies(queueFamilies);
+	std::sort(distinctFamilies.begin(), distinctFamilies.end());
+	distinctFamilies.erase(std::unique(distinctFamilies.begin(), distinctFamilies.end()), distinctFamilies.end());
+
 	VkBufferCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	createInfo.size = size;
 	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	createInfo.usage = usage;
+	if (distinctFamilies.size() > 1)
+	{
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = static_cast<uint32_t>(distinctFamilies.size());
+		createInfo.pQueueFamilyIndices = distinctFamilies.data();
+	}
 
 	if (vkCreateBuffer(device->getLogicalDevice(), &createInfo, nullptr, &buffer) != VK_SUCCESS)
 		throw std::runtime_error("failed to create buffer!");
 
-	VkMemoryRequirements requirements;
-	vkGetBufferMemoryRequirements(device->getLogicalDevice(), buffer, &requirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = requirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(device->getPhysicalDevice(), requiredProperties, requirements.memoryTypeBits);
-
-	if (vkAllocateMemory(device->getLogicalDevice(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
-		throw std::runtime_error("failed to allocate buffer memory!");
+	allocation = device->getAllocator()->allocateBufferMemory(buffer, requiredProperties);
+}
 
-	vkBindBufferMemory(device->getLogicalDevice(), buffer, memory, 0);
+void my_vulkan::VulkanUtils::destroyBuffer(const VkDevice& device, VkBuffer& buffer, VulkanAllocation& allocation)
+{
+	vkDestroyBuffer(device, buffer, nullptr);
+	allocation.allocator->free(allocation);
 }
 
 void my_vulkan::VulkanUtils::endSingleTimeCommands(const VkDevice& device, VkCommandBuffer& commandBuffer, VkCommandPool& commandPool, const VkQueue& queueToSubmit)
@@ -59,13 +72,47 @@ void my_vulkan::VulkanUtils::endSingleTimeCommands(const VkDevice& device, VkCom
 
 	if(queueToSubmit != VK_NULL_HANDLE)
 	{
-		vkQueueSubmit(queueToSubmit, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(queueToSubmit);
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to create single time command fence!");
+		vkQueueSubmit(queueToSubmit, 1, &submitInfo, fence);
+		vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(device, fence, nullptr);
 	}
 
 	vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 }
 
+VkSemaphore my_vulkan::VulkanUtils::createTimelineSemaphore(const VkDevice& device, uint64_t initialValue)
+{
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	createInfo.pNext = &typeInfo;
+
+	VkSemaphore semaphore;
+	if (vkCreateSemaphore(device, &createInfo, nullptr, &semaphore) != VK_SUCCESS)
+		throw std::runtime_error("failed to create timeline semaphore!");
+	return semaphore;
+}
+
+void my_vulkan::VulkanUtils::waitTimelineSemaphore(const VkDevice& device, VkSemaphore semaphore, uint64_t value)
+{
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+	if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+		throw std::runtime_error("failed to wait for timeline semaphore!");
+}
+
 VkFormat my_vulkan::VulkanUtils::findSupportFormat(const std::shared_ptr<VulkanDevice>& device,
 	const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
 {
@@ -82,59 +129,30 @@ VkFormat my_vulkan::VulkanUtils::findSupportFormat(const std::shared_ptr<VulkanD
 	throw std::runtime_error("failed to find supported format!");
 }
 
-void my_vulkan::VulkanUtils::createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory,
-	const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
+void my_vulkan::VulkanUtils::createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer,
+	VulkanAllocation& bufferAllocation, const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
 {
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+	VulkanUtils::createBuffer(device, buffer, bufferAllocation, size,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	VulkanUtils::createBuffer(device, stagingBuffer, stagingBufferMemory, bufferSize,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-	void* data;
-	vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-	VulkanUtils::createBuffer(device, vertexBuffer, vertexBufferMemory, bufferSize,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-
-	VkDeviceSize size = sizeof(vertices[0]) * vertices.size();
-
-	VulkanUtils::copyBuffer(device->getLogicalDevice(), stagingBuffer, vertexBuffer, size, device->getGraphicsQueue(), commandPool);
-
-	vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-	vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
+	uploader->uploadBuffer(buffer, data, size);
 }
 
-void my_vulkan::VulkanUtils::createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory,
-	const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool)
+void my_vulkan::VulkanUtils::createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VulkanAllocation& vertexBufferAllocation,
+	const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
 {
-	VkDeviceSize size = sizeof(indices[0]) * indices.size();
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	VulkanUtils::createBuffer(device, stagingBuffer, stagingBufferMemory, size,
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-	void* data;
-	vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, size, 0, &data);
-	memcpy(data, indices.data(), size);
-	vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-	VulkanUtils::createBuffer(device, indexBuffer, indexBufferMemory, size,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-
-	VulkanUtils::copyBuffer(device->getLogicalDevice(), stagingBuffer, indexBuffer, size, device->getGraphicsQueue(), commandPool);
+	createDeviceLocalBuffer(vertices.data(), sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		vertexBuffer, vertexBufferAllocation, device, uploader);
+}
 
-	vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-	vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
+void my_vulkan::VulkanUtils::createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VulkanAllocation& indexBufferAllocation,
+	const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader)
+{
+	createDeviceLocalBuffer(indices.data(), sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		indexBuffer, indexBufferAllocation, device, uploader);
 }
 
-VkDescriptorSetLayout my_vulkan::VulkanUtils::createDescriptorSetLayout(const VkDevice& device,
-	VulkanDescriptorFor layout_type)
+std::vector<VkDescriptorSetLayoutBinding> my_vulkan::VulkanUtils::getDescriptorSetLayoutBindings(VulkanDescriptorFor layout_type)
 {
 	std::vector<VkDescriptorSetLayoutBinding> LayoutBinding{};
 	switch (layout_type)
@@ -157,6 +175,24 @@ VkDescriptorSetLayout my_vulkan::VulkanUtils::createDescriptorSetLayout(const Vk
 		LayoutBinding[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 		break;
 	}
+	case VulkanDescriptorFor::VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER:
+	{
+		LayoutBinding.resize(1);
+		LayoutBinding[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		LayoutBinding[0].descriptorCount = 1;
+		LayoutBinding[0].binding = 0;
+		LayoutBinding[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		break;
+	}
+	case VulkanDescriptorFor::FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER:
+	{
+		LayoutBinding.resize(1);
+		LayoutBinding[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		LayoutBinding[0].descriptorCount = 1;
+		LayoutBinding[0].binding = 0;
+		LayoutBinding[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		break;
+	}
 	case VulkanDescriptorFor::COMBINED_IMAGE_SAMPLER:
 	{
 		LayoutBinding.resize(1);
@@ -182,27 +218,23 @@ VkDescriptorSetLayout my_vulkan::VulkanUtils::createDescriptorSetLayout(const Vk
 		LayoutBinding[1].pImmutableSamplers = nullptr;
 		LayoutBinding[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
-		LayoutBinding[0].binding = 2;
-		LayoutBinding[0].descriptorCount = 1;
-		LayoutBinding[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		LayoutBinding[0].pImmutableSamplers = nullptr;
-		LayoutBinding[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		LayoutBinding[2].binding = 2;
+		LayoutBinding[2].descriptorCount = 1;
+		LayoutBinding[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		LayoutBinding[2].pImmutableSamplers = nullptr;
+		LayoutBinding[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		break;
 	}
 	default:
 		break;
 	}
+	return LayoutBinding;
+}
 
-	VkDescriptorSetLayoutCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	createInfo.bindingCount = LayoutBinding.size();
-	createInfo.pBindings = LayoutBinding.data();
-
-	VkDescriptorSetLayout descriptorSetLayout;
-
-	if (vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
-		throw std::runtime_error("failed to create descriptor set layout!");
-	return descriptorSetLayout;
+VkDescriptorSetLayout my_vulkan::VulkanUtils::getDescriptorSetLayout(const std::shared_ptr<VulkanDevice>& device,
+	VulkanDescriptorFor layout_type)
+{
+	return device->getDescriptorLayoutCache()->getLayout(getDescriptorSetLayoutBindings(layout_type));
 }
 
 VkShaderModule my_vulkan::VulkanUtils::createShaderModule(const std::vector<char>& shader, const VkDevice& device)
@@ -246,6 +278,14 @@ std::vector<char> my_vulkan::VulkanUtils::readFile(const std::string& filePath)
 	return ret;
 }
 
+void my_vulkan::VulkanUtils::writePng(const std::string& filePath, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+{
+	if (pixels.size() < static_cast<size_t>(width) * height * 4)
+		throw std::runtime_error("not enough pixels to write " + filePath);
+	if (stbi_write_png(filePath.c_str(), static_cast<int>(width), static_cast<int>(height), 4, pixels.data(), static_cast<int>(width * 4)) == 0)
+		throw std::runtime_error("failed to write png : " + filePath);
+}
+
 VkCommandBuffer my_vulkan::VulkanUtils::beginSingleTimeCommand(const VkDevice& device,
 	VkCommandPool& commandPool)
 {
@@ -268,3 +308,20 @@ VkCommandBuffer my_vulkan::VulkanUtils::beginSingleTimeCommand(const VkDevice& d
 
 	return commandBuffer;
 }
+
+std::array<glm::vec4, 6> my_vulkan::VulkanUtils::extractFrustumPlanes(const glm::mat4& viewProjection)
+{
+	//Gribb-Hartmann, glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::mat4 rows = glm::transpose(viewProjection);
+	std::array<glm::vec4, 6> planes{
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		rows[2],
+		rows[3] - rows[2]
+	};
+	for (auto& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+	return planes;
+}
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <array>
 #include <optional>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -11,13 +12,17 @@ namespace my_vulkan
 {
 	struct Vertex;
 	class VulkanDevice;
+	class VulkanUploader;
+	struct VulkanAllocation;
 	const uint32_t MAX_RENDER_IMAGES = 2;
 	const uint32_t MODEL_COUNT = 6;
-	const uint32_t PARTICLE_COUNT = 1000;
+	//default size of the particle system, --particles overrides it
+	const uint32_t PARTICLE_COUNT = 1 << 20;
 	const uint32_t WIDTH = 1920;
 	const uint32_t HEIGHT = 1080;
 
-	enum class VulkanDescriptorFor { VERTEX_SHADER_UNIFORM_BUFFER, FRAGMENT_SHADER_UNIFORM_BUFFER, COMBINED_IMAGE_SAMPLER, COMPUTE_SHADER_UNIFORM_BUFFER
+	enum class VulkanDescriptorFor { VERTEX_SHADER_UNIFORM_BUFFER, FRAGMENT_SHADER_UNIFORM_BUFFER, COMBINED_IMAGE_SAMPLER, COMPUTE_SHADER_UNIFORM_BUFFER,
+		VERTEX_SHADER_DYNAMIC_UNIFORM_BUFFER, FRAGMENT_SHADER_DYNAMIC_UNIFORM_BUFFER
 	};
 	enum class VulkanUBOFor { VERTEX_SHADER, FRAGMENT_SHADER, COMPUTE_SHADER };
 
@@ -25,8 +30,13 @@ namespace my_vulkan
 	{
 		std::optional<uint32_t> graphicsAndComputeQueue;
 		std::optional<uint32_t>	presentQueue;
+		//a family with transfer but neither graphics nor compute, usually backed by a dma engine
+		std::optional<uint32_t> transferQueue;
+		//a family with compute but no graphics, async compute runs there
+		std::optional<uint32_t> computeQueue;
 		
-		bool isComplete() { return graphicsAndComputeQueue.has_value() && presentQueue.has_value(); }
+		//headless devices never present, so they only need the graphics queue
+		bool isComplete(bool presentation = true) { return graphicsAndComputeQueue.has_value() && (presentQueue.has_value() || !presentation); }
 	};
 
 	struct SwapChainCreateDetails
@@ -59,10 +69,42 @@ namespace my_vulkan
 		float lightIntensity;
 	};
 
+	//Per draw data of the bindless pipeline, view and projection come from the frame's VertexUniformBufferObject
+	struct MeshPushConstants
+	{
+		glm::mat4 model;
+		uint32_t textureIndex;
+	};
+
+	//One particle as simulated by shaders/particle.comp (std430) and read back as a vertex by the point sprite pipeline
 	struct Particle {
-		glm::vec2 position;
-		glm::vec2 velocity;
+		glm::vec4 position;
+		glm::vec4 velocity;
 		glm::vec4 color;
+
+		static VkVertexInputBindingDescription getBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(Particle);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(Particle, position);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(Particle, color);
+			return attributeDescriptions;
+		}
 	};
 
 	class VulkanUtils
@@ -70,31 +112,46 @@ namespace my_vulkan
 	public:
 		static uint32_t findMemoryType(const VkPhysicalDevice& physicalDevice, VkMemoryPropertyFlags requiredProperties, uint32_t filters);
 
-		static void createBuffer(const std::shared_ptr<VulkanDevice>& device, VkBuffer& buffer, VkDeviceMemory& memory, VkDeviceSize size,
-		                         VkMemoryPropertyFlags requiredProperties, VkBufferUsageFlags usage);
+		//More than one distinct queue family makes the buffer concurrently shared between them instead of exclusive
+		static void createBuffer(const std::shared_ptr<VulkanDevice>& device, VkBuffer& buffer, VulkanAllocation& allocation, VkDeviceSize size,
+		                         VkMemoryPropertyFlags requiredProperties, VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies = {});
+		static void destroyBuffer(const VkDevice& device, VkBuffer& buffer, VulkanAllocation& allocation);
 
 		static void copyBuffer(const VkDevice& device, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, const VkQueue& graphicsQueue, VkCommandPool& commandPool);
 
 		static std::vector<char> readFile(const std::string& filePath);
+		//Tightly packed rgba8 rows, top row first
+		static void writePng(const std::string& filePath, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels);
 
 		static VkCommandBuffer beginSingleTimeCommand(const VkDevice& device, VkCommandPool& commandPool);
 
+		//Waits for this submission only, other work on the queue keeps running
 		static void endSingleTimeCommands(const VkDevice& device, VkCommandBuffer& commandBuffer, VkCommandPool& commandPool, const VkQueue& queueToSubmit);
 
+		static VkSemaphore createTimelineSemaphore(const VkDevice& device, uint64_t initialValue = 0);
+		static void waitTimelineSemaphore(const VkDevice& device, VkSemaphore semaphore, uint64_t value);
+
 		static VkFormat findSupportFormat(const std::shared_ptr<VulkanDevice>& device,
 			const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
 		static bool hasStencilComponent(VkFormat format) { return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT; }
 
-		static void createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory,
-			const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
-		static void createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory,
-			const std::shared_ptr<VulkanDevice>& device, VkCommandPool& commandPool);
+		static void createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VulkanAllocation& bufferAllocation,
+			const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		static void createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VulkanAllocation& vertexBufferAllocation,
+			const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
+		static void createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VulkanAllocation& indexBufferAllocation,
+			const std::shared_ptr<VulkanDevice>& device, VulkanUploader* uploader);
 
-		static VkDescriptorSetLayout createDescriptorSetLayout(const VkDevice& device, VulkanDescriptorFor layout_type);
+		static std::vector<VkDescriptorSetLayoutBinding> getDescriptorSetLayoutBindings(VulkanDescriptorFor layout_type);
+		//Layouts come from the device's layout cache and must not be destroyed by the caller
+		static VkDescriptorSetLayout getDescriptorSetLayout(const std::shared_ptr<VulkanDevice>& device, VulkanDescriptorFor layout_type);
 
 		static VkShaderModule createShaderModule(const std::vector<char>& shader, const VkDevice& device);
 
+		//Left, right, bottom, top, near, far planes as (normal, distance) with normals pointing inside, for a 0..1 depth range
+		static std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4& viewProjection);
+
 	};
 
 
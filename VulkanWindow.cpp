@@ -1,16 +1,22 @@
 #include "VulkanWindow.h"
 
+#include <stdexcept>
 #include <vector>
 
 
-my_vulkan::VulkanWindow::VulkanWindow(uint32_t width, uint32_t height, const std::string& title) : w{width}, h{height}, window_title{title}
+my_vulkan::VulkanWindow::VulkanWindow(uint32_t width, uint32_t height, const std::string& title, bool headless)
+	: w{width}, h{height}, window_title{title}, window{nullptr}
 {
 	framebufferResized = false;
-	initWindow();
+	if (!headless)
+		initWindow();
 }
 
 void my_vulkan::VulkanWindow::initWindow()
 {
+#ifdef MY_VULKAN_HEADLESS_ONLY
+	throw std::runtime_error("this build has no window, run it with --headless!");
+#else
 	glfwInit();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -18,17 +24,24 @@ void my_vulkan::VulkanWindow::initWindow()
 	window = glfwCreateWindow(w, h, window_title.c_str(), nullptr, nullptr);
 	glfwSetWindowUserPointer(window, this);
 	glfwSetFramebufferSizeCallback(window, framebufferResizedCallback);
+#endif
 }
 
+#ifndef MY_VULKAN_HEADLESS_ONLY
 void my_vulkan::framebufferResizedCallback(GLFWwindow* window, int width, int height)
 {
 	auto app = reinterpret_cast<VulkanWindow*>(glfwGetWindowUserPointer(window));
 	app->framebufferResized = true;
 }
+#endif
 
 
 my_vulkan::VulkanWindow::~VulkanWindow()
 {
+	if (window == nullptr)
+		return;
+#ifndef MY_VULKAN_HEADLESS_ONLY
 	glfwDestroyWindow(window);
 	glfwTerminate();
+#endif
 }
@@ -1,6 +1,11 @@
 #pragma once
 #include <string>
+#ifdef MY_VULKAN_HEADLESS_ONLY
+//no glfw in this build, the window only exists as a handle that stays null
+typedef struct GLFWwindow GLFWwindow;
+#else
 #include <GLFW/glfw3.h>
+#endif
 namespace my_vulkan
 {
 
@@ -9,7 +14,8 @@ namespace my_vulkan
 	class VulkanWindow
 	{
 	public:
-		VulkanWindow(uint32_t width, uint32_t height, const std::string& title);
+		//A headless window never initializes glfw and window stays null. Without glfw in the build only headless ones exist
+		VulkanWindow(uint32_t width, uint32_t height, const std::string& title, bool headless = false);
 
 		void initWindow();
 
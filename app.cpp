@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <memory>
+#ifndef MY_VULKAN_HEADLESS_ONLY
 #include "ImguiAPI.h"
+#endif
 #include "VulkanRenderer.h"
 #include "VulkanContext.h"
 #include "Arona.h"
@@ -9,6 +15,25 @@
 #include "PointLight.h"
 #include "VulkanInstance.h"
 #include "VulkanUtils.h"
+#include "Benchmarks.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "VulkanUploader.h"
+#include "VulkanDevice.h"
+#include "VulkanAllocator.h"
+#include "VulkanUniformArena.h"
+#include "VulkanUniformBuffers.h"
+#include "VulkanDescriptors.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDescriptorLayoutCache.h"
+#include "MeshRegistry.h"
+#include "InstancedObject.h"
+#include "Profiler.h"
+#include "VulkanGraphicsPipeline.h"
+#include "VulkanIndirectDraws.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanPipelineManager.h"
 
 const std::vector<std::string> aronaTexturePaths = {
 	"Models/arona/Arona_Body.png",
@@ -31,6 +56,10 @@ const std::vector<std::string> aronaModelPaths = {
 	//"D:/GitHub/GAMES202/homework0/assets/mary/Marry.obj"
 };
 
+//every part in one file with arona.mtl, exported from source/[BlueArchive] - Arona.blend. Used instead of the six
+//files when present, one set of buffers and one draw per material
+const std::string aronaCombinedModelPath = "Models/arona/arona.obj";
+
 const std::vector<std::string> lightModelPaths = {
 	//"D:/GitHub/GAMES202/homework0/assets/mary/Marry.obj"
 	"Models/light.obj"
@@ -57,12 +86,393 @@ const std::vector<std::string> planeTexturePaths =
 	"Models/Plane/plane.png"
 };
 
-int main()
+//Writes the BC7/BC5 cache of every texture next to it, ImageData::load picks them up from then on. Run with
+//--cook [texture paths], without paths the textures of the scene are cooked
+void cookTextures(const std::vector<std::string>& paths)
+{
+	my_vulkan::ThreadPool threadPool;
+	for (const auto& path : paths)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t size = my_vulkan::TextureCache::cook(path, &threadPool);
+		float time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		std::cout << my_vulkan::TextureCache::getCachePath(path) << " : " << size / 1024 << " KB, "
+			<< (my_vulkan::TextureCache::isNormalMap(path) ? "BC5" : "BC7") << ", " << time << " ms" << std::endl;
+	}
+}
+
+//Compares one VulkanUniformBuffers + VulkanDescriptors per object against pushing into the shared uniform arena,
+//run with --bench-uniforms [object count]
+void benchmarkUniforms(my_vulkan::VulkanContext* context, uint32_t maxCount)
+{
+	using clock = std::chrono::high_resolution_clock;
+	const auto& device = context->device;
+	my_vulkan::VertexUniformBufferObject vertexUbo{};
+	my_vulkan::FragmentUniformBufferObject fragmentUbo{};
+
+	for (uint32_t count = 10; count <= maxCount; count *= 10)
+	{
+		uint32_t allocationsBefore = device->getAllocator()->getStats().allocationCount;
+
+		auto start = clock::now();
+		std::vector<std::shared_ptr<my_vulkan::VulkanUniformBuffers>> uniformBuffers(count);
+		std::vector<std::shared_ptr<my_vulkan::VulkanDescriptors>> descriptors(count);
+		for (uint32_t i = 0; i != count; ++i)
+		{
+			uniformBuffers[i] = std::make_shared<my_vulkan::VulkanUniformBuffers>(device, my_vulkan::VulkanUBOFor::VERTEX_SHADER);
+			descriptors[i] = std::make_shared<my_vulkan::VulkanDescriptors>(device, uniformBuffers[i].get(), VK_NULL_HANDLE, VK_NULL_HANDLE,
+				my_vulkan::VulkanDescriptorFor::VERTEX_SHADER_UNIFORM_BUFFER);
+		}
+		float createTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		uint32_t perObjectAllocations = device->getAllocator()->getStats().allocationCount - allocationsBefore;
+		uint32_t descriptorPools = device->getDescriptorAllocator()->getPoolCount();
+
+		start = clock::now();
+		for (uint32_t i = 0; i != count; ++i)
+			uniformBuffers[i]->updateUniformBuffer(0, &vertexUbo);
+		float perObjectUpdateTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		for (uint32_t i = 0; i != count; ++i)
+		{
+			descriptors[i]->DestroyVulkanDescriptor(device->getLogicalDevice());
+			uniformBuffers[i]->DestroyVulkanUniformBuffers(device->getLogicalDevice());
+		}
+
+		start = clock::now();
+		context->uniformArena->beginFrame(0);
+		for (uint32_t i = 0; i != count; ++i)
+		{
+			context->uniformArena->push(vertexUbo);
+			context->uniformArena->push(fragmentUbo);
+		}
+		float arenaUpdateTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+		std::cout << count << " objects : per-object buffers create " << createTime << " ms, update " << perObjectUpdateTime << " ms, "
+			<< perObjectAllocations << " allocations, " << descriptorPools << " shared descriptor pools, "
+			<< device->getDescriptorLayoutCache()->getLayoutCount() << " set layouts | arena update " << arenaUpdateTime << " ms, "
+			<< context->uniformArena->getBytesUsed() / 1024 << " KB of one buffer per frame" << std::endl;
+	}
+}
+
+//Reports how long the context took to build its pipelines with the cache loaded from disk, then builds them again with an
+//empty cache and with the cache that just filled. Launch twice to see a warm startup, run with --bench-pipelines.
+//The cache saved at exit then only holds the pipelines built here
+void benchmarkPipelines(my_vulkan::VulkanContext* context)
+{
+	using clock = std::chrono::high_resolution_clock;
+	my_vulkan::VulkanPipelineCache* pipelineCache = context->device->getPipelineCache().get();
+	if (pipelineCache->isLoadedFromDisk())
+		std::cout << "startup : loaded " << pipelineCache->getLoadedSize() / 1024 << " KB of pipeline cache in " << pipelineCache->getLoadTime()
+			<< " ms" << std::endl;
+	else
+		std::cout << "startup : no valid pipeline cache on disk" << std::endl;
+
+	auto createPipelines = [&]()
+	{
+		auto start = clock::now();
+		auto pipeline = std::make_shared<my_vulkan::VulkanGraphicsPipeline>(context->device, context->swapChain, context->getUploadCommandPool(),
+			context->bindlessTextures.get(), context->indirectDraws ? context->indirectDraws->getDescriptorSetLayout() : VK_NULL_HANDLE);
+		float createTime = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+		pipeline->destroyGraphicsPipeline(context->device->getLogicalDevice());
+		return createTime;
+	};
+
+	float startupTime = context->graphicsPipeline->getCreateTime();
+	pipelineCache->reset();
+	float coldTime = createPipelines();
+	float warmTime = createPipelines();
+	//the driver may keep a disk cache of its own, which makes cold faster than a first launch on a clean machine
+	std::cout << "graphics pipelines : startup " << startupTime << " ms, cold " << coldTime << " ms, warm " << warmTime << " ms" << std::endl;
+}
+
+//Draws objects on the cpu for warmup frames and then frames measured ones, ticking sceneObjects and calling perFrame after
+//every measured frame. Returns the mean measured frame time in ms
+float runFrames(my_vulkan::VulkanContext* context, my_vulkan::VulkanRenderer* renderer, my_vulkan::Camera* camera, my_vulkan::PointLight* light,
+	const std::vector<std::shared_ptr<my_vulkan::Object>>& sceneObjects, const std::vector<std::shared_ptr<my_vulkan::Object>>& objects,
+	int frames, const std::function<void()>& perFrame)
+{
+	using clock = std::chrono::high_resolution_clock;
+	const int warmupFrames = 10;
+	clock::time_point start;
+	for (int frame = 0; frame != warmupFrames + frames; ++frame)
+	{
+		if (frame == warmupFrames)
+			start = clock::now();
+#ifndef MY_VULKAN_HEADLESS_ONLY
+		if (!context->headless)
+			glfwPollEvents();
+#endif
+		renderer->beginFrame(context, camera, light);
+		for (const auto& object : sceneObjects)
+			object->tick(renderer->getCurrentFrame(), camera, light);
+		renderer->draw(context, nullptr, objects);
+		if (frame >= warmupFrames)
+			perFrame();
+	}
+	return std::chrono::duration<float, std::milli>(clock::now() - start).count() / frames;
+}
+
+std::vector<std::shared_ptr<my_vulkan::Object>> repeatObjects(const std::vector<std::shared_ptr<my_vulkan::Object>>& sceneObjects, uint32_t count)
+{
+	std::vector<std::shared_ptr<my_vulkan::Object>> objects(count);
+	for (uint32_t i = 0; i != count; ++i)
+		objects[i] = sceneObjects[i % sceneObjects.size()];
+	return objects;
+}
+
+//Draws the scene's objects repeated up to count entries with the draws recorded on 1, 2, 4 and 8 threads and reports the
+//recording and frame times, run with --bench-recording [object count]. The objects are drawn on the cpu and without imgui
+void benchmarkRecording(my_vulkan::VulkanContext* context, my_vulkan::VulkanRenderer* renderer, my_vulkan::Camera* camera,
+	my_vulkan::PointLight* light, const std::vector<std::shared_ptr<my_vulkan::Object>>& sceneObjects, uint32_t count)
+{
+	std::vector<std::shared_ptr<my_vulkan::Object>> objects = repeatObjects(sceneObjects, count);
+	renderer->setIndirectDraws(false);
+	const int frames = 200;
+	for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2)
+	{
+		renderer->setRecordingThreads(threadCount);
+		float recordTime = 0.0f;
+		float frameTime = runFrames(context, renderer, camera, light, sceneObjects, objects, frames,
+			[&]() { recordTime += renderer->getFrameStats().recordTime; });
+		std::cout << count << " objects, " << renderer->getFrameStats().recordingThreads << " threads : recording " << recordTime / frames
+			<< " ms, frame " << frameTime << " ms" << std::endl;
+	}
+	vkDeviceWaitIdle(context->device->getLogicalDevice());
+}
+
+//Draws the scene's objects repeated up to count entries with the render queue sorted and in object order and reports the
+//binds each frame recorded, run with --bench-render-queue [object count]. The objects are drawn on the cpu on one thread
+void benchmarkRenderQueue(my_vulkan::VulkanContext* context, my_vulkan::VulkanRenderer* renderer, my_vulkan::Camera* camera,
+	my_vulkan::PointLight* light, const std::vector<std::shared_ptr<my_vulkan::Object>>& sceneObjects, uint32_t count)
+{
+	std::vector<std::shared_ptr<my_vulkan::Object>> objects = repeatObjects(sceneObjects, count);
+	renderer->setIndirectDraws(false);
+	renderer->setRecordingThreads(1);
+	const int frames = 200;
+	for (bool sorted : { false, true })
+	{
+		renderer->setDrawSorting(sorted);
+		float recordTime = 0.0f;
+		float sortTime = 0.0f;
+		float frameTime = runFrames(context, renderer, camera, light, sceneObjects, objects, frames, [&]()
+			{
+				recordTime += renderer->getFrameStats().recordTime;
+				sortTime += renderer->getFrameStats().sortTime;
+			});
+		const my_vulkan::RenderQueueStats& stats = renderer->getFrameStats().queueStats;
+		std::cout << count << " objects, " << (sorted ? "sorted" : "unsorted") << " : " << stats.drawCount << " draws, " << stats.pipelineBinds
+			<< " pipeline, " << stats.descriptorBinds << " descriptor, " << stats.vertexBufferBinds << " vertex and " << stats.indexBufferBinds
+			<< " index buffer binds, sort " << sortTime / frames << " ms, recording " << recordTime / frames << " ms, frame " << frameTime
+			<< " ms" << std::endl;
+	}
+	renderer->setDrawSorting(true);
+	vkDeviceWaitIdle(context->device->getLogicalDevice());
+}
+
+//Renders frames offscreen without a window, prints the frame time distribution and writes the last frame to capturePath
+//as png unless it is empty. Run with --headless [--frames count] [--capture path]
+void runHeadless(my_vulkan::VulkanContext* context, my_vulkan::VulkanRenderer* renderer, my_vulkan::Camera* camera,
+	my_vulkan::PointLight* light, const std::vector<std::shared_ptr<my_vulkan::Object>>& objects, uint32_t frames, const std::string& capturePath)
+{
+	using clock = std::chrono::high_resolution_clock;
+	std::vector<float> frameTimes;
+	frameTimes.reserve(frames);
+	for (uint32_t frame = 0; frame != frames; ++frame)
+	{
+		auto start = clock::now();
+		renderer->beginFrame(context, camera, light);
+		{
+			my_vulkan::ProfileScope scope(context->profiler.get(), "tick");
+			for (const auto& object : objects)
+				object->tick(renderer->getCurrentFrame(), camera, light);
+		}
+		if (frame + 1 == frames && !capturePath.empty())
+			renderer->requestCapture();
+		renderer->draw(context, nullptr, objects);
+		frameTimes.push_back(std::chrono::duration<float, std::milli>(clock::now() - start).count());
+	}
+	vkDeviceWaitIdle(context->device->getLogicalDevice());
+
+	if (!frameTimes.empty())
+	{
+		std::vector<float> sorted(frameTimes);
+		std::sort(sorted.begin(), sorted.end());
+		float total = 0.0f;
+		for (float frameTime : frameTimes)
+			total += frameTime;
+		std::cout << frames << " headless frames : mean " << total / frames << " ms, median " << sorted[sorted.size() / 2] << " ms, p99 "
+			<< sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)] << " ms" << std::endl;
+	}
+
+	if (!capturePath.empty() && frames != 0)
+	{
+		std::vector<uint8_t> pixels;
+		VkExtent2D extent = renderer->readCapture(context->device->getLogicalDevice(), pixels);
+		my_vulkan::VulkanUtils::writePng(capturePath, extent.width, extent.height, pixels);
+		std::cout << "captured the last frame to " << capturePath << std::endl;
+	}
+}
+
+//What has to exist before a command runs, main builds up to it the same way the app does
+enum class CommandStage
+{
+	NONE,
+	CONTEXT,
+	SCENE
+};
+
+//Filled up to the command's stage, the rest stays null
+struct CommandScene
+{
+	my_vulkan::VulkanContext* context = nullptr;
+	my_vulkan::VulkanRenderer* renderer = nullptr;
+	my_vulkan::Camera* camera = nullptr;
+	my_vulkan::PointLight* light = nullptr;
+	std::vector<std::shared_ptr<my_vulkan::Object>> objects;
+};
+
+//Runs instead of the window loop when its flag is the first argument. args are the arguments after the flag up to the
+//next flag, run returns false when a check failed and main then exits with EXIT_FAILURE
+struct Command
+{
+	const char* flag;
+	CommandStage stage;
+	std::function<bool(const std::vector<std::string>& args, const CommandScene& scene)> run;
+};
+
+std::vector<std::string> joinPaths(std::initializer_list<std::vector<std::string>> pathLists)
+{
+	std::vector<std::string> paths;
+	for (const auto& pathList : pathLists)
+		paths.insert(paths.end(), pathList.begin(), pathList.end());
+	return paths;
+}
+
+uint32_t getCount(const std::vector<std::string>& args, uint32_t defaultCount)
+{
+	return args.empty() ? defaultCount : static_cast<uint32_t>(std::stoul(args[0]));
+}
+
+const std::vector<std::string> vikingRoomModelPaths = {
+	"Models/viking_room/viking_room.obj"
+};
+
+const std::vector<Command> commands = {
+	//without paths the textures of the scene are cooked
+	{ "--cook", CommandStage::NONE, [](const std::vector<std::string>& args, const CommandScene&)
+		{
+			cookTextures(args.empty() ? joinPaths({ aronaTexturePaths, planeTexturePaths, lightTexturePaths }) : args);
+			return true;
+		} },
+	{ "--bench-mesh-cache", CommandStage::NONE, [](const std::vector<std::string>&, const CommandScene&)
+		{ return my_vulkan::Benchmarks::meshCache(joinPaths({ aronaModelPaths, planeModelPaths, lightModelPaths })); } },
+	{ "--bench-mesh-optimizer", CommandStage::NONE, [](const std::vector<std::string>&, const CommandScene&)
+		{ return my_vulkan::Benchmarks::meshOptimizer(joinPaths({ aronaModelPaths, vikingRoomModelPaths })); } },
+	{ "--bench-vertex-compression", CommandStage::NONE, [](const std::vector<std::string>&, const CommandScene&)
+		{ return my_vulkan::Benchmarks::vertexCompression(joinPaths({ aronaModelPaths, planeModelPaths, lightModelPaths, vikingRoomModelPaths })); } },
+	{ "--bench-obj-load", CommandStage::NONE, [](const std::vector<std::string>& args, const CommandScene&)
+		{ return my_vulkan::Benchmarks::objLoad(args.empty() ? "" : args[0]); } },
+	{ "--bench-obj-parse", CommandStage::NONE, [](const std::vector<std::string>& args, const CommandScene&)
+		{ return my_vulkan::Benchmarks::objParse(args.empty() ? "" : args[0]); } },
+	{ "--bench-texture-compression", CommandStage::NONE, [](const std::vector<std::string>&, const CommandScene&)
+		{ return my_vulkan::Benchmarks::textureCompression(aronaTexturePaths); } },
+	{ "--bench-culling", CommandStage::NONE, [](const std::vector<std::string>& args, const CommandScene&)
+		{ return my_vulkan::Benchmarks::culling(getCount(args, 100000)); } },
+	//every cpu check in one run, all of them run even after one failed
+	{ "--check", CommandStage::NONE, [](const std::vector<std::string>&, const CommandScene&)
+		{
+			bool passed = my_vulkan::Benchmarks::meshCache(joinPaths({ aronaModelPaths, planeModelPaths, lightModelPaths }));
+			passed = my_vulkan::Benchmarks::meshOptimizer(joinPaths({ aronaModelPaths, vikingRoomModelPaths })) && passed;
+			passed = my_vulkan::Benchmarks::vertexCompression(joinPaths({ aronaModelPaths, planeModelPaths, lightModelPaths, vikingRoomModelPaths })) && passed;
+			passed = my_vulkan::Benchmarks::objLoad("") && passed;
+			passed = my_vulkan::Benchmarks::objParse("") && passed;
+			passed = my_vulkan::Benchmarks::textureCompression(aronaTexturePaths) && passed;
+			passed = my_vulkan::Benchmarks::culling(100000) && passed;
+			std::cout << (passed ? "all checks passed" : "some checks failed") << std::endl;
+			return passed;
+		} },
+	{ "--bench-uniforms", CommandStage::CONTEXT, [](const std::vector<std::string>& args, const CommandScene& scene)
+		{
+			benchmarkUniforms(scene.context, getCount(args, 10000));
+			return true;
+		} },
+	{ "--bench-pipelines", CommandStage::CONTEXT, [](const std::vector<std::string>&, const CommandScene& scene)
+		{
+			benchmarkPipelines(scene.context);
+			return true;
+		} },
+	{ "--bench-recording", CommandStage::SCENE, [](const std::vector<std::string>& args, const CommandScene& scene)
+		{
+			benchmarkRecording(scene.context, scene.renderer, scene.camera, scene.light, scene.objects, getCount(args, 5000));
+			return true;
+		} },
+	{ "--bench-render-queue", CommandStage::SCENE, [](const std::vector<std::string>& args, const CommandScene& scene)
+		{
+			benchmarkRenderQueue(scene.context, scene.renderer, scene.camera, scene.light, scene.objects, getCount(args, 5000));
+			return true;
+		} }
+};
+
+int main(int argc, char** argv)
 {
+	const Command* command = nullptr;
+	std::vector<std::string> commandArgs;
+	if (argc > 1)
+	{
+		for (const auto& candidate : commands)
+			if (std::strcmp(argv[1], candidate.flag) == 0)
+				command = &candidate;
+		for (int i = 2; command && i < argc && argv[i][0] != '-'; ++i)
+			commandArgs.push_back(argv[i]);
+	}
+	CommandScene commandScene;
+	if (command && command->stage == CommandStage::NONE)
+		return command->run(commandArgs, commandScene) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	//no window, surface or presentation, frames go to offscreen targets. Combines with the benchmarks below.
+	//Builds without glfw and imgui have no window, every run there is headless
+#ifdef MY_VULKAN_HEADLESS_ONLY
+	bool headless = true;
+#else
+	bool headless = false;
+#endif
+	uint32_t headlessFrames = 300;
+	std::string capturePath;
+	//records every profiler scope from the first frame and writes a chrome://tracing json at exit
+	std::string tracePath;
+	bool cpuDraws = false;
+	uint32_t particleCount = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			headlessFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			capturePath = argv[++i];
+		else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			tracePath = argv[++i];
+		//record every draw on the cpu even when the device could cull and draw on the gpu
+		else if (std::strcmp(argv[i], "--cpu-draws") == 0)
+			cpuDraws = true;
+		//the particle system is left out unless asked for, --particles [count] with PARTICLE_COUNT when no count follows
+		else if (std::strcmp(argv[i], "--particles") == 0)
+			particleCount = i + 1 < argc && argv[i + 1][0] != '-' ? static_cast<uint32_t>(std::stoul(argv[++i])) : my_vulkan::PARTICLE_COUNT;
+	}
+
 	std::cout << sizeof(my_vulkan::FragmentUniformBufferObject) << std::endl;
-	std::shared_ptr<my_vulkan::VulkanContext> context = std::make_shared<my_vulkan::VulkanContext>();
+	std::shared_ptr<my_vulkan::VulkanContext> context = std::make_shared<my_vulkan::VulkanContext>(headless);
+	if (!tracePath.empty())
+		context->profiler->setTracing(true);
+	commandScene.context = context.get();
+	if (command && command->stage == CommandStage::CONTEXT)
+		return command->run(commandArgs, commandScene) ? EXIT_SUCCESS : EXIT_FAILURE;
 	std::shared_ptr<my_vulkan::VulkanRenderer> renderer = std::make_shared<my_vulkan::VulkanRenderer>(context.get());
-	std::shared_ptr<my_vulkan::ImguiAPI> imgui = std::make_shared<my_vulkan::ImguiAPI>(context.get());
+	if (cpuDraws)
+		renderer->setIndirectDraws(false);
+#ifndef MY_VULKAN_HEADLESS_ONLY
+	std::shared_ptr<my_vulkan::ImguiAPI> imgui = headless ? nullptr : std::make_shared<my_vulkan::ImguiAPI>(context.get());
+#endif
 	auto fov = glm::radians(70.0f);
 	auto as = 1920.0f / 1080.0f;
 	auto pos = glm::vec3(3.0f, 3.0f, 3.0f);
@@ -71,10 +481,41 @@ int main()
 	std::vector<my_vulkan::Object*> objects;
 
 	std::shared_ptr<my_vulkan::Camera> camera = std::make_shared<my_vulkan::Camera>(fov, as, pos, rot, my_vulkan::CameraType::FIRST_PERSON);
-	std::shared_ptr<my_vulkan::Arona> arona = std::make_shared<my_vulkan::Arona>("Arona", context.get(), aronaModelPaths, aronaTexturePaths);
+	auto loadStart = std::chrono::high_resolution_clock::now();
+	bool aronaCombined = std::filesystem::exists(aronaCombinedModelPath);
+	std::vector<std::string> aronaModels = aronaCombined ? std::vector<std::string>{ aronaCombinedModelPath } : aronaModelPaths;
+	//the combined model takes its textures from the materials
+	std::vector<std::string> aronaTextures = aronaCombined ? std::vector<std::string>{} : aronaTexturePaths;
+	//start decoding every object's assets up front so the workers are busy while the first object is uploaded
+	context->assetLoader->prefetch(aronaModels, aronaTextures);
+	context->assetLoader->prefetch(mariModelPaths, mariTexturePaths);
+	context->assetLoader->prefetch(planeModelPaths, planeTexturePaths);
+	context->assetLoader->prefetch(lightModelPaths, lightTexturePaths);
+
+	//half the vertex memory and bandwidth, drawn with the compressed pipeline when the device is bindless
+	std::shared_ptr<my_vulkan::Arona> arona = std::make_shared<my_vulkan::Arona>("Arona", context.get(), aronaModels, aronaTextures,
+		my_vulkan::VertexFormat::COMPRESSED);
 	std::shared_ptr<my_vulkan::Arona> mari = std::make_shared<my_vulkan::Arona>("Mari", context.get(), mariModelPaths, mariTexturePaths);
 	std::shared_ptr<my_vulkan::Arona> plane = std::make_shared<my_vulkan::Arona>("Plane", context.get(), planeModelPaths, planeTexturePaths);
 	std::shared_ptr<my_vulkan::PointLight> light = std::make_shared<my_vulkan::PointLight>("Light", context.get(), lightModelPaths, lightTexturePaths);
+	//a field of light markers, the mesh is shared with the light and every marker is drawn by the same call
+	std::shared_ptr<my_vulkan::InstancedObject> lightMarkers = std::make_shared<my_vulkan::InstancedObject>("LightMarkers", context.get(),
+		lightModelPaths, lightTexturePaths);
+	for (int x = -16; x != 16; ++x)
+		for (int z = -16; z != 16; ++z)
+			lightMarkers->addInstance(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(x * 0.5f + 0.25f, 2.0f, z * 0.5f + 0.25f)),
+				glm::vec3(0.05f)));
+	context->uploader->waitIdle();
+	const my_vulkan::VulkanUploaderStats& uploadStats = context->uploader->getStats();
+	std::cout << "scene loaded in " << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count()
+		<< " ms, " << uploadStats.uploadCount << " uploads (" << uploadStats.uploadBytes / 1024 << " KB) in " << uploadStats.batchCount
+		<< " batches, " << uploadStats.submitTime << " ms submitting, staging ring peak " << uploadStats.peakRingUsed / 1024 << " / "
+		<< my_vulkan::VulkanUploader::STAGING_RING_SIZE / 1024 << " KB" << std::endl;
+	my_vulkan::VulkanAllocatorStats memoryStats = context->device->getAllocator()->getStats();
+	std::cout << "gpu memory: " << memoryStats.bytesUsed / 1024 << " KB used of " << memoryStats.bytesReserved / 1024 << " KB reserved in "
+		<< memoryStats.blockCount << " blocks and " << memoryStats.dedicatedAllocationCount << " dedicated allocations" << std::endl;
+	std::cout << context->meshRegistry->getMeshCount() << " unique meshes, " << context->meshRegistry->getSharedCount()
+		<< " shared by content, " << lightMarkers->getInstanceCount() << " marker instances" << std::endl;
 
 	objects.push_back(arona.get());
 	objects.push_back(mari.get());
@@ -88,9 +529,33 @@ int main()
 	plane->setPosition(glm::vec3{ 0.0f, 0.0f, 0.0f });
 	plane->setRotation(glm::vec3{ 0.0f, 0.0f, 90.0f });
 	plane->setScale(glm::vec3{ 10.0f,10.0f, 10.0f });
+	//the floor is seen from both sides, its variant builds in the background and it draws single sided until then
+	my_vulkan::PipelineDesc doubleSided = context->graphicsPipeline->getMeshPipelineDesc();
+	doubleSided.cullMode = VK_CULL_MODE_NONE;
+	plane->pipelineKey = context->pipelineManager->request(doubleSided);
 
 	light->setIntensity(50.0f);
 
+	if (command && command->stage == CommandStage::SCENE)
+	{
+		commandScene.renderer = renderer.get();
+		commandScene.camera = camera.get();
+		commandScene.light = light.get();
+		commandScene.objects = { arona, light, mari, plane, lightMarkers };
+		return command->run(commandArgs, commandScene) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	context->createParticleSystem(particleCount);
+
+	if (headless)
+	{
+		runHeadless(context.get(), renderer.get(), camera.get(), light.get(), { arona, light, mari, plane, lightMarkers }, headlessFrames, capturePath);
+		if (!tracePath.empty())
+			context->profiler->writeChromeTrace(tracePath);
+		return EXIT_SUCCESS;
+	}
+
+#ifndef MY_VULKAN_HEADLESS_ONLY
 	try
 	{
 		while (!glfwWindowShouldClose(context->wind.window))
@@ -98,19 +563,27 @@ int main()
 			glfwPollEvents();
 
 			imgui->handleInput(context.get(), camera.get());
-			arona->tick(renderer->getCurrentFrame(), camera.get(), light.get());
-			light->tick(renderer->getCurrentFrame(), camera.get(), light.get());
-			mari->tick(renderer->getCurrentFrame(), camera.get(), light.get());
-			plane->tick(renderer->getCurrentFrame(), camera.get(), light.get());
-			renderer->draw( context.get(), imgui.get(), {arona, light, mari, plane});
+			renderer->beginFrame(context.get(), camera.get(), light.get());
+			{
+				my_vulkan::ProfileScope scope(context->profiler.get(), "tick");
+				arona->tick(renderer->getCurrentFrame(), camera.get(), light.get());
+				light->tick(renderer->getCurrentFrame(), camera.get(), light.get());
+				mari->tick(renderer->getCurrentFrame(), camera.get(), light.get());
+				plane->tick(renderer->getCurrentFrame(), camera.get(), light.get());
+				lightMarkers->tick(renderer->getCurrentFrame(), camera.get(), light.get());
+			}
+			renderer->draw( context.get(), imgui.get(), {arona, light, mari, plane, lightMarkers});
 		}
 	}
 	catch (std::exception e)
 	{
 		std::cout << e.what() << std::endl;
 	}
+	if (!tracePath.empty())
+		context->profiler->writeChromeTrace(tracePath);
 
 	system("pause");
+#endif
 	return EXIT_SUCCESS;
 }
 
@@ -1,3 +1,14 @@
 D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe shader.vert -o vert.spv
 D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe shader.frag -o frag.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS --target-env=vulkan1.2 shader.vert -o vert_bindless.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS --target-env=vulkan1.2 shader.frag -o frag_bindless.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DINSTANCED shader.vert -o vert_instanced.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS -DINSTANCED --target-env=vulkan1.2 shader.vert -o vert_bindless_instanced.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS -DCOMPRESSED --target-env=vulkan1.2 shader.vert -o vert_bindless_compressed.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS -DINDIRECT --target-env=vulkan1.2 shader.vert -o vert_indirect.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe -DBINDLESS -DINDIRECT --target-env=vulkan1.2 shader.frag -o frag_indirect.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe cull.comp -o cull.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe particle.comp -o particle.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe particle.vert -o particle_vert.spv
+D:\VulkanTutorial\Libraries\VulkanSDK\Bin\glslc.exe particle.frag -o particle_frag.spv
 pause
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 450
+
+layout(location = 0) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main(){
+    // round sprites with a soft edge
+    vec2 offset = gl_PointCoord * 2.0 - 1.0;
+    float distanceSquared = dot(offset, offset);
+    if (distanceSquared > 1.0)
+        discard;
+    outColor = vec4(fragColor.rgb, fragColor.a * (1.0 - distanceSquared));
+}
@@ -0,0 +1,18 @@
+#version 450
+
+// Must match ParticleSystem::DrawPushConstants
+layout(push_constant) uniform DrawPushConstants{
+    mat4 viewProjection;
+    float pointSize;
+} draw;
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+
+void main(){
+    gl_Position = draw.viewProjection * vec4(inPosition.xyz, 1.0);
+    gl_PointSize = draw.pointSize;
+    fragColor = inColor;
+}
@@ -2,14 +2,29 @@
 //#extension GL_KHR_vulkan_glsl : enable
 #extension GL_EXT_debug_printf : enable
 #extension GL_EXT_spirv_intrinsics : enable
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 layout(location = 0)  in vec2 fragTexCoord;
 layout(location = 1)  in vec3 fragNormal;
 layout(location = 2)  in vec3 fragPos;
+#ifdef INDIRECT
+layout(location = 3) flat in uint fragTextureIndex;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
+#ifdef BINDLESS
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform MeshPushConstants{
+    mat4 model;
+    uint textureIndex;
+} mesh;
+#else
 layout(set = 1, binding = 0) uniform sampler2D texSampler;
+#endif
 
 layout(set = 2, binding = 0) uniform UniformBufferObject{
     	vec3 ks;
@@ -21,7 +36,13 @@ layout(set = 2, binding = 0) uniform UniformBufferObject{
 void main()
 {
 
+#if defined(INDIRECT)
+    vec3 color = texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord).rgb;
+#elif defined(BINDLESS)
+    vec3 color = texture(textures[mesh.textureIndex], fragTexCoord).rgb;
+#else
     vec3 color = texture(texSampler, fragTexCoord).rgb;
+#endif
 
 //    debugPrintfEXT("cameraPos is %v3f", ubo.cameraPos);
 //    debugPrintfEXT("lightPos is %v3f", ubo.lightPos);
@@ -2,13 +2,25 @@
 //#extension GL_KHR_vulkan_glsl : enable
 
 
+// COMPRESSED reads CompressedVertex: the position arrives as unorm16 in [0, 1] of the mesh bounds and the model matrix
+// carries the quantization, texCoord is a half float pair and the normal is octahedral encoded in two snorm16
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inTexCoord;
+#ifdef COMPRESSED
+layout(location = 2) in vec2 inNormal;
+#else
 layout(location = 2) in vec3 inNormal;
+#endif
+#ifdef INSTANCED
+layout(location = 3) in mat4 inModel;
+#endif
 
 layout(location = 0) out vec2 fragTexCoord;
 layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec3 fragPos;
+#ifdef INDIRECT
+layout(location = 3) flat out uint fragTextureIndex;
+#endif
 
 layout(set = 0, binding = 0) uniform UniformBufferObject{
     vec2 foo;
@@ -17,12 +29,64 @@ layout(set = 0, binding = 0) uniform UniformBufferObject{
     mat4 proj;
 } ubo;
 
+#ifdef BINDLESS
+// One frame-wide ubo (model unused), the object's model matrix comes with the draw
+layout(push_constant) uniform MeshPushConstants{
+    mat4 model;
+    uint textureIndex;
+} mesh;
+#endif
+
+#ifdef INDIRECT
+// Written by VulkanIndirectDraws, the culling pass stores the draw's index in firstInstance
+struct DrawObject{
+    mat4 model;
+    vec4 boundingSphere;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint textureIndex;
+    uint geometryPage;
+};
+
+layout(std430, set = 3, binding = 0) readonly buffer DrawObjects{
+    DrawObject draws[];
+};
+#endif
+
+#if defined(INDIRECT)
+#define MODEL draws[gl_InstanceIndex].model
+#elif defined(INSTANCED)
+// Every instance carries its full model matrix, the object's own transform is already applied
+#define MODEL inModel
+#elif defined(BINDLESS)
+#define MODEL mesh.model
+#else
+#define MODEL ubo.model
+#endif
+
+#ifdef COMPRESSED
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+#define NORMAL decodeOctahedral(inNormal)
+#else
+#define NORMAL inNormal
+#endif
+
 void main()
 {
-    vec4 worldPosition = ubo.model * vec4(inPosition, 1.0);
+    vec4 worldPosition = MODEL * vec4(inPosition, 1.0);
     gl_Position = ubo.proj * ubo.view * worldPosition;
 
     fragTexCoord = inTexCoord;
-    fragNormal = mat3(transpose(inverse(ubo.model))) * inNormal; // Transform normal to world space
+    fragNormal = mat3(transpose(inverse(MODEL))) * NORMAL; // Transform normal to world space
     fragPos = worldPosition.xyz; // Pass world-space position to fragment shader
+#ifdef INDIRECT
+    fragTextureIndex = draws[gl_InstanceIndex].textureIndex;
+#endif
 }